@@ -0,0 +1,78 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace
+{
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> usable_bytes{0};
+
+    void *allocate(std::size_t size, std::size_t alignment)
+    {
+        if (size == 0)
+            size = 1;
+
+        void *p = nullptr;
+        if (alignment <= alignof(std::max_align_t))
+            p = std::malloc(size);
+        else if (posix_memalign(&p, alignment, size) != 0)
+            p = nullptr;
+        if (p == nullptr)
+            throw std::bad_alloc();
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        usable_bytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+        return p;
+    }
+
+    void release(void *p)
+    {
+        if (p == nullptr)
+            return;
+        deallocations.fetch_add(1, std::memory_order_relaxed);
+        std::free(p);
+    }
+}
+
+AllocStats AllocCounter::total()
+{
+    return {allocations.load(std::memory_order_relaxed), deallocations.load(std::memory_order_relaxed),
+            bytes.load(std::memory_order_relaxed), usable_bytes.load(std::memory_order_relaxed)};
+}
+
+void *operator new(std::size_t size) { return allocate(size, 0); }
+void *operator new[](std::size_t size) { return allocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, static_cast<std::size_t>(alignment)); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocate(size, static_cast<std::size_t>(alignment)); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return allocate(size, 0);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
@@ -0,0 +1,54 @@
+#ifndef __ALLOC_COUNTER_H__
+#define __ALLOC_COUNTER_H__
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Heap activity counted by the replaced global operator new/delete.
+ */
+struct AllocStats
+{
+    std::uint64_t allocations;   /**< Calls to operator new */
+    std::uint64_t deallocations; /**< Calls to operator delete with a non-null pointer */
+    std::uint64_t bytes;         /**< Bytes requested from operator new */
+    std::uint64_t usable_bytes;  /**< Usable size of the returned blocks, malloc rounding included */
+
+    AllocStats operator-(const AllocStats &other) const
+    {
+        return {allocations - other.allocations, deallocations - other.deallocations, bytes - other.bytes,
+                usable_bytes - other.usable_bytes};
+    }
+};
+
+/**
+ * @brief Counters of every operator new/delete in the program.
+ *
+ * Linking alloc_counter.cpp into an executable replaces the global
+ * allocation functions with counting versions forwarding to malloc/free.
+ * Only link it into dedicated benchmark and test executables.
+ */
+struct AllocCounter
+{
+    /**
+     * @brief Totals since program start, all threads.
+     */
+    static AllocStats total();
+};
+
+/**
+ * @brief Measures the heap activity between its construction and a call
+ * to stats().
+ */
+class AllocScope
+{
+public:
+    AllocScope() : m_start(AllocCounter::total()) {}
+
+    AllocStats stats() const { return AllocCounter::total() - m_start; }
+
+private:
+    AllocStats m_start; /**< Totals at construction */
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "arrival.h"
+#include "record.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+
+namespace
+{
+    constexpr double kPi = 3.14159265358979323846;
+
+    /**
+     * @brief Splits "name:a:b" into its fields.
+     */
+    std::vector<std::string> split(const std::string &spec)
+    {
+        std::vector<std::string> fields;
+        std::size_t begin = 0;
+        for (;;)
+        {
+            std::size_t end = spec.find(':', begin);
+            fields.push_back(spec.substr(begin, end - begin));
+            if (end == std::string::npos)
+                return fields;
+            begin = end + 1;
+        }
+    }
+
+    double number(const std::string &spec, const std::string &field)
+    {
+        char *end = nullptr;
+        double value = std::strtod(field.c_str(), &end);
+        if (field.empty() || *end != '\0' || !(value >= 0))
+            throw std::invalid_argument("invalid number '" + field + "' in '" + spec + "'");
+        return value;
+    }
+
+    void expectFields(const std::string &spec, const std::vector<std::string> &fields, std::size_t count)
+    {
+        if (fields.size() != count)
+            throw std::invalid_argument("wrong number of fields in '" + spec + "'");
+    }
+
+    double positive(const std::string &spec, const std::string &field)
+    {
+        double value = number(spec, field);
+        if (value <= 0)
+            throw std::invalid_argument("'" + field + "' must be positive in '" + spec + "'");
+        return value;
+    }
+
+    std::uint64_t toNs(double time) { return static_cast<std::uint64_t>(time); }
+}
+
+double WorkloadRng::exponential(double mean) { return -mean * std::log(uniform()); }
+
+double WorkloadRng::pareto(double scale, double shape) { return scale / std::pow(uniform(), 1.0 / shape); }
+
+std::uint64_t WorkloadRng::streamSeed(std::uint64_t seed, std::uint64_t index)
+{
+    // splitmix64 finalizer, neighbouring indices give unrelated seeds
+    std::uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+ConstantArrivals::ConstantArrivals(double rate, std::uint64_t phase)
+    : m_interval(1e9 / rate), m_time(static_cast<double>(phase))
+{
+}
+
+std::uint64_t ConstantArrivals::nextArrival()
+{
+    std::uint64_t time = toNs(m_time);
+    m_time += m_interval;
+    return time;
+}
+
+PoissonArrivals::PoissonArrivals(double rate, std::uint64_t seed) : m_rng(seed), m_mean(1e9 / rate), m_time() {}
+
+std::uint64_t PoissonArrivals::nextArrival()
+{
+    m_time += m_rng.exponential(m_mean);
+    return toNs(m_time);
+}
+
+OnOffArrivals::OnOffArrivals(double rate, std::uint64_t on_ns, std::uint64_t off_ns, std::uint64_t seed)
+    : m_rng(seed), m_mean(1e9 / rate), m_on(static_cast<double>(on_ns)),
+      m_period(static_cast<double>(on_ns + off_ns)), m_time()
+{
+}
+
+std::uint64_t OnOffArrivals::nextArrival()
+{
+    // the gap is drawn in on time only: arrivals that would fall into an
+    // off period continue at the start of the next on period
+    double gap = m_rng.exponential(m_mean);
+    for (;;)
+    {
+        double phase = std::fmod(m_time, m_period);
+        double left = m_on - phase;
+        if (gap < left)
+        {
+            m_time += gap;
+            return toNs(m_time);
+        }
+        gap -= std::max(left, 0.0);
+        m_time += m_period - phase;
+    }
+}
+
+DiurnalArrivals::DiurnalArrivals(double rate, double amplitude, std::uint64_t period_ns, std::uint64_t seed)
+    : m_rng(seed), m_rate(rate / 1e9), m_amplitude(std::min(amplitude, 1.0)),
+      m_period(static_cast<double>(period_ns)), m_time()
+{
+}
+
+std::uint64_t DiurnalArrivals::nextArrival()
+{
+    double peak = m_rate * (1 + m_amplitude);
+    for (;;)
+    {
+        m_time += m_rng.exponential(1 / peak);
+        double rate = m_rate * (1 + m_amplitude * std::sin(2 * kPi * m_time / m_period));
+        if (m_rng.uniform() * peak <= rate)
+            return toNs(m_time);
+    }
+}
+
+TraceArrivals::TraceArrivals(std::vector<std::uint64_t> times, std::size_t index, std::size_t stride)
+    : m_times(std::move(times)), m_length(), m_next(index), m_stride(stride), m_offset()
+{
+    // a rate needs at least one gap between two distinct times
+    if (m_times.size() < 2)
+        throw std::invalid_argument("TraceArrivals: trace needs at least two arrivals");
+    if (m_times.size() <= index)
+        throw std::invalid_argument("TraceArrivals: trace too short for the number of producers");
+
+    std::uint64_t origin = m_times.front();
+    for (auto &time : m_times)
+        time -= origin;
+    if (m_times.back() == 0)
+        throw std::invalid_argument("TraceArrivals: trace arrivals all at the same time");
+    // repeat one mean gap after the last arrival
+    m_length = m_times.back() + m_times.back() / (m_times.size() - 1);
+}
+
+std::vector<std::uint64_t> TraceArrivals::loadRecorded(const std::string &path)
+{
+    std::vector<OpRecord> records = OpRecorder::readLog(path);
+
+    std::map<std::uint64_t, std::size_t> pushes;
+    for (const OpRecord &record : records)
+        if (record.op != RecordOp::Pop)
+            pushes[record.queue]++;
+    if (pushes.empty())
+        throw std::invalid_argument("TraceArrivals: no push in " + path);
+
+    std::uint64_t busiest = std::max_element(pushes.begin(), pushes.end(), [](const auto &a, const auto &b)
+                                             { return a.second < b.second; })
+                                ->first;
+    std::vector<std::uint64_t> times;
+    for (const OpRecord &record : records)
+        if (record.op != RecordOp::Pop && record.queue == busiest)
+            times.push_back(record.timestamp);
+    return times;
+}
+
+std::uint64_t TraceArrivals::nextArrival()
+{
+    while (m_next >= m_times.size())
+    {
+        m_next -= m_times.size();
+        m_offset += m_length;
+    }
+    std::uint64_t time = m_offset + m_times[m_next];
+    m_next += m_stride;
+    return time;
+}
+
+DistributedServiceTime::DistributedServiceTime(Distribution distribution, double mean_ns, double shape,
+                                               std::uint64_t seed)
+    : m_rng(seed), m_distribution(distribution), m_mean(mean_ns), m_shape(shape)
+{
+}
+
+std::uint64_t DistributedServiceTime::next()
+{
+    switch (m_distribution)
+    {
+    case Distribution::Exponential:
+        return toNs(m_rng.exponential(m_mean));
+    case Distribution::Pareto:
+        return toNs(m_rng.pareto(m_mean * (m_shape - 1) / m_shape, m_shape));
+    default:
+        return toNs(m_mean);
+    }
+}
+
+std::unique_ptr<ArrivalProcess> makeArrivals(const std::string &spec, std::uint64_t seed, int index, int producers)
+{
+    std::vector<std::string> fields = split(spec);
+    const std::string &kind = fields[0];
+    std::uint64_t stream = WorkloadRng::streamSeed(seed, static_cast<std::uint64_t>(index));
+
+    if (kind == "trace")
+    {
+        expectFields(spec, fields, 2);
+        return std::make_unique<TraceArrivals>(TraceArrivals::loadRecorded(fields[1]), index, producers);
+    }
+
+    if (fields.size() < 2)
+        throw std::invalid_argument("missing rate in '" + spec + "'");
+    double rate = positive(spec, fields[1]) / producers;
+
+    if (kind == "constant")
+    {
+        expectFields(spec, fields, 2);
+        // producers take turns, evenly spaced
+        return std::make_unique<ConstantArrivals>(rate, static_cast<std::uint64_t>(1e9 / rate * index / producers));
+    }
+    if (kind == "poisson")
+    {
+        expectFields(spec, fields, 2);
+        return std::make_unique<PoissonArrivals>(rate, stream);
+    }
+    if (kind == "onoff")
+    {
+        expectFields(spec, fields, 4);
+        return std::make_unique<OnOffArrivals>(rate, toNs(positive(spec, fields[2]) * 1e6),
+                                               toNs(number(spec, fields[3]) * 1e6), stream);
+    }
+    if (kind == "diurnal")
+    {
+        expectFields(spec, fields, 4);
+        return std::make_unique<DiurnalArrivals>(rate, number(spec, fields[2]), toNs(positive(spec, fields[3]) * 1e6),
+                                                 stream);
+    }
+    throw std::invalid_argument("unknown arrival process '" + spec + "'");
+}
+
+std::unique_ptr<ServiceTime> makeServiceTime(const std::string &spec, std::uint64_t seed, int index)
+{
+    using Distribution = DistributedServiceTime::Distribution;
+    std::vector<std::string> fields = split(spec);
+    const std::string &kind = fields[0];
+    // consumers draw from streams distinct from the producers
+    std::uint64_t stream = WorkloadRng::streamSeed(~seed, static_cast<std::uint64_t>(index));
+
+    if (kind == "constant" || kind == "exponential")
+    {
+        expectFields(spec, fields, 2);
+        return std::make_unique<DistributedServiceTime>(kind == "constant" ? Distribution::Constant : Distribution::Exponential,
+                                                        number(spec, fields[1]), 0, stream);
+    }
+    if (kind == "pareto")
+    {
+        expectFields(spec, fields, 3);
+        double shape = number(spec, fields[2]);
+        if (shape <= 1)
+            throw std::invalid_argument("Pareto shape must be above 1 in '" + spec + "'");
+        return std::make_unique<DistributedServiceTime>(Distribution::Pareto, number(spec, fields[1]), shape, stream);
+    }
+    throw std::invalid_argument("unknown service time '" + spec + "'");
+}
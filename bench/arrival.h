@@ -0,0 +1,285 @@
+#ifndef __ARRIVAL_H__
+#define __ARRIVAL_H__
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Deterministic random source of the workload generators.
+ *
+ * Built on std::mt19937_64, whose output sequence is fixed by the standard,
+ * and on explicit inverse-CDF transforms instead of the std distributions,
+ * whose algorithms differ between standard libraries. The same seed thus
+ * gives the same traffic on every platform.
+ */
+class WorkloadRng
+{
+public:
+    explicit WorkloadRng(std::uint64_t seed) : m_engine(seed) {}
+
+    /**
+     * @brief Uniform value in the open interval (0, 1).
+     */
+    double uniform() { return (static_cast<double>(m_engine() >> 11) + 0.5) * 0x1.0p-53; }
+
+    /**
+     * @brief Exponentially distributed value.
+     *
+     * @param mean Mean of the distribution.
+     */
+    double exponential(double mean);
+
+    /**
+     * @brief Pareto distributed value, heavy-tailed for shape <= 2.
+     *
+     * @param scale Smallest possible value.
+     * @param shape Tail index, larger is lighter.
+     */
+    double pareto(double scale, double shape);
+
+    /**
+     * @brief Seed of the index-th independent stream derived from a base seed.
+     *
+     * @param seed Base seed of the run.
+     * @param index Stream index, e.g. the producer number.
+     * @return std::uint64_t Seed of the stream.
+     */
+    static std::uint64_t streamSeed(std::uint64_t seed, std::uint64_t index);
+
+private:
+    std::mt19937_64 m_engine; /**< Uniform 64-bit source */
+};
+
+/**
+ * @brief Source of arrival times for one producer.
+ *
+ * Times are nanoseconds since the start of the run and never decrease.
+ * Processes that depend on the time of day (bursts, diurnal load) use the
+ * run start as their phase origin, so all producers burst together.
+ */
+class ArrivalProcess
+{
+public:
+    virtual ~ArrivalProcess() = default;
+
+    /**
+     * @brief Time of the next arrival.
+     *
+     * @return std::uint64_t Nanoseconds since the start of the run.
+     */
+    virtual std::uint64_t nextArrival() = 0;
+};
+
+/**
+ * @brief Arrivals at fixed intervals.
+ */
+class ConstantArrivals : public ArrivalProcess
+{
+public:
+    /**
+     * @param rate Arrivals per second.
+     * @param phase Time of the first arrival in nanoseconds.
+     */
+    explicit ConstantArrivals(double rate, std::uint64_t phase = 0);
+
+    std::uint64_t nextArrival() override;
+
+private:
+    double m_interval; /**< Nanoseconds between arrivals */
+    double m_time;     /**< Time of the next arrival */
+};
+
+/**
+ * @brief Poisson arrivals, i.e. exponential gaps.
+ */
+class PoissonArrivals : public ArrivalProcess
+{
+public:
+    /**
+     * @param rate Mean arrivals per second.
+     * @param seed Seed of the random stream.
+     */
+    PoissonArrivals(double rate, std::uint64_t seed);
+
+    std::uint64_t nextArrival() override;
+
+private:
+    WorkloadRng m_rng; /**< Random stream */
+    double m_mean;     /**< Mean gap in nanoseconds */
+    double m_time;     /**< Time of the last arrival */
+};
+
+/**
+ * @brief Poisson bursts during on periods separated by silent off periods.
+ *
+ * E.g. 50 ms bursts every second fill a queue that keeps up with the mean
+ * rate easily.
+ */
+class OnOffArrivals : public ArrivalProcess
+{
+public:
+    /**
+     * @param rate Mean arrivals per second during on periods.
+     * @param on_ns Length of an on period in nanoseconds.
+     * @param off_ns Length of an off period in nanoseconds.
+     * @param seed Seed of the random stream.
+     */
+    OnOffArrivals(double rate, std::uint64_t on_ns, std::uint64_t off_ns, std::uint64_t seed);
+
+    std::uint64_t nextArrival() override;
+
+private:
+    WorkloadRng m_rng;    /**< Random stream */
+    double m_mean;        /**< Mean gap during on periods in nanoseconds */
+    double m_on;          /**< Length of an on period */
+    double m_period;      /**< Length of an on period plus an off period */
+    double m_time;        /**< Time of the last arrival */
+};
+
+/**
+ * @brief Poisson arrivals whose rate follows a sine wave, a compressed day.
+ *
+ * Generated by thinning: candidates at the peak rate are kept with
+ * probability rate(t) / peak.
+ */
+class DiurnalArrivals : public ArrivalProcess
+{
+public:
+    /**
+     * @param rate Mean arrivals per second over a period.
+     * @param amplitude Relative swing in [0, 1], the rate goes from
+     * rate * (1 - amplitude) to rate * (1 + amplitude).
+     * @param period_ns Length of a period in nanoseconds.
+     * @param seed Seed of the random stream.
+     */
+    DiurnalArrivals(double rate, double amplitude, std::uint64_t period_ns, std::uint64_t seed);
+
+    std::uint64_t nextArrival() override;
+
+private:
+    WorkloadRng m_rng;  /**< Random stream */
+    double m_rate;      /**< Mean rate in arrivals per nanosecond */
+    double m_amplitude; /**< Relative swing */
+    double m_period;    /**< Length of a period in nanoseconds */
+    double m_time;      /**< Time of the last candidate */
+};
+
+/**
+ * @brief Arrivals taken from a recorded trace.
+ *
+ * The trace is shifted to start at zero and split over the producers
+ * round-robin; after its end it repeats, shifted by its length.
+ */
+class TraceArrivals : public ArrivalProcess
+{
+public:
+    /**
+     * @param times Arrival times in nanoseconds, any origin, sorted.
+     * @param index Producer number.
+     * @param stride Number of producers sharing the trace.
+     *
+     * @throws std::invalid_argument If the trace has fewer than two arrivals
+     * or spans no time, or if the producer gets no arrival.
+     */
+    TraceArrivals(std::vector<std::uint64_t> times, std::size_t index, std::size_t stride);
+
+    /**
+     * @brief Reads the push times of the busiest queue of an OpRecorder log.
+     *
+     * @param path Log file.
+     * @return std::vector<std::uint64_t> Push and overwrite times, sorted.
+     */
+    static std::vector<std::uint64_t> loadRecorded(const std::string &path);
+
+    std::uint64_t nextArrival() override;
+
+private:
+    std::vector<std::uint64_t> m_times; /**< Trace shifted to start at zero */
+    std::uint64_t m_length;             /**< Repeat period of the trace */
+    std::size_t m_next;                 /**< Index of the next arrival */
+    std::size_t m_stride;               /**< Number of producers sharing the trace */
+    std::uint64_t m_offset;             /**< Shift of the current repetition */
+};
+
+/**
+ * @brief Source of per-element service times, the work a consumer does.
+ */
+class ServiceTime
+{
+public:
+    virtual ~ServiceTime() = default;
+
+    /**
+     * @brief Service time of the next element.
+     *
+     * @return std::uint64_t Nanoseconds.
+     */
+    virtual std::uint64_t next() = 0;
+};
+
+/**
+ * @brief Service times from a constant, exponential or Pareto distribution.
+ */
+class DistributedServiceTime : public ServiceTime
+{
+public:
+    enum class Distribution
+    {
+        Constant,    ///< Always the mean.
+        Exponential, ///< Memoryless around the mean.
+        Pareto       ///< Heavy-tailed with the given mean.
+    };
+
+    /**
+     * @param distribution Shape of the distribution.
+     * @param mean_ns Mean service time in nanoseconds.
+     * @param shape Pareto tail index, must be above 1 for a finite mean.
+     * @param seed Seed of the random stream.
+     */
+    DistributedServiceTime(Distribution distribution, double mean_ns, double shape, std::uint64_t seed);
+
+    std::uint64_t next() override;
+
+private:
+    WorkloadRng m_rng;            /**< Random stream */
+    Distribution m_distribution;  /**< Shape of the distribution */
+    double m_mean;                /**< Mean in nanoseconds */
+    double m_shape;               /**< Pareto tail index */
+};
+
+/**
+ * @brief Builds the arrival process of one producer from a specification.
+ *
+ * Rates are totals over all producers, each producer gets its share:
+ * `constant:RATE`, `poisson:RATE`, `onoff:RATE:ON_MS:OFF_MS` (RATE during
+ * bursts), `diurnal:RATE:AMPLITUDE:PERIOD_MS` or `trace:LOG` (an OpRecorder
+ * log).
+ *
+ * @param spec Specification.
+ * @param seed Seed of the run.
+ * @param index Producer number.
+ * @param producers Number of producers.
+ * @return std::unique_ptr<ArrivalProcess> The process.
+ *
+ * @throws std::invalid_argument If the specification is malformed.
+ */
+std::unique_ptr<ArrivalProcess> makeArrivals(const std::string &spec, std::uint64_t seed, int index, int producers);
+
+/**
+ * @brief Builds the service time source of one consumer from a specification.
+ *
+ * `constant:NS`, `exponential:MEAN_NS` or `pareto:MEAN_NS:SHAPE`.
+ *
+ * @param spec Specification.
+ * @param seed Seed of the run.
+ * @param index Consumer number.
+ * @return std::unique_ptr<ServiceTime> The source.
+ *
+ * @throws std::invalid_argument If the specification is malformed.
+ */
+std::unique_ptr<ServiceTime> makeServiceTime(const std::string &spec, std::uint64_t seed, int index);
+
+#endif
@@ -0,0 +1,110 @@
+#include "compare_stats.h"
+#include "arrival.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+double median(std::vector<double> samples)
+{
+    if (samples.empty())
+        return 0;
+
+    std::size_t mid = samples.size() / 2;
+    std::nth_element(samples.begin(), samples.begin() + mid, samples.end());
+    double upper = samples[mid];
+    if (samples.size() % 2 != 0)
+        return upper;
+    double lower = *std::max_element(samples.begin(), samples.begin() + mid);
+    return (lower + upper) / 2;
+}
+
+Interval bootstrapChange(const std::vector<double> &baseline, const std::vector<double> &candidate,
+                         double confidence, int resamples, std::uint64_t seed)
+{
+    if (baseline.empty() || candidate.empty())
+        throw std::invalid_argument("bootstrapChange: empty sample");
+    if (median(baseline) == 0)
+        throw std::invalid_argument("bootstrapChange: baseline median is 0");
+
+    WorkloadRng rng(seed);
+    auto resample = [&rng](const std::vector<double> &from, std::vector<double> &to)
+    {
+        for (double &value : to)
+            value = from[std::min(from.size() - 1, static_cast<std::size_t>(rng.uniform() * from.size()))];
+    };
+
+    std::vector<double> base(baseline.size());
+    std::vector<double> cand(candidate.size());
+    std::vector<double> changes;
+    changes.reserve(resamples);
+    for (int i = 0; i < resamples; i++)
+    {
+        resample(baseline, base);
+        resample(candidate, cand);
+        double base_median = median(base);
+        // a resample can only have a 0 median if the baseline has zeros
+        if (base_median != 0)
+            changes.push_back(median(cand) / base_median - 1);
+    }
+    std::sort(changes.begin(), changes.end());
+
+    double tail = (1 - confidence) / 2;
+    auto at = [&changes](double fraction)
+    {
+        std::size_t index = static_cast<std::size_t>(fraction * (changes.size() - 1) + 0.5);
+        return changes[std::min(index, changes.size() - 1)];
+    };
+    return {at(tail), at(1 - tail)};
+}
+
+MannWhitney mannWhitneyU(const std::vector<double> &a, const std::vector<double> &b)
+{
+    if (a.empty() || b.empty())
+        throw std::invalid_argument("mannWhitneyU: empty sample");
+
+    // pool both samples, remembering which one each value came from
+    std::vector<std::pair<double, bool>> pooled;
+    pooled.reserve(a.size() + b.size());
+    for (double value : a)
+        pooled.emplace_back(value, true);
+    for (double value : b)
+        pooled.emplace_back(value, false);
+    std::sort(pooled.begin(), pooled.end(),
+              [](const std::pair<double, bool> &x, const std::pair<double, bool> &y)
+              { return x.first < y.first; });
+
+    // average ranks over ties, collecting the tie correction term
+    double rank_sum_a = 0;
+    double ties = 0;
+    for (std::size_t i = 0; i < pooled.size();)
+    {
+        std::size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first)
+            j++;
+        double rank = (i + 1 + j) / 2.0;
+        for (std::size_t k = i; k < j; k++)
+            if (pooled[k].second)
+                rank_sum_a += rank;
+        double t = static_cast<double>(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double n1 = static_cast<double>(a.size());
+    double n2 = static_cast<double>(b.size());
+    double n = n1 + n2;
+    double u = rank_sum_a - n1 * (n1 + 1) / 2;
+
+    double mean = n1 * n2 / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (variance <= 0)
+        return {u, 1.0}; // every value is the same
+
+    // continuity correction towards the mean
+    double z = (std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+    if (z < 0)
+        z = 0;
+    return {u, std::erfc(z / std::sqrt(2.0))};
+}
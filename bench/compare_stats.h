@@ -0,0 +1,63 @@
+#ifndef __COMPARE_STATS_H__
+#define __COMPARE_STATS_H__
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Two-sided confidence interval.
+ */
+struct Interval
+{
+    double low;  /**< Lower bound */
+    double high; /**< Upper bound */
+};
+
+/**
+ * @brief Result of a Mann-Whitney U test.
+ */
+struct MannWhitney
+{
+    double u;       /**< U statistic of the first sample */
+    double p_value; /**< Two-sided p-value, normal approximation with tie correction */
+};
+
+/**
+ * @brief Median of a sample.
+ *
+ * @param samples Values, in any order.
+ * @return double The median, the mean of the two middle values for an even
+ * count, 0 for an empty sample.
+ */
+double median(std::vector<double> samples);
+
+/**
+ * @brief Bootstrap confidence interval of the relative change of the median,
+ * median(candidate) / median(baseline) - 1.
+ *
+ * Both samples are resampled with replacement; the interval is read from the
+ * percentiles of the resampled changes. The result only depends on the seed.
+ *
+ * @param baseline Samples of the reference run.
+ * @param candidate Samples of the run under test.
+ * @param confidence Coverage of the interval, e.g. 0.95.
+ * @param resamples Number of bootstrap resamples.
+ * @param seed Seed of the resampling.
+ *
+ * @throws std::invalid_argument If a sample is empty or the baseline median is 0.
+ */
+Interval bootstrapChange(const std::vector<double> &baseline, const std::vector<double> &candidate,
+                         double confidence = 0.95, int resamples = 2000, std::uint64_t seed = 1);
+
+/**
+ * @brief Mann-Whitney U test of whether two samples come from the same
+ * distribution, robust to the outliers typical of benchmark timings.
+ *
+ * @param a First sample.
+ * @param b Second sample.
+ *
+ * @throws std::invalid_argument If a sample is empty.
+ */
+MannWhitney mannWhitneyU(const std::vector<double> &a, const std::vector<double> &b);
+
+#endif
@@ -0,0 +1,194 @@
+#include "alloc_counter.h"
+#include "compressed_queue.h"
+#include "condition.h"
+#include "queue.h"
+#include "time_series_queue.h"
+#include "window_aggregate.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Memory footprint of one queue per variant and capacity: the size of the
+ * object itself plus the heap it holds, once constructed and once filled to
+ * capacity. Heap use is measured by the counting operator new of
+ * alloc_counter.cpp; "usable" includes malloc rounding.
+ *
+ * usage: memory_bench [--json]
+ */
+
+namespace
+{
+    struct Payload64
+    {
+        std::uint64_t words[8];
+    };
+
+    struct ResidencyTraits : DefaultQueueTraits
+    {
+        static constexpr bool track_residency = true;
+    };
+
+    struct AggregateTraits : DefaultQueueTraits
+    {
+        template <typename T>
+        using observer_type = WindowAggregate<T>;
+    };
+
+    template <typename Condition>
+    struct ConditionTraits : DefaultQueueTraits
+    {
+        using condition_type = Condition;
+    };
+
+    struct Footprint
+    {
+        std::size_t object; /**< sizeof the queue */
+        AllocStats empty;   /**< Heap held after construction */
+        AllocStats full;    /**< Heap held once filled to capacity */
+    };
+
+    /**
+     * @brief Heap allocated by the constructor, then by the constructor and
+     * filling the queue. Nothing is freed before the queue is destroyed.
+     */
+    template <typename QueueT, typename Fill>
+    Footprint measure(int capacity, Fill fillQueue)
+    {
+        Footprint footprint{sizeof(QueueT), {}, {}};
+        AllocScope scope;
+        QueueT queue(capacity);
+        footprint.empty = scope.stats();
+        fillQueue(queue, capacity);
+        footprint.full = scope.stats();
+        return footprint;
+    }
+
+    template <typename T, typename Traits = DefaultQueueTraits>
+    Footprint measureQueue(int capacity)
+    {
+        using QueueT = Queue<T, Traits>;
+        return measure<QueueT>(capacity, [](QueueT &queue, int n)
+                               {
+            for (int i = 0; i < n; i++)
+                queue.push(T{}); });
+    }
+
+    Footprint measureCompressed(int capacity)
+    {
+        using QueueT = CompressedQueue<std::uint64_t>;
+        // a slowly increasing counter, the kind of series the codec is for
+        return measure<QueueT>(capacity, [](QueueT &queue, int n)
+                               {
+            for (int i = 0; i < n; i++)
+                queue.push(static_cast<std::uint64_t>(i)); });
+    }
+
+    Footprint measureTimeSeries(int capacity)
+    {
+        using QueueT = TimeSeriesQueue<int>;
+        return measure<QueueT>(capacity, [](QueueT &queue, int n)
+                               {
+            QueueT::time_point now = QueueT::clock_type::now();
+            for (int i = 0; i < n; i++)
+                queue.push(now, i); });
+    }
+
+    struct Variant
+    {
+        const char *name;
+        std::size_t element_size;
+        Footprint (*run)(int);
+    };
+
+    std::vector<Variant> variants()
+    {
+        return {
+            {"queue<int>", sizeof(int), measureQueue<int>},
+            {"queue<u64>", sizeof(std::uint64_t), measureQueue<std::uint64_t>},
+            {"queue<64B>", sizeof(Payload64), measureQueue<Payload64>},
+            {"queue<int>+residency", sizeof(int), measureQueue<int, ResidencyTraits>},
+            {"queue<int>+aggregate", sizeof(int), measureQueue<int, AggregateTraits>},
+            {"queue<int>+futex", sizeof(int), measureQueue<int, ConditionTraits<FutexCondition>>},
+            {"queue<int>+eventfd", sizeof(int), measureQueue<int, ConditionTraits<EventfdCondition>>},
+            {"time_series<int>", sizeof(int), measureTimeSeries},
+            {"compressed<u64>", sizeof(std::uint64_t), measureCompressed},
+        };
+    }
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr, "usage: %s [--json]\n", name);
+        std::exit(2);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool json = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::string(argv[i]) == "--json")
+            json = true;
+        else
+            usage(argv[0]);
+    }
+
+    const int capacities[] = {1, 16, 1024, 65536};
+
+    if (json)
+        std::printf("{\n  \"context\": {\"executable\": \"%s\", \"sizeof_mutex\": %zu, \"sizeof_condvar\": %zu},\n"
+                    "  \"benchmarks\": [\n",
+                    argv[0], sizeof(std::mutex), sizeof(std::condition_variable));
+    else
+    {
+        std::printf("sizeof(std::mutex) = %zu, sizeof(std::condition_variable) = %zu\n", sizeof(std::mutex),
+                    sizeof(std::condition_variable));
+        std::printf("%-22s %8s %7s %7s %10s %10s %10s %10s %9s\n", "variant", "capacity", "sizeof", "allocs",
+                    "empty B", "usable B", "full B", "usable B", "B/elem");
+    }
+
+    bool first = true;
+    for (const Variant &variant : variants())
+        for (int capacity : capacities)
+        {
+            Footprint footprint = variant.run(capacity);
+            // everything held when full, per element of capacity
+            double per_element =
+                static_cast<double>(footprint.object + footprint.full.usable_bytes) / static_cast<double>(capacity);
+
+            if (json)
+            {
+                std::string name = std::string("memory/") + variant.name + "/" + std::to_string(capacity);
+                std::printf("%s    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                            "\"capacity\": %d, \"element_size\": %zu, \"object_bytes\": %zu, "
+                            "\"allocations\": %llu, \"heap_bytes\": %llu, \"heap_usable_bytes\": %llu, "
+                            "\"full_allocations\": %llu, \"full_heap_bytes\": %llu, \"full_heap_usable_bytes\": %llu, "
+                            "\"bytes_per_element\": %.2f}",
+                            first ? "" : ",\n", name.c_str(), name.c_str(), capacity, variant.element_size,
+                            footprint.object, static_cast<unsigned long long>(footprint.empty.allocations),
+                            static_cast<unsigned long long>(footprint.empty.bytes),
+                            static_cast<unsigned long long>(footprint.empty.usable_bytes),
+                            static_cast<unsigned long long>(footprint.full.allocations),
+                            static_cast<unsigned long long>(footprint.full.bytes),
+                            static_cast<unsigned long long>(footprint.full.usable_bytes), per_element);
+            }
+            else
+                std::printf("%-22s %8d %7zu %7llu %10llu %10llu %10llu %10llu %9.2f\n", variant.name, capacity,
+                            footprint.object, static_cast<unsigned long long>(footprint.full.allocations),
+                            static_cast<unsigned long long>(footprint.empty.bytes),
+                            static_cast<unsigned long long>(footprint.empty.usable_bytes),
+                            static_cast<unsigned long long>(footprint.full.bytes),
+                            static_cast<unsigned long long>(footprint.full.usable_bytes), per_element);
+            first = false;
+        }
+
+    if (json)
+        std::printf("\n  ]\n}\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+    struct EventConfig
+    {
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+
+    const EventConfig kConfigs[PerfSample::kEvents] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+    };
+
+    int openEvent(const EventConfig &event, bool exclude_kernel)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = exclude_kernel ? 1 : 0;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // calling thread, any CPU
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+}
+
+PerfCounters::PerfCounters()
+{
+    for (int &fd : m_fds)
+        fd = -1;
+
+#ifdef __linux__
+    for (int i = 0; i < PerfSample::kEvents; i++)
+    {
+        m_fds[i] = openEvent(kConfigs[i], false);
+        if (m_fds[i] < 0 && (errno == EACCES || errno == EPERM))
+            m_fds[i] = openEvent(kConfigs[i], true);
+        if (m_fds[i] < 0 && m_error.empty())
+            m_error = std::string(name(static_cast<PerfEvent>(i))) + ": perf_event_open: " + std::strerror(errno);
+    }
+#else
+    m_error = "perf_event_open is only available on Linux";
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+    for (int fd : m_fds)
+        if (fd >= 0)
+            ::close(fd);
+#endif
+}
+
+void PerfCounters::start()
+{
+#ifdef __linux__
+    for (int fd : m_fds)
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+}
+
+PerfSample PerfCounters::stop()
+{
+    PerfSample sample{};
+#ifdef __linux__
+    for (int i = 0; i < PerfSample::kEvents; i++)
+    {
+        if (m_fds[i] < 0)
+            continue;
+        ::ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        // value, time enabled, time running
+        std::uint64_t data[3];
+        if (::read(m_fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0)
+            continue;
+
+        // the kernel multiplexes counters when there are more events than
+        // hardware counters, extrapolate to the whole enabled time
+        double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        sample.value[i] = static_cast<std::uint64_t>(static_cast<double>(data[0]) * scale);
+        sample.valid[i] = true;
+    }
+#endif
+    return sample;
+}
+
+bool PerfCounters::available() const
+{
+    for (int fd : m_fds)
+        if (fd >= 0)
+            return true;
+    return false;
+}
+
+const char *PerfCounters::name(PerfEvent event)
+{
+    switch (event)
+    {
+    case PerfEvent::Cycles:
+        return "cycles";
+    case PerfEvent::Instructions:
+        return "instructions";
+    case PerfEvent::CacheMisses:
+        return "cache_misses";
+    case PerfEvent::LlcMisses:
+        return "llc_misses";
+    case PerfEvent::ContextSwitches:
+        return "context_switches";
+    default:
+        return "unknown";
+    }
+}
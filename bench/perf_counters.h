@@ -0,0 +1,102 @@
+#ifndef __PERF_COUNTERS_H__
+#define __PERF_COUNTERS_H__
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Hardware and software events counted by PerfCounters.
+ */
+enum class PerfEvent : int
+{
+    Cycles,          ///< CPU cycles.
+    Instructions,    ///< Retired instructions.
+    CacheMisses,     ///< Cache misses as defined by the CPU, usually last level references.
+    LlcMisses,       ///< Last level cache read misses.
+    ContextSwitches, ///< Context switches (software event).
+    Count            ///< Number of events, not an event.
+};
+
+/**
+ * @brief Values read by PerfCounters::stop().
+ */
+struct PerfSample
+{
+    static constexpr int kEvents = static_cast<int>(PerfEvent::Count);
+
+    bool valid[kEvents];           /**< The event was counted */
+    std::uint64_t value[kEvents];  /**< Count, scaled up if the event was multiplexed */
+
+    bool has(PerfEvent event) const { return valid[static_cast<int>(event)]; }
+    std::uint64_t operator[](PerfEvent event) const { return value[static_cast<int>(event)]; }
+
+    /**
+     * @brief Adds the counts of another thread, an event stays valid only
+     * if it was counted in both.
+     *
+     * @param other Sample to add.
+     */
+    void add(const PerfSample &other)
+    {
+        for (int i = 0; i < kEvents; i++)
+        {
+            valid[i] = valid[i] && other.valid[i];
+            value[i] += other.value[i];
+        }
+    }
+};
+
+/**
+ * @brief Counts hardware events of the calling thread through
+ * perf_event_open.
+ *
+ * Every worker thread opens its own counters and the samples are summed
+ * with PerfSample::add(). Events the kernel refuses (perf_event_paranoid,
+ * containers, virtual machines without a PMU, other platforms) are left out
+ * and reported as not valid instead of failing; if kernel counting is
+ * refused, user space is counted alone.
+ */
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    /**
+     * @brief Resets and enables all available counters.
+     */
+    void start();
+
+    /**
+     * @brief Disables the counters and reads them.
+     *
+     * @return PerfSample Counts since start().
+     */
+    PerfSample stop();
+
+    /**
+     * @brief Whether at least one event is counted.
+     */
+    bool available() const;
+
+    bool available(PerfEvent event) const { return m_fds[static_cast<int>(event)] >= 0; }
+
+    /**
+     * @brief Why events are missing, empty if all are counted.
+     */
+    const std::string &error() const { return m_error; }
+
+    /**
+     * @brief Short name of an event, e.g. "cycles".
+     */
+    static const char *name(PerfEvent event);
+
+private:
+    int m_fds[PerfSample::kEvents]; /**< Counter file descriptors, -1 if unavailable */
+    std::string m_error;            /**< Reason of the first failure */
+};
+
+#endif
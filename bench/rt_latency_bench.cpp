@@ -0,0 +1,271 @@
+#include "histogram.h"
+#include "queue.h"
+#include "realtime.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+/*
+ * Worst-case latency of queue operations issued by a real-time thread.
+ *
+ * A SCHED_FIFO control thread pushes and pops an element every --period-us
+ * microseconds and times each call. Meanwhile normal-priority threads keep
+ * the queue mutex busy, and a SCHED_FIFO thread of medium priority burns the
+ * CPU in bursts. All threads share one CPU, so when the control thread finds
+ * the mutex held by a normal thread, that thread only gets to finish its
+ * critical section if it inherits the control thread's priority; otherwise
+ * the control thread waits out the whole burst (priority inversion).
+ *
+ * Reported per queue configuration: latency percentiles and the maximum,
+ * which is what a real-time budget has to cover.
+ *
+ * usage: rt_latency_bench [--ops N] [--period-us US] [--burst-us US]
+ *                         [--background N] [--json]
+ */
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int ops = 20000;
+        int period_us = 50;
+        int burst_us = 1000;
+        int background = 2;
+        bool json = false;
+    };
+
+    struct Result
+    {
+        LatencyHistogram push;
+        LatencyHistogram pop;
+    };
+
+    std::uint64_t nowNs()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief Pins the calling thread to a CPU and sets its scheduling.
+     *
+     * @return bool False if the policy could not be set, e.g. without
+     * CAP_SYS_NICE.
+     */
+    bool configure(int cpu, int policy, int priority)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+        sched_param param{};
+        param.sched_priority = priority;
+        return pthread_setschedparam(pthread_self(), policy, &param) == 0;
+    }
+
+    int firstCpu()
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &allowed))
+                return cpu;
+        return 0;
+    }
+
+    void sleepUntil(const timespec &ts) { clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr); }
+
+    void addNs(timespec &ts, long ns)
+    {
+        ts.tv_nsec += ns;
+        while (ts.tv_nsec >= 1000000000)
+        {
+            ts.tv_nsec -= 1000000000;
+            ts.tv_sec += 1;
+        }
+    }
+
+    template <typename Traits>
+    bool measure(const Options &options, Result &result)
+    {
+        Queue<std::uint64_t, Traits> queue(1024);
+        std::atomic<bool> stop{false};
+        std::atomic<bool> realtime{true};
+        int cpu = firstCpu();
+
+        std::vector<std::thread> background;
+        for (int i = 0; i < options.background; i++)
+            background.emplace_back([&]()
+                                    {
+                configure(cpu, SCHED_OTHER, 0);
+                std::uint64_t element;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    queue.push(1);
+                    queue.tryPop(element);
+                } });
+
+        std::thread hog([&]()
+                        {
+            if (!configure(cpu, SCHED_FIFO, 40))
+                realtime = false;
+            timespec next;
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                // busy for a burst, then idle for four
+                std::uint64_t end = nowNs() + static_cast<std::uint64_t>(options.burst_us) * 1000;
+                while (nowNs() < end && !stop.load(std::memory_order_relaxed))
+                    cpuRelax();
+                addNs(next, 5L * options.burst_us * 1000);
+                sleepUntil(next);
+            } });
+
+        std::thread control([&]()
+                            {
+            if (!configure(cpu, SCHED_FIFO, 80))
+                realtime = false;
+            timespec next;
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            std::uint64_t element;
+            for (int i = 0; i < options.ops; i++)
+            {
+                addNs(next, options.period_us * 1000L);
+                sleepUntil(next);
+
+                std::uint64_t t0 = nowNs();
+                queue.push(static_cast<std::uint64_t>(i));
+                std::uint64_t t1 = nowNs();
+                queue.tryPopFor(element, 0);
+                std::uint64_t t2 = nowNs();
+                result.push.recordSerialized(t1 - t0);
+                result.pop.recordSerialized(t2 - t1);
+            }
+            stop = true; });
+
+        control.join();
+        hog.join();
+        for (auto &thread : background)
+            thread.join();
+        return realtime;
+    }
+
+    /**
+     * @brief A queue configuration under test, an instantiation of measure().
+     */
+    struct Mode
+    {
+        const char *name;
+        bool (*run)(const Options &, Result &);
+    };
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr, "usage: %s [--ops N] [--period-us US] [--burst-us US] [--background N] [--json]\n",
+                     name);
+        std::exit(2);
+    }
+
+    Options parse(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--ops" && i + 1 < argc)
+                options.ops = std::atoi(argv[++i]);
+            else if (arg == "--period-us" && i + 1 < argc)
+                options.period_us = std::atoi(argv[++i]);
+            else if (arg == "--burst-us" && i + 1 < argc)
+                options.burst_us = std::atoi(argv[++i]);
+            else if (arg == "--background" && i + 1 < argc)
+                options.background = std::atoi(argv[++i]);
+            else if (arg == "--json")
+                options.json = true;
+            else
+                usage(argv[0]);
+        }
+        if (options.ops < 1 || options.period_us < 1 || options.burst_us < 1 || options.background < 0)
+            usage(argv[0]);
+        return options;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options = parse(argc, argv);
+
+    // page faults are the other source of unbounded latency
+    bool locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+
+    const Mode modes[] = {
+        {"default", measure<DefaultQueueTraits>},
+        {"realtime", measure<RealTimeQueueTraits>},
+    };
+
+    if (options.json)
+        std::printf("{\n  \"context\": {\"executable\": \"%s\", \"mlockall\": %s},\n  \"benchmarks\": [\n", argv[0],
+                    locked ? "true" : "false");
+    else
+        std::printf("%-9s %-4s %10s %10s %10s %10s\n", "mode", "op", "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+
+    bool first = true;
+    bool realtime = true;
+    for (const Mode &mode : modes)
+    {
+        Result result;
+        realtime = mode.run(options, result) && realtime;
+
+        const char *ops[] = {"push", "pop"};
+        const LatencyHistogram *histograms[] = {&result.push, &result.pop};
+        for (int i = 0; i < 2; i++)
+        {
+            const LatencyHistogram &h = *histograms[i];
+            if (options.json)
+            {
+                std::string name = std::string("rt_latency/") + mode.name + "/" + ops[i];
+                std::printf("%s    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                            "\"repetitions\": 1, \"repetition_index\": 0, \"threads\": %d, \"iterations\": %d, "
+                            "\"real_time\": %.1f, \"time_unit\": \"ns\", "
+                            "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+                            first ? "" : ",\n", name.c_str(), name.c_str(), options.background + 2, options.ops,
+                            h.mean(), static_cast<unsigned long long>(h.percentile(0.5)),
+                            static_cast<unsigned long long>(h.percentile(0.99)),
+                            static_cast<unsigned long long>(h.percentile(0.999)),
+                            static_cast<unsigned long long>(h.max()));
+            }
+            else
+                std::printf("%-9s %-4s %10llu %10llu %10llu %10llu\n", mode.name, ops[i],
+                            static_cast<unsigned long long>(h.percentile(0.5)),
+                            static_cast<unsigned long long>(h.percentile(0.99)),
+                            static_cast<unsigned long long>(h.percentile(0.999)),
+                            static_cast<unsigned long long>(h.max()));
+            std::fflush(stdout);
+            first = false;
+        }
+    }
+
+    if (options.json)
+        std::printf("\n  ]\n}\n");
+    if (!realtime)
+        std::fprintf(stderr, "warning: SCHED_FIFO refused, threads ran at normal priority; "
+                             "run with CAP_SYS_NICE for meaningful results\n");
+    if (!locked)
+        std::fprintf(stderr, "warning: mlockall() failed, page faults may show up as latency\n");
+    return 0;
+}
@@ -0,0 +1,307 @@
+#include "condition.h"
+#include "histogram.h"
+#include "queue.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+/*
+ * Wake-up microbenchmark: a producer hands single elements to a consumer
+ * that is blocked in pop(), through Queue<std::uint64_t> with each candidate
+ * condition type. The producer pauses between handoffs so that the consumer
+ * is really waiting, not finding the next element already queued.
+ *
+ * Reported per mechanism and thread placement: handoff latency from push()
+ * to the return of pop(), and the CPU time the consumer burns per handoff
+ * (waiting included, which is where spinning shows up).
+ *
+ * With --consumers N, N consumers wait on the same queue and the CPU time is
+ * summed over all of them. The number of consumers that took at least one
+ * element shows whether the mechanism keeps reusing the same warm thread or
+ * rotates through all of them.
+ *
+ * usage: wakeup_bench [--handoffs N] [--gap-us US] [--consumers N] [--json]
+ */
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int handoffs = 5000;
+        int gap_us = 50;
+        int consumers = 1;
+        bool json = false;
+    };
+
+    template <typename Condition>
+    struct WakeupTraits : DefaultQueueTraits
+    {
+        using condition_type = Condition;
+    };
+
+    /**
+     * @brief CPUs of the two threads, -1 when the placement is not available.
+     */
+    struct Placement
+    {
+        const char *name;
+        int producer_cpu;
+        int consumer_cpu;
+    };
+
+    struct Result
+    {
+        LatencyHistogram latency;
+        double cpu_ns_per_handoff = 0;
+        int active_consumers = 0; /**< Consumers that took at least one element */
+    };
+
+    std::uint64_t nowNs()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count());
+    }
+
+    std::uint64_t threadCpuNs()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    void pin(int cpu)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    int readTopology(int cpu, const char *field)
+    {
+        std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + field);
+        int value = -1;
+        in >> value;
+        return value;
+    }
+
+    /**
+     * @brief Picks CPU pairs for same-core, same-socket and cross-socket runs
+     * among the CPUs this process may use.
+     */
+    std::vector<Placement> placements()
+    {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &allowed))
+                cpus.push_back(cpu);
+
+        Placement same_core{"same-core", cpus.front(), cpus.front()};
+        Placement same_socket{"same-socket", -1, -1};
+        Placement cross_socket{"cross-socket", -1, -1};
+
+        int first = cpus.front();
+        int package = readTopology(first, "physical_package_id");
+        int core = readTopology(first, "core_id");
+        for (int cpu : cpus)
+        {
+            if (cpu == first)
+                continue;
+            if (readTopology(cpu, "physical_package_id") != package)
+            {
+                if (cross_socket.producer_cpu < 0)
+                    cross_socket = {"cross-socket", first, cpu};
+            }
+            // prefer another physical core over a hyperthread sibling
+            else if (same_socket.producer_cpu < 0 ||
+                     (readTopology(same_socket.consumer_cpu, "core_id") == core && readTopology(cpu, "core_id") != core))
+                same_socket = {"same-socket", first, cpu};
+        }
+        return {same_core, same_socket, cross_socket};
+    }
+
+    template <typename Condition>
+    void measure(const Options &options, const Placement &placement, Result &result)
+    {
+        // zero tells a consumer to stop, timestamps are never zero
+        const std::uint64_t stop = 0;
+        Queue<std::uint64_t, WakeupTraits<Condition>> queue(16);
+        std::vector<std::uint64_t> cpu(options.consumers);
+        std::vector<int> taken(options.consumers);
+
+        std::vector<std::thread> consumers;
+        for (int c = 0; c < options.consumers; c++)
+            consumers.emplace_back([&, c]()
+                                   {
+                pin(placement.consumer_cpu);
+                std::uint64_t begin = threadCpuNs();
+                for (std::uint64_t pushed = queue.pop(); pushed != stop; pushed = queue.pop())
+                {
+                    result.latency.record(nowNs() - pushed);
+                    taken[c]++;
+                }
+                cpu[c] = threadCpuNs() - begin; });
+
+        std::thread producer([&]()
+                             {
+            pin(placement.producer_cpu);
+            for (int i = 0; i < options.handoffs; i++)
+            {
+                // sleeping leaves the CPU to the consumer in the same-core case
+                std::this_thread::sleep_for(std::chrono::microseconds(options.gap_us));
+                queue.push(nowNs());
+            }
+            for (int c = 0; c < options.consumers; c++)
+            {
+                // never overwrite an element not taken yet
+                while (queue.count() == queue.size())
+                    std::this_thread::yield();
+                queue.push(stop);
+            } });
+
+        producer.join();
+        std::uint64_t total = 0;
+        for (int c = 0; c < options.consumers; c++)
+        {
+            consumers[c].join();
+            total += cpu[c];
+            result.active_consumers += taken[c] != 0;
+        }
+        result.cpu_ns_per_handoff = static_cast<double>(total) / options.handoffs;
+    }
+
+    /**
+     * @brief A mechanism under test, an instantiation of measure().
+     */
+    struct Mechanism
+    {
+        const char *name;
+        void (*run)(const Options &, const Placement &, Result &);
+    };
+
+    std::vector<Mechanism> mechanisms()
+    {
+        return {
+            {"condvar", measure<std::condition_variable>},
+            {"futex", measure<FutexCondition>},
+            {"eventfd", measure<EventfdCondition>},
+            {"spin", measure<SpinCondition>},
+            {"spin-then-park", measure<SpinThenParkCondition>},
+            {"lifo", measure<LifoCondition>},
+            {"adaptive", measure<AdaptiveCondition>},
+#if defined(__cpp_lib_atomic_wait)
+            {"atomic-wait", measure<AtomicWaitCondition>},
+#endif
+        };
+    }
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr, "usage: %s [--handoffs N] [--gap-us US] [--consumers N] [--json]\n", name);
+        std::exit(2);
+    }
+
+    Options parse(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--handoffs" && i + 1 < argc)
+                options.handoffs = std::atoi(argv[++i]);
+            else if (arg == "--gap-us" && i + 1 < argc)
+                options.gap_us = std::atoi(argv[++i]);
+            else if (arg == "--consumers" && i + 1 < argc)
+                options.consumers = std::atoi(argv[++i]);
+            else if (arg == "--json")
+                options.json = true;
+            else
+                usage(argv[0]);
+        }
+        if (options.handoffs < 1 || options.gap_us < 0 || options.consumers < 1 ||
+            options.consumers > 16)
+            usage(argv[0]);
+        return options;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options = parse(argc, argv);
+
+    if (options.json)
+        std::printf("{\n  \"context\": {\"executable\": \"%s\", \"num_cpus\": %u},\n  \"benchmarks\": [\n", argv[0],
+                    std::thread::hardware_concurrency());
+    else
+    {
+#if !defined(__cpp_lib_atomic_wait)
+        std::printf("atomic-wait skipped: std::atomic::wait needs C++20\n");
+#endif
+        std::printf("%-15s %-13s %10s %10s %10s %10s %14s %9s\n", "mechanism", "placement", "p50 ns", "p99 ns",
+                    "p99.9 ns", "max ns", "cpu ns/handoff", "consumers");
+    }
+
+    bool first = true;
+    for (const Placement &placement : placements())
+    {
+        if (placement.producer_cpu < 0)
+        {
+            if (!options.json)
+                std::printf("%-15s %-13s not available on this machine\n", "*", placement.name);
+            continue;
+        }
+
+        for (const Mechanism &mechanism : mechanisms())
+        {
+            Result result;
+            mechanism.run(options, placement, result);
+
+            if (options.json)
+            {
+                std::string name = std::string("wakeup/") + mechanism.name + "/" + placement.name;
+                std::printf("%s    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                            "\"repetitions\": 1, \"repetition_index\": 0, \"threads\": %d, \"iterations\": %d, "
+                            "\"real_time\": %.1f, \"cpu_time\": %.1f, \"time_unit\": \"ns\", "
+                            "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, "
+                            "\"active_consumers\": %d}",
+                            first ? "" : ",\n", name.c_str(), name.c_str(), options.consumers + 1, options.handoffs,
+                            result.latency.mean(),
+                            result.cpu_ns_per_handoff,
+                            static_cast<unsigned long long>(result.latency.percentile(0.5)),
+                            static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                            static_cast<unsigned long long>(result.latency.percentile(0.999)),
+                            static_cast<unsigned long long>(result.latency.max()), result.active_consumers);
+            }
+            else
+                std::printf("%-15s %-13s %10llu %10llu %10llu %10llu %14.0f %5d/%-3d\n", mechanism.name, placement.name,
+                            static_cast<unsigned long long>(result.latency.percentile(0.5)),
+                            static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                            static_cast<unsigned long long>(result.latency.percentile(0.999)),
+                            static_cast<unsigned long long>(result.latency.max()), result.cpu_ns_per_handoff,
+                            result.active_consumers, options.consumers);
+            std::fflush(stdout);
+            first = false;
+        }
+    }
+
+    if (options.json)
+        std::printf("\n  ]\n}\n");
+    return 0;
+}
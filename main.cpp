@@ -1,43 +1,497 @@
+#include "arrival.h"
+#include "compressed_queue.h"
+#include "histogram.h"
+#include "perf_counters.h"
 #include "queue.h"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
 #include <thread>
+#include <vector>
+
+/*
+ * Load generator: producers push timestamped elements into a queue while
+ * consumers pop them, and the run reports throughput, elements lost to
+ * overwrites and the push-to-pop latency distribution.
+ *
+ * Closed loop (--rate 0) pushes back to back. Open loop schedules pushes
+ * from an arrival process (see bench/arrival.h), --rate R being a shorthand
+ * for --arrival constant:R; latency is then measured from the scheduled
+ * push time, so a producer falling behind shows up as latency instead of
+ * being hidden (no coordinated omission). --service makes consumers spend
+ * a random time on every element. --perf adds hardware counters per
+ * element popped, from perf_event_open when the kernel allows it.
+ */
 
-template <typename T>
-void read(Queue<T> &queue, std::vector<T> &elements)
+namespace
 {
-    elements.push_back(queue.pop()); // pops 1
-    std::this_thread::sleep_for(std::chrono::seconds(2));
-    elements.push_back(queue.pop()); // pops 3
-    elements.push_back(queue.pop()); // pops 4
-    elements.push_back(queue.pop()); // blocks
+    using clock_type = std::chrono::steady_clock;
+
+    struct Options
+    {
+        int producers = 1;
+        int consumers = 1;
+        int capacity = 1024;
+        int payload = 8;
+        double rate = 0;
+        std::string arrival;
+        std::string service;
+        std::uint64_t seed = 1;
+        double duration = 1.0;
+        std::string variant = "queue";
+        int repetitions = 1;
+        bool perf = false;
+        bool json = false;
+    };
+
+    /**
+     * @brief Outcome of one repetition.
+     */
+    struct RunResult
+    {
+        std::uint64_t pushed = 0;
+        std::uint64_t popped = 0;
+        double seconds = 0;
+        LatencyHistogram latency;
+        bool has_perf = false;
+        PerfSample perf{};
+    };
+
+    /**
+     * @brief Sum of the hardware counters of all worker threads.
+     */
+    struct PerfTotal
+    {
+        std::mutex mtx;
+        bool empty = true;
+        PerfSample sum{};
+
+        void add(const PerfSample &sample)
+        {
+            std::lock_guard<std::mutex> lck(mtx);
+            if (empty)
+                sum = sample;
+            else
+                sum.add(sample);
+            empty = false;
+        }
+    };
+
+    /**
+     * @brief Element of the given size whose first 8 bytes carry the push time.
+     */
+    template <int Size>
+    struct Payload
+    {
+        std::uint64_t stamp;
+        char padding[Size - sizeof(std::uint64_t)];
+    };
+
+    template <typename T>
+    T makeElement(std::uint64_t stamp)
+    {
+        T element{};
+        std::memcpy(&element, &stamp, sizeof(stamp));
+        return element;
+    }
+
+    template <typename T>
+    std::uint64_t stampOf(const T &element)
+    {
+        std::uint64_t stamp;
+        std::memcpy(&stamp, &element, sizeof(stamp));
+        return stamp;
+    }
+
+    std::uint64_t nowNs()
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief Waits until a steady clock time, sleeping for long waits and
+     * spinning for the last stretch so that high rates stay on schedule.
+     */
+    void waitUntil(std::uint64_t deadline)
+    {
+        constexpr std::uint64_t kSpin = 100000;
+        std::uint64_t now = nowNs();
+        if (deadline > now + kSpin)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now - kSpin));
+        while (nowNs() < deadline)
+        {
+        }
+    }
+
+    /**
+     * @brief Runs producers and consumers against one queue for the configured duration.
+     */
+    template <typename QueueT, typename T>
+    void runOnce(const Options &options, RunResult &result)
+    {
+        QueueT queue(options.capacity);
+        std::atomic<bool> go{false};
+        std::atomic<int> producing{options.producers};
+        std::atomic<std::uint64_t> pushed{0};
+        std::atomic<std::uint64_t> popped{0};
+        std::vector<std::unique_ptr<LatencyHistogram>> latencies;
+        std::vector<std::thread> threads;
+        PerfTotal perf;
+
+        std::uint64_t start = 0;
+        std::uint64_t length = static_cast<std::uint64_t>(options.duration * 1e9);
+
+        // every repetition replays the same traffic
+        std::vector<std::unique_ptr<ArrivalProcess>> arrivals(options.producers);
+        std::vector<std::unique_ptr<ServiceTime>> services(options.consumers);
+        for (int i = 0; i < options.producers && !options.arrival.empty(); i++)
+            arrivals[i] = makeArrivals(options.arrival, options.seed, i, options.producers);
+        for (int i = 0; i < options.consumers && !options.service.empty(); i++)
+            services[i] = makeServiceTime(options.service, options.seed, i);
+
+        for (int i = 0; i < options.producers; i++)
+            threads.emplace_back([&, i]()
+                                 {
+                std::unique_ptr<PerfCounters> counters = options.perf ? std::make_unique<PerfCounters>() : nullptr;
+                while (!go.load(std::memory_order_acquire))
+                {
+                }
+                if (counters)
+                    counters->start();
+
+                ArrivalProcess *process = arrivals[i].get();
+                std::uint64_t count = 0;
+                std::uint64_t end = start + length;
+                for (;;)
+                {
+                    std::uint64_t stamp;
+                    if (process != nullptr)
+                    {
+                        stamp = start + process->nextArrival();
+                        if (stamp >= end)
+                            break;
+                        waitUntil(stamp);
+                    }
+                    else if ((stamp = nowNs()) >= end)
+                        break;
+
+                    queue.push(makeElement<T>(stamp));
+                    count++;
+                }
+                if (counters)
+                    perf.add(counters->stop());
+                pushed.fetch_add(count);
+                producing.fetch_sub(1, std::memory_order_release); });
+
+        for (int i = 0; i < options.consumers; i++)
+        {
+            latencies.push_back(std::make_unique<LatencyHistogram>());
+            LatencyHistogram &latency = *latencies.back();
+            ServiceTime *service = services[i].get();
+            threads.emplace_back([&, service]()
+                                 {
+                std::unique_ptr<PerfCounters> counters = options.perf ? std::make_unique<PerfCounters>() : nullptr;
+                if (counters)
+                    counters->start();
+
+                std::uint64_t count = 0;
+                for (;;)
+                {
+                    try
+                    {
+                        T element = queue.popWithTimeout(5);
+                        std::uint64_t now = nowNs();
+                        latency.recordSerialized(now - stampOf(element));
+                        count++;
+                        if (service != nullptr)
+                            waitUntil(now + service->next());
+                    }
+                    catch (const std::system_error &)
+                    {
+                        // done once the producers stopped and the queue is drained
+                        if (producing.load(std::memory_order_acquire) == 0)
+                            break;
+                    }
+                }
+                if (counters)
+                    perf.add(counters->stop());
+                popped.fetch_add(count); });
+        }
+
+        start = nowNs() + 1000000;
+        go.store(true, std::memory_order_release);
+        for (auto &thread : threads)
+            thread.join();
+
+        // an open loop may end early when its last arrival is due before the end
+        result.seconds = static_cast<double>(std::max(nowNs() - start, length)) / 1e9;
+        result.pushed = pushed.load();
+        result.popped = popped.load();
+        for (const auto &latency : latencies)
+            result.latency.merge(*latency);
+        result.has_perf = !perf.empty;
+        result.perf = perf.sum;
+    }
+
+    using Runner = void (*)(const Options &, RunResult &);
+
+    template <int Size>
+    Runner queueRunner()
+    {
+        return runOnce<Queue<Payload<Size>>, Payload<Size>>;
+    }
+
+    /**
+     * @brief Selects the instantiation for the variant and payload size.
+     */
+    Runner selectRunner(const Options &options)
+    {
+        if (options.variant == "compressed")
+            return options.payload == 8 ? runOnce<CompressedQueue<std::uint64_t>, std::uint64_t> : nullptr;
+
+        if (options.variant == "queue")
+        {
+            switch (options.payload)
+            {
+            case 8:
+                return runOnce<Queue<std::uint64_t>, std::uint64_t>;
+            case 16:
+                return queueRunner<16>();
+            case 64:
+                return queueRunner<64>();
+            case 256:
+                return queueRunner<256>();
+            case 1024:
+                return queueRunner<1024>();
+            }
+        }
+        return nullptr;
+    }
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr,
+                     "usage: %s [options]\n"
+                     "  --producers N     producer threads (1)\n"
+                     "  --consumers N     consumer threads (1)\n"
+                     "  --capacity N      queue capacity (1024)\n"
+                     "  --payload BYTES   element size: 8, 16, 64, 256 or 1024 (8)\n"
+                     "  --rate OPS        total pushes per second at fixed intervals, 0 for closed loop (0)\n"
+                     "  --arrival SPEC    arrival process instead of --rate: constant:RATE, poisson:RATE,\n"
+                     "                    onoff:RATE:ON_MS:OFF_MS, diurnal:RATE:AMPLITUDE:PERIOD_MS or trace:LOG\n"
+                     "  --service SPEC    consumer time per element: constant:NS, exponential:NS or pareto:NS:SHAPE\n"
+                     "  --seed N          seed of the arrival and service streams (1)\n"
+                     "  --duration S      seconds per repetition (1)\n"
+                     "  --variant NAME    queue or compressed (queue, compressed needs --payload 8)\n"
+                     "  --repetitions N   repetitions (1)\n"
+                     "  --perf            count cycles, instructions, cache misses and context switches\n"
+                     "  --json            print results as JSON\n",
+                     name);
+        std::exit(2);
+    }
+
+    Options parse(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char *
+            {
+                if (i + 1 >= argc)
+                    usage(argv[0]);
+                return argv[++i];
+            };
+
+            if (arg == "--producers")
+                options.producers = std::atoi(value());
+            else if (arg == "--consumers")
+                options.consumers = std::atoi(value());
+            else if (arg == "--capacity")
+                options.capacity = std::atoi(value());
+            else if (arg == "--payload")
+                options.payload = std::atoi(value());
+            else if (arg == "--rate")
+                options.rate = std::atof(value());
+            else if (arg == "--arrival")
+                options.arrival = value();
+            else if (arg == "--service")
+                options.service = value();
+            else if (arg == "--seed")
+                options.seed = std::strtoull(value(), nullptr, 10);
+            else if (arg == "--duration")
+                options.duration = std::atof(value());
+            else if (arg == "--variant")
+                options.variant = value();
+            else if (arg == "--repetitions")
+                options.repetitions = std::atoi(value());
+            else if (arg == "--perf")
+                options.perf = true;
+            else if (arg == "--json")
+                options.json = true;
+            else
+                usage(argv[0]);
+        }
+
+        if (options.producers < 1 || options.consumers < 1 || options.capacity < 1 || options.rate < 0 ||
+            options.duration <= 0 || options.repetitions < 1)
+            usage(argv[0]);
+
+        if (options.arrival.empty() && options.rate > 0)
+        {
+            char spec[64];
+            std::snprintf(spec, sizeof(spec), "constant:%g", options.rate);
+            options.arrival = spec;
+        }
+        return options;
+    }
+
+    std::string runName(const Options &options)
+    {
+        char name[160];
+        std::snprintf(name, sizeof(name), "%s/producers:%d/consumers:%d/capacity:%d/payload:%d",
+                      options.variant.c_str(), options.producers, options.consumers, options.capacity,
+                      options.payload);
+        std::string result = name;
+        if (!options.arrival.empty())
+            result += "/arrival:" + options.arrival;
+        if (!options.service.empty())
+            result += "/service:" + options.service;
+        return result;
+    }
+
+    /**
+     * @brief Hardware count per element popped, negative if not counted.
+     */
+    double perElement(const RunResult &result, PerfEvent event)
+    {
+        if (!result.has_perf || !result.perf.has(event) || result.popped == 0)
+            return -1;
+        return static_cast<double>(result.perf[event]) / static_cast<double>(result.popped);
+    }
+
+    void printText(const RunResult &result, int repetition)
+    {
+        std::uint64_t dropped = result.pushed - result.popped;
+        std::printf("#%d  %.3f s  pushed %llu (%.0f/s)  popped %llu (%.0f/s)  dropped %llu (%.2f%%)\n", repetition,
+                    result.seconds, static_cast<unsigned long long>(result.pushed), result.pushed / result.seconds,
+                    static_cast<unsigned long long>(result.popped), result.popped / result.seconds,
+                    static_cast<unsigned long long>(dropped),
+                    result.pushed == 0 ? 0.0 : 100.0 * static_cast<double>(dropped) / static_cast<double>(result.pushed));
+        std::printf("    latency  p50 %llu ns  p90 %llu ns  p99 %llu ns  p99.9 %llu ns  max %llu ns\n",
+                    static_cast<unsigned long long>(result.latency.percentile(0.5)),
+                    static_cast<unsigned long long>(result.latency.percentile(0.9)),
+                    static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                    static_cast<unsigned long long>(result.latency.percentile(0.999)),
+                    static_cast<unsigned long long>(result.latency.max()));
+
+        if (!result.has_perf)
+            return;
+        std::printf("    per element");
+        for (int i = 0; i < PerfSample::kEvents; i++)
+        {
+            double value = perElement(result, static_cast<PerfEvent>(i));
+            if (value < 0)
+                std::printf("  %s n/a", PerfCounters::name(static_cast<PerfEvent>(i)));
+            else
+                std::printf("  %s %.2f", PerfCounters::name(static_cast<PerfEvent>(i)), value);
+        }
+        std::printf("\n");
+    }
+
+    /**
+     * @brief Prints one repetition in the layout of Google Benchmark JSON
+     * output, so that the same tools can compare both.
+     */
+    void printJson(const Options &options, const RunResult &result, int repetition)
+    {
+        std::string name = runName(options);
+        std::printf("%s    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", "
+                    "\"repetitions\": %d, \"repetition_index\": %d, \"threads\": %d, \"iterations\": %llu, "
+                    "\"real_time\": %.3f, \"time_unit\": \"ns\", \"items_per_second\": %.1f, "
+                    "\"dropped\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu",
+                    repetition == 0 ? "" : ",\n", name.c_str(), name.c_str(), options.repetitions, repetition,
+                    options.producers + options.consumers, static_cast<unsigned long long>(result.popped),
+                    result.popped == 0 ? 0.0 : result.seconds * 1e9 / static_cast<double>(result.popped),
+                    result.popped / result.seconds, static_cast<unsigned long long>(result.pushed - result.popped),
+                    static_cast<unsigned long long>(result.latency.percentile(0.5)),
+                    static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                    static_cast<unsigned long long>(result.latency.percentile(0.999)),
+                    static_cast<unsigned long long>(result.latency.max()));
+
+        // counters in the style of Google Benchmark user counters
+        for (int i = 0; i < PerfSample::kEvents; i++)
+        {
+            double value = perElement(result, static_cast<PerfEvent>(i));
+            if (value >= 0)
+                std::printf(", \"%s_per_item\": %.3f", PerfCounters::name(static_cast<PerfEvent>(i)), value);
+        }
+        std::printf("}");
+    }
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    Queue<int> queue(2);
-    std::vector<int> elements;
+    Options options = parse(argc, argv);
+    Runner runner = selectRunner(options);
+    if (runner == nullptr)
+    {
+        std::fprintf(stderr, "%s: unsupported variant/payload combination %s/%d\n", argv[0], options.variant.c_str(),
+                     options.payload);
+        return 2;
+    }
 
-    std::thread reader(read<int>, std::ref(queue), std::ref(elements));
+    try
+    {
+        // reject malformed specifications before printing anything
+        if (!options.arrival.empty())
+            makeArrivals(options.arrival, options.seed, 0, options.producers);
+        if (!options.service.empty())
+            makeServiceTime(options.service, options.seed, 0);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 2;
+    }
 
-    std::thread writer([&queue]()
-                       {
-                        queue.push(1);
-                        std::this_thread::sleep_for(std::chrono::seconds(1));
-                        queue.push(2);
-                        queue.push(3);
-                        queue.push(4);
-                        std::this_thread::sleep_for(std::chrono::seconds(5));
-                        queue.push(5);
-                        });
+    if (options.perf)
+    {
+        PerfCounters probe;
+        if (!probe.error().empty())
+            std::fprintf(stderr, "%s: %s, %s\n", argv[0], probe.error().c_str(),
+                         probe.available() ? "some counters are not reported" : "hardware counters disabled");
+    }
 
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    if (options.json)
+        std::printf("{\n  \"context\": {\"executable\": \"%s\", \"num_cpus\": %u},\n  \"benchmarks\": [\n", argv[0],
+                    std::thread::hardware_concurrency());
+    else
+        std::printf("%s, %s loop, %.1f s x %d\n", runName(options).c_str(), options.arrival.empty() ? "closed" : "open",
+                    options.duration, options.repetitions);
 
-    reader.join();
-    writer.join();
+    for (int repetition = 0; repetition < options.repetitions; repetition++)
+    {
+        RunResult result;
+        runner(options, result);
+        if (options.json)
+            printJson(options, result, repetition);
+        else
+            printText(result, repetition);
+    }
 
-    std::cout << "Number of elements in queue:" << queue.count();
+    if (options.json)
+        std::printf("\n  ]\n}\n");
     return 0;
-}
\ No newline at end of file
+}
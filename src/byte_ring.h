@@ -0,0 +1,237 @@
+#ifndef __BYTE_RING_H__
+#define __BYTE_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+/**
+ * @brief A record read from a ByteRing, pointing into the ring.
+ */
+struct ByteRecord
+{
+    const std::uint8_t *data; /**< First payload byte, nullptr when there is no record */
+    std::size_t size;         /**< Payload size in bytes */
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+/**
+ * @brief Single-producer single-consumer ring of variable-size records.
+ *
+ * The producer reserves room for a record, writes the payload in place and
+ * commits it; the consumer peeks at the oldest record, reads it in place and
+ * consumes it. Nothing is copied or allocated per record.
+ *
+ * Every record is an 8-byte header holding the length, followed by the
+ * payload padded to the next 8-byte boundary, so payloads are aligned and
+ * can hold structs read in place. A record never wraps: when it does not fit
+ * before the end of the buffer, a skip marker sends the consumer back to the
+ * start. Unlike Queue, a full ring does not overwrite, reserve() fails
+ * instead. Both sides poll; neither call blocks.
+ *
+ * Exactly one thread may produce and one thread may consume at a time.
+ */
+class ByteRing
+{
+public:
+    static constexpr std::size_t kAlign = 8;      /**< Alignment of every record and payload */
+    static constexpr std::size_t kHeaderSize = 8; /**< Bytes of the length prefix, padding included */
+
+    ByteRing() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs an empty ring.
+     *
+     * @param bytes Size of the buffer, rounded up to a multiple of kAlign.
+     *
+     * @throws std::invalid_argument If the buffer cannot hold a record of one byte.
+     */
+    explicit ByteRing(std::size_t bytes)
+        : m_capacity((bytes + kAlign - 1) / kAlign * kAlign), m_buffer(nullptr), m_reserved(), m_reserved_skip(),
+          m_head(), m_cached_tail(), m_tail(), m_cached_head()
+    {
+        if (m_capacity < 4 * kAlign)
+            throw std::invalid_argument("ByteRing: buffer too small");
+        m_buffer = static_cast<std::uint8_t *>(operator new(m_capacity, std::align_val_t(kAlign)));
+    }
+
+    ByteRing(const ByteRing &) = delete;
+    ByteRing &operator=(const ByteRing &) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * Releases the buffer; records still in the ring are dropped.
+     */
+    ~ByteRing() { operator delete(m_buffer, std::align_val_t(kAlign)); }
+
+    /**
+     * @brief Reserves room for a record. Producer only.
+     *
+     * The record becomes visible to the consumer with commit(). Reserving
+     * again before committing replaces the previous reservation.
+     *
+     * @param size Payload size in bytes, at most maxRecordSize().
+     * @return std::uint8_t* Where to write the payload, aligned to kAlign,
+     * or nullptr if the ring lacks room right now.
+     *
+     * @throws std::length_error If size exceeds maxRecordSize().
+     */
+    std::uint8_t *reserve(std::size_t size)
+    {
+        if (size > maxRecordSize())
+            throw std::length_error("ByteRing: record larger than maxRecordSize()");
+
+        std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t offset = static_cast<std::size_t>(tail % m_capacity);
+        std::size_t need = recordSize(size);
+
+        // a record that does not fit before the end starts over at offset 0
+        std::size_t skip = need > m_capacity - offset ? m_capacity - offset : 0;
+        if (!hasRoom(tail, skip + need))
+            return nullptr;
+
+        m_reserved = tail + skip;
+        m_reserved_skip = skip;
+        return m_buffer + (offset + skip) % m_capacity + kHeaderSize;
+    }
+
+    /**
+     * @brief Publishes the reserved record. Producer only.
+     *
+     * @param size Bytes actually written, at most the size reserved.
+     */
+    void commit(std::size_t size)
+    {
+        std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_reserved_skip != 0)
+            writeLength(static_cast<std::size_t>(tail % m_capacity), kSkip);
+        writeLength(static_cast<std::size_t>(m_reserved % m_capacity), static_cast<std::uint32_t>(size));
+
+        // release: the payload and the lengths are visible before the record
+        m_tail.store(m_reserved + recordSize(size), std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies a payload into the ring as one record. Producer only.
+     *
+     * @param data Payload.
+     * @param size Payload size in bytes, at most maxRecordSize().
+     * @return bool False if the ring lacks room right now.
+     */
+    bool tryPush(const void *data, std::size_t size)
+    {
+        std::uint8_t *out = reserve(size);
+        if (out == nullptr)
+            return false;
+        std::memcpy(out, data, size);
+        commit(size);
+        return true;
+    }
+
+    /**
+     * @brief The oldest committed record, left in the ring. Consumer only.
+     *
+     * @return ByteRecord The record, valid until consume(), or an empty
+     * record if the ring is empty.
+     */
+    ByteRecord peek()
+    {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cached_tail)
+        {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cached_tail)
+                return {nullptr, 0};
+        }
+
+        std::size_t offset = static_cast<std::size_t>(head % m_capacity);
+        std::uint32_t length = readLength(offset);
+        if (length == kSkip)
+        {
+            // the producer committed the record after the marker with it
+            head += m_capacity - offset;
+            m_head.store(head, std::memory_order_release);
+            offset = 0;
+            length = readLength(0);
+        }
+        return {m_buffer + offset + kHeaderSize, length};
+    }
+
+    /**
+     * @brief Removes the record returned by the last peek(). Consumer only.
+     */
+    void consume()
+    {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        std::uint32_t length = readLength(static_cast<std::size_t>(head % m_capacity));
+
+        // release: the payload is read before the producer may overwrite it
+        m_head.store(head + recordSize(length), std::memory_order_release);
+    }
+
+    /**
+     * @brief Size of the largest record, so that one always fits in an
+     * empty ring wherever the previous record ended.
+     */
+    std::size_t maxRecordSize() const { return m_capacity / 2 / kAlign * kAlign - kHeaderSize; }
+
+    /**
+     * @brief Buffer size getter.
+     *
+     * @return std::size_t Size of the buffer in bytes.
+     */
+    std::size_t capacity() const { return m_capacity; }
+
+    /**
+     * @brief Bytes taken by records, headers and padding included. Only
+     * exact when neither side is running.
+     */
+    std::size_t used() const
+    {
+        return static_cast<std::size_t>(m_tail.load(std::memory_order_acquire) -
+                                        m_head.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief Bytes a record of a given payload size takes in the ring.
+     */
+    static std::size_t recordSize(std::size_t size) { return (kHeaderSize + size + kAlign - 1) / kAlign * kAlign; }
+
+private:
+    static constexpr std::uint32_t kSkip = ~std::uint32_t{0}; /**< Length of a skip marker */
+
+    bool hasRoom(std::uint64_t tail, std::size_t bytes)
+    {
+        if (tail + bytes - m_cached_head <= m_capacity)
+            return true;
+        m_cached_head = m_head.load(std::memory_order_acquire);
+        return tail + bytes - m_cached_head <= m_capacity;
+    }
+
+    void writeLength(std::size_t offset, std::uint32_t length) { std::memcpy(m_buffer + offset, &length, sizeof(length)); }
+
+    std::uint32_t readLength(std::size_t offset) const
+    {
+        std::uint32_t length;
+        std::memcpy(&length, m_buffer + offset, sizeof(length));
+        return length;
+    }
+
+    const std::size_t m_capacity; /**< Size of the buffer */
+    std::uint8_t *m_buffer;       /**< Records */
+    std::uint64_t m_reserved;     /**< Producer: position of the reserved record */
+    std::size_t m_reserved_skip;  /**< Producer: bytes skipped before the reserved record */
+
+    // each side owns a cache line: its position and its copy of the other's
+    alignas(64) std::atomic<std::uint64_t> m_head; /**< Bytes consumed since construction */
+    std::uint64_t m_cached_tail;                   /**< Consumer: last m_tail seen */
+    alignas(64) std::atomic<std::uint64_t> m_tail; /**< Bytes committed since construction */
+    std::uint64_t m_cached_head;                   /**< Producer: last m_head seen */
+};
+
+#endif
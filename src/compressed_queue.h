@@ -0,0 +1,507 @@
+#ifndef __COMPRESSED_QUEUE_H__
+#define __COMPRESSED_QUEUE_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "queue.h"
+
+/**
+ * @brief Appends bit fields to a byte buffer, least significant bit first.
+ */
+class BitWriter
+{
+public:
+    explicit BitWriter(std::uint8_t *out) : m_out(out), m_pos(), m_acc(), m_bits() {}
+
+    /**
+     * @brief Writes the low n bits of a value.
+     *
+     * @param value Bits to write.
+     * @param n Number of bits, 0 to 64.
+     */
+    void write(std::uint64_t value, int n)
+    {
+        if (n > 32)
+        {
+            write(value & 0xffffffffu, 32);
+            write(value >> 32, n - 32);
+            return;
+        }
+
+        m_acc |= (value & mask(n)) << m_bits;
+        m_bits += n;
+        while (m_bits >= 8)
+        {
+            m_out[m_pos++] = static_cast<std::uint8_t>(m_acc);
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+
+    /**
+     * @brief Flushes the last partial byte.
+     *
+     * @return std::size_t Number of bytes written.
+     */
+    std::size_t finish()
+    {
+        if (m_bits > 0)
+            m_out[m_pos++] = static_cast<std::uint8_t>(m_acc);
+        m_acc = 0;
+        m_bits = 0;
+        return m_pos;
+    }
+
+    static std::uint64_t mask(int n) { return n >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << n) - 1; }
+
+private:
+    std::uint8_t *m_out; /**< Destination buffer */
+    std::size_t m_pos;   /**< Bytes written */
+    std::uint64_t m_acc; /**< Bits not yet written */
+    int m_bits;          /**< Number of bits in m_acc */
+};
+
+/**
+ * @brief Reads bit fields written by BitWriter.
+ */
+class BitReader
+{
+public:
+    BitReader(const std::uint8_t *in, std::size_t size) : m_in(in), m_size(size), m_pos(), m_acc(), m_bits() {}
+
+    /**
+     * @brief Reads n bits. Reading past the end yields zero bits.
+     *
+     * @param n Number of bits, 0 to 64.
+     * @return std::uint64_t The bits read.
+     */
+    std::uint64_t read(int n)
+    {
+        if (n > 32)
+        {
+            std::uint64_t low = read(32);
+            return low | (read(n - 32) << 32);
+        }
+
+        while (m_bits < n)
+        {
+            std::uint64_t byte = m_pos < m_size ? m_in[m_pos] : 0;
+            m_pos++;
+            m_acc |= byte << m_bits;
+            m_bits += 8;
+        }
+        std::uint64_t value = m_acc & BitWriter::mask(n);
+        m_acc >>= n;
+        m_bits -= n;
+        return value;
+    }
+
+private:
+    const std::uint8_t *m_in; /**< Source buffer */
+    std::size_t m_size;       /**< Size of the source buffer */
+    std::size_t m_pos;        /**< Bytes consumed */
+    std::uint64_t m_acc;      /**< Bits read but not returned */
+    int m_bits;               /**< Number of bits in m_acc */
+};
+
+/**
+ * @brief Block codecs used by CompressedQueue.
+ *
+ * Integers: the first value raw, then the deltas between neighbours,
+ * zigzag-mapped to unsigned and bit-packed at the width of the largest one.
+ * Floating point: Gorilla XOR encoding, i.e. each value XORed with its
+ * predecessor and stored as one bit when equal, or as the meaningful bits
+ * between the leading and trailing zeros.
+ */
+template <typename T, typename Enable = void>
+struct BlockCodec;
+
+template <typename T>
+struct BlockCodec<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    /**
+     * @brief Upper bound of the encoded size of n values.
+     */
+    static std::size_t maxBytes(int n) { return 1 + 8 + static_cast<std::size_t>(n) * 8 + 8; }
+
+    static std::size_t encode(const T *values, int n, std::uint8_t *out)
+    {
+        // two's complement deltas, wrapping is fine since decoding wraps back
+        std::uint64_t widest = 0;
+        for (int i = 1; i < n; i++)
+            widest |= zigzag(static_cast<std::uint64_t>(values[i]) - static_cast<std::uint64_t>(values[i - 1]));
+        int width = widest == 0 ? 0 : 64 - __builtin_clzll(widest);
+
+        BitWriter writer(out);
+        writer.write(static_cast<std::uint64_t>(width), 8);
+        writer.write(static_cast<std::uint64_t>(values[0]), 64);
+        for (int i = 1; i < n; i++)
+            writer.write(zigzag(static_cast<std::uint64_t>(values[i]) - static_cast<std::uint64_t>(values[i - 1])), width);
+        return writer.finish();
+    }
+
+    static void decode(const std::uint8_t *in, std::size_t size, int n, T *out, std::uint64_t *scratch)
+    {
+        BitReader reader(in, size);
+        int width = static_cast<int>(reader.read(8));
+        std::uint64_t value = reader.read(64);
+
+        // fixed-width unpack, then a prefix sum over the deltas, unzigzagged
+        // without a branch; the sum carries from one element to the next
+        for (int i = 1; i < n; i++)
+            scratch[i] = reader.read(width);
+
+        out[0] = static_cast<T>(value);
+        for (int i = 1; i < n; i++)
+        {
+            value += (scratch[i] >> 1) ^ (~(scratch[i] & 1) + 1);
+            out[i] = static_cast<T>(value);
+        }
+    }
+
+    static std::uint64_t zigzag(std::uint64_t delta)
+    {
+        return (delta << 1) ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(delta) >> 63);
+    }
+};
+
+template <typename T>
+struct BlockCodec<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "BlockCodec: only float and double are supported");
+
+    using bits_type = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+    static constexpr int kBits = sizeof(T) * 8;
+    static constexpr int kLeadingBits = 5;                    /**< Field holding the leading zeros, capped at 31 */
+    static constexpr int kLengthBits = sizeof(T) == 4 ? 5 : 6; /**< Field holding meaningful bits - 1 */
+
+    static std::size_t maxBytes(int n)
+    {
+        return static_cast<std::size_t>(n) * (2 + kLeadingBits + kLengthBits + kBits) / 8 + kBits / 8 + 8;
+    }
+
+    static std::size_t encode(const T *values, int n, std::uint8_t *out)
+    {
+        BitWriter writer(out);
+        bits_type previous = toBits(values[0]);
+        writer.write(previous, kBits);
+
+        int window_leading = -1, window_trailing = 0;
+        for (int i = 1; i < n; i++)
+        {
+            bits_type current = toBits(values[i]);
+            bits_type x = current ^ previous;
+            previous = current;
+
+            if (x == 0)
+            {
+                writer.write(0, 1);
+                continue;
+            }
+
+            int leading = countLeading(x);
+            int trailing = __builtin_ctzll(static_cast<std::uint64_t>(x));
+            if (leading > 31)
+                leading = 31;
+
+            if (window_leading >= 0 && leading >= window_leading && trailing >= window_trailing)
+            {
+                // meaningful bits fit in the previous window
+                writer.write(0b01, 2);
+                writer.write(x >> window_trailing, kBits - window_leading - window_trailing);
+            }
+            else
+            {
+                int length = kBits - leading - trailing;
+                writer.write(0b11, 2);
+                writer.write(static_cast<std::uint64_t>(leading), kLeadingBits);
+                writer.write(static_cast<std::uint64_t>(length - 1), kLengthBits);
+                writer.write(x >> trailing, length);
+                window_leading = leading;
+                window_trailing = trailing;
+            }
+        }
+        return writer.finish();
+    }
+
+    static void decode(const std::uint8_t *in, std::size_t size, int n, T *out, std::uint64_t *)
+    {
+        BitReader reader(in, size);
+        bits_type previous = static_cast<bits_type>(reader.read(kBits));
+        out[0] = fromBits(previous);
+
+        int window_leading = 0, window_trailing = 0;
+        for (int i = 1; i < n; i++)
+        {
+            if (reader.read(1) != 0)
+            {
+                if (reader.read(1) != 0)
+                {
+                    window_leading = static_cast<int>(reader.read(kLeadingBits));
+                    int length = static_cast<int>(reader.read(kLengthBits)) + 1;
+                    window_trailing = kBits - window_leading - length;
+                }
+                int length = kBits - window_leading - window_trailing;
+                previous ^= static_cast<bits_type>(reader.read(length) << window_trailing);
+            }
+            out[i] = fromBits(previous);
+        }
+    }
+
+    static bits_type toBits(T value)
+    {
+        bits_type bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static T fromBits(bits_type bits)
+    {
+        T value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static int countLeading(bits_type x)
+    {
+        return __builtin_clzll(static_cast<std::uint64_t>(x)) - (64 - kBits);
+    }
+};
+
+/**
+ * @brief A thread-safe queue that stores arithmetic elements compressed.
+ *
+ * Pushed elements collect in an uncompressed block of kBlockSize elements;
+ * a full block is encoded with BlockCodec into an exactly sized buffer. Pop
+ * decodes the oldest block in one pass into a scratch block and then serves
+ * elements from it. Memory use is therefore two uncompressed blocks plus the
+ * encoded size of the rest. Semantics are those of Queue, including
+ * overwriting the oldest element when full.
+ *
+ * @tparam T An integral type, float or double.
+ * @tparam Traits Compile-time configuration, see DefaultQueueTraits. The
+ * mutex, condition and clock types are used.
+ */
+template <typename T, typename Traits = DefaultQueueTraits>
+class CompressedQueue
+{
+    static_assert(std::is_arithmetic<T>::value, "CompressedQueue: T must be arithmetic");
+
+public:
+    using mutex_type = typename Traits::mutex_type;
+    using condition_type = typename Traits::condition_type;
+    using clock_type = typename Traits::clock_type;
+    using codec_type = BlockCodec<T>;
+
+    static constexpr int kBlockSize = 128; /**< Elements per compressed block */
+
+    CompressedQueue() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a queue with a specified capacity.
+     *
+     * @param size The maximum number of elements that the queue can hold.
+     */
+    CompressedQueue(int size)
+        : m_blocks(static_cast<std::size_t>(size / kBlockSize + 3)), m_first_block(), m_sealed(), m_head_offset(),
+          m_decoded_valid(false), m_open(new T[kBlockSize]), m_open_head(), m_open_count(),
+          m_decoded(new T[kBlockSize]), m_unpacked(new std::uint64_t[kBlockSize]),
+          m_scratch(new std::uint8_t[codec_type::maxBytes(kBlockSize)]), m_filled(), m_capacity(size)
+    {
+    }
+
+    CompressedQueue(const CompressedQueue &) = delete;
+    CompressedQueue &operator=(const CompressedQueue &) = delete;
+
+    ~CompressedQueue() { cv.notify_all(); }
+
+    /**
+     * @brief Adds a new element to the queue.
+     *
+     * If the queue is full, the oldest element is removed to make room.
+     *
+     * @param element The element to add to the queue.
+     */
+    void push(const T &element)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        if (m_filled == m_capacity)
+            dropOldest();
+
+        m_open[m_open_count++] = element;
+        m_filled += 1;
+        if (m_open_count == kBlockSize)
+            seal();
+
+        cv.notify_one();
+    }
+
+    /**
+     * @brief Removes and returns the oldest element, waiting for one if empty.
+     *
+     * @return T The oldest element in the queue.
+     */
+    T pop()
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        cv.wait(lck, [this]()
+                { return m_filled != 0; });
+        return takeOldest();
+    }
+
+    /**
+     * @brief Removes and returns the oldest element, with a timeout.
+     *
+     * @param milliseconds_val The timeout period in milliseconds.
+     * @return T The oldest element in the queue.
+     *
+     * @throws std::system_error If the timeout period elapses.
+     */
+    T popWithTimeout(int milliseconds_val)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        auto deadline = clock_type::now() + std::chrono::milliseconds(milliseconds_val);
+        if (!cv.wait_until(lck, deadline, [this]()
+                           { return m_filled != 0; }))
+            throw std::system_error{std::make_error_code(std::errc::operation_would_block),
+                                    "CompressedQueue: pop() timeout"};
+        return takeOldest();
+    }
+
+    /**
+     * @brief Number of elements getter.
+     *
+     * @return int Number of elements in the queue.
+     */
+    int count() const { return m_filled; }
+
+    /**
+     * @brief Capacity getter.
+     *
+     * @return int Capacity of the queue.
+     */
+    int size() const { return m_capacity; }
+
+    /**
+     * @brief Bytes used by element storage, encoded blocks plus buffers.
+     *
+     * @return std::size_t Memory use in bytes.
+     */
+    std::size_t memoryUsage() const
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        std::size_t bytes = 2 * kBlockSize * sizeof(T) + kBlockSize * sizeof(std::uint64_t) +
+                            codec_type::maxBytes(kBlockSize) + m_blocks.size() * sizeof(Block);
+        for (int i = 0; i < m_sealed; i++)
+            bytes += m_blocks[blockIndex(i)].bytes_size;
+        return bytes;
+    }
+
+private:
+    /**
+     * @brief One encoded block.
+     */
+    struct Block
+    {
+        std::unique_ptr<std::uint8_t[]> bytes; /**< Encoded elements */
+        std::size_t bytes_size = 0;            /**< Size of the encoding */
+        int count = 0;                         /**< Number of elements encoded */
+    };
+
+    int blockIndex(int i) const { return (m_first_block + i) % static_cast<int>(m_blocks.size()); }
+
+    /**
+     * @brief Encodes the open block and appends it to the sealed blocks.
+     */
+    void seal()
+    {
+        int count = m_open_count - m_open_head;
+        std::size_t size = codec_type::encode(m_open.get() + m_open_head, count, m_scratch.get());
+
+        Block &block = m_blocks[blockIndex(m_sealed)];
+        block.bytes.reset(new std::uint8_t[size]);
+        std::memcpy(block.bytes.get(), m_scratch.get(), size);
+        block.bytes_size = size;
+        block.count = count;
+        m_sealed += 1;
+
+        m_open_head = 0;
+        m_open_count = 0;
+    }
+
+    /**
+     * @brief Removes the oldest element without reading it.
+     */
+    void dropOldest()
+    {
+        if (m_sealed != 0)
+        {
+            Block &block = m_blocks[m_first_block];
+            if (++m_head_offset == block.count)
+            {
+                block.bytes.reset();
+                block.bytes_size = 0;
+                m_first_block = blockIndex(1);
+                m_sealed -= 1;
+                m_head_offset = 0;
+                m_decoded_valid = false;
+            }
+        }
+        else if (++m_open_head == m_open_count)
+        {
+            m_open_head = 0;
+            m_open_count = 0;
+        }
+        m_filled -= 1;
+    }
+
+    /**
+     * @brief Removes and returns the oldest element. The queue must not be empty.
+     */
+    T takeOldest()
+    {
+        T element;
+        if (m_sealed != 0)
+        {
+            if (!m_decoded_valid)
+            {
+                const Block &block = m_blocks[m_first_block];
+                codec_type::decode(block.bytes.get(), block.bytes_size, block.count, m_decoded.get(), m_unpacked.get());
+                m_decoded_valid = true;
+            }
+            element = m_decoded[m_head_offset];
+        }
+        else
+            element = m_open[m_open_head];
+
+        dropOldest();
+        return element;
+    }
+
+    std::vector<Block> m_blocks;                /**< Ring of encoded blocks */
+    int m_first_block;                          /**< Index of the oldest encoded block */
+    int m_sealed;                               /**< Number of encoded blocks */
+    int m_head_offset;                          /**< Elements consumed from the oldest block */
+    bool m_decoded_valid;                       /**< m_decoded holds the oldest block */
+    std::unique_ptr<T[]> m_open;                /**< Block being filled */
+    int m_open_head;                            /**< Elements consumed from the open block */
+    int m_open_count;                           /**< Elements written to the open block */
+    std::unique_ptr<T[]> m_decoded;             /**< Decoded oldest block */
+    std::unique_ptr<std::uint64_t[]> m_unpacked; /**< Scratch for integer decoding */
+    std::unique_ptr<std::uint8_t[]> m_scratch;  /**< Scratch for encoding */
+    int m_filled;                               /**< Current number of elements */
+    int m_capacity;                             /**< Maximum number of elements */
+
+    mutable mutex_type mtx{};                   /**< Mutex for thread safety */
+    condition_type cv{};                        /**< Condition variable for synchronization */
+};
+
+#endif
@@ -0,0 +1,887 @@
+#ifndef __CONDITION_H__
+#define __CONDITION_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Replacements for std::condition_variable, usable as
+ * DefaultQueueTraits::condition_type to choose how a waiting consumer is
+ * woken up:
+ *
+ *   struct FutexTraits : DefaultQueueTraits { using condition_type = FutexCondition; };
+ *
+ * Each type waits on any std::unique_lock<Mutex> and, like the standard
+ * condition variable, may wake up spuriously; the predicate overloads loop.
+ */
+
+/**
+ * @brief Hint to the CPU that the thread is spinning.
+ */
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief Predicate and relative-timeout overloads shared by the conditions.
+ *
+ * Derived must provide wait(lck) and wait_until(lck, deadline) returning
+ * std::cv_status.
+ *
+ * @tparam Derived The condition type.
+ */
+template <typename Derived>
+class BasicCondition
+{
+public:
+    template <typename Mutex, typename Predicate>
+    void wait(std::unique_lock<Mutex> &lck, Predicate pred)
+    {
+        while (!pred())
+            self().wait(lck);
+    }
+
+    template <typename Mutex, typename Clock, typename Duration, typename Predicate>
+    bool wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline, Predicate pred)
+    {
+        while (!pred())
+            if (self().wait_until(lck, deadline) == std::cv_status::timeout)
+                return pred();
+        return true;
+    }
+
+    template <typename Mutex, typename Rep, typename Period, typename Predicate>
+    bool wait_for(std::unique_lock<Mutex> &lck, const std::chrono::duration<Rep, Period> &timeout, Predicate pred)
+    {
+        return wait_until(lck, std::chrono::steady_clock::now() + timeout, pred);
+    }
+
+protected:
+    /**
+     * @brief Time left until a deadline, zero if it passed.
+     */
+    template <typename Clock, typename Duration>
+    static std::chrono::nanoseconds remaining(const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now());
+        return left > std::chrono::nanoseconds::zero() ? left : std::chrono::nanoseconds::zero();
+    }
+
+private:
+    Derived &self() { return static_cast<Derived &>(*this); }
+};
+
+/**
+ * @brief Condition that never sleeps: waiters spin on a notification counter.
+ *
+ * Lowest wakeup latency when the waiter has a core to itself, wasted CPU
+ * and a scheduler-bound latency when it shares one.
+ */
+class SpinCondition : public BasicCondition<SpinCondition>
+{
+public:
+    using BasicCondition<SpinCondition>::wait;
+    using BasicCondition<SpinCondition>::wait_until;
+
+    void notify_one() { m_sequence.fetch_add(1, std::memory_order_release); }
+    void notify_all() { m_sequence.fetch_add(1, std::memory_order_release); }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        std::uint32_t seen = m_sequence.load(std::memory_order_relaxed);
+        lck.unlock();
+        while (m_sequence.load(std::memory_order_acquire) == seen)
+            cpuRelax();
+        lck.lock();
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        std::uint32_t seen = m_sequence.load(std::memory_order_relaxed);
+        lck.unlock();
+        std::cv_status status = std::cv_status::no_timeout;
+        // reading the clock costs more than a pause, check it now and then
+        for (unsigned spins = 1; m_sequence.load(std::memory_order_acquire) == seen; spins++)
+        {
+            if (spins % 64 == 0 && Clock::now() >= deadline)
+            {
+                status = std::cv_status::timeout;
+                break;
+            }
+            cpuRelax();
+        }
+        lck.lock();
+        return status;
+    }
+
+private:
+    std::atomic<std::uint32_t> m_sequence{0}; /**< Incremented by every notification */
+};
+
+#ifdef __linux__
+
+/**
+ * @brief Thin wrapper over the futex system call on a 32-bit atomic.
+ */
+struct Futex
+{
+    /**
+     * @brief Sleeps while word still holds expected.
+     *
+     * @param word The futex word.
+     * @param expected Value read before deciding to sleep.
+     * @param timeout Relative timeout, or nullptr to wait forever.
+     * @return bool False if the timeout expired.
+     */
+    static bool wait(std::atomic<std::uint32_t> &word, std::uint32_t expected, const timespec *timeout)
+    {
+        long result = ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected,
+                                timeout, nullptr, 0);
+        return result == 0 || errno != ETIMEDOUT;
+    }
+
+    /**
+     * @brief Wakes up to count threads sleeping on word.
+     */
+    static void wake(std::atomic<std::uint32_t> &word, int count)
+    {
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+
+    static timespec toTimespec(std::chrono::nanoseconds duration)
+    {
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(duration.count() / 1000000000);
+        ts.tv_nsec = static_cast<long>(duration.count() % 1000000000);
+        return ts;
+    }
+};
+
+/**
+ * @brief Condition built directly on a futex: a notification counter that
+ * waiters sleep on, with the wake system call skipped while nobody waits.
+ */
+class FutexCondition : public BasicCondition<FutexCondition>
+{
+public:
+    using BasicCondition<FutexCondition>::wait;
+    using BasicCondition<FutexCondition>::wait_until;
+
+    void notify_one() { notify(1); }
+    void notify_all() { notify(INT_MAX); }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        sleep(lck, nullptr);
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        timespec timeout = Futex::toTimespec(remaining(deadline));
+        return sleep(lck, &timeout) ? std::cv_status::no_timeout : std::cv_status::timeout;
+    }
+
+private:
+    void notify(int count)
+    {
+        // sequentially consistent with the waiter count update in sleep():
+        // either the waiter sees the new sequence or the notifier sees it
+        m_sequence.fetch_add(1);
+        if (m_waiters.load() != 0)
+            Futex::wake(m_sequence, count);
+    }
+
+    template <typename Mutex>
+    bool sleep(std::unique_lock<Mutex> &lck, const timespec *timeout)
+    {
+        std::uint32_t seen = m_sequence.load();
+        m_waiters.fetch_add(1);
+        lck.unlock();
+        bool woken = Futex::wait(m_sequence, seen, timeout);
+        m_waiters.fetch_sub(1);
+        lck.lock();
+        return woken;
+    }
+
+    std::atomic<std::uint32_t> m_sequence{0}; /**< Futex word, incremented by every notification */
+    std::atomic<int> m_waiters{0};           /**< Threads in or about to enter the futex wait */
+};
+
+/**
+ * @brief Condition that spins for a while before sleeping on a futex.
+ *
+ * Handoffs that come within the spin budget avoid both the sleep and the
+ * wake system calls; longer waits cost at most the budget in CPU time.
+ */
+class SpinThenParkCondition : public BasicCondition<SpinThenParkCondition>
+{
+public:
+    using BasicCondition<SpinThenParkCondition>::wait;
+    using BasicCondition<SpinThenParkCondition>::wait_until;
+
+    /**
+     * @param spins Number of pause iterations before sleeping.
+     */
+    explicit SpinThenParkCondition(unsigned spins = 4000) : m_spins(spins) {}
+
+    void notify_one() { notify(1); }
+    void notify_all() { notify(INT_MAX); }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        sleep<Mutex, std::chrono::steady_clock::time_point>(lck, nullptr);
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return sleep(lck, &deadline) ? std::cv_status::no_timeout : std::cv_status::timeout;
+    }
+
+private:
+    void notify(int count)
+    {
+        m_sequence.fetch_add(1);
+        if (m_waiters.load() != 0)
+            Futex::wake(m_sequence, count);
+    }
+
+    template <typename Mutex, typename TimePoint>
+    bool sleep(std::unique_lock<Mutex> &lck, const TimePoint *deadline)
+    {
+        std::uint32_t seen = m_sequence.load();
+        lck.unlock();
+
+        for (unsigned i = 0; i < m_spins; i++)
+        {
+            if (m_sequence.load(std::memory_order_acquire) != seen)
+            {
+                lck.lock();
+                return true;
+            }
+            cpuRelax();
+        }
+
+        bool woken = true;
+        m_waiters.fetch_add(1);
+        if (deadline == nullptr)
+            Futex::wait(m_sequence, seen, nullptr);
+        else
+        {
+            timespec timeout = Futex::toTimespec(remaining(*deadline));
+            woken = Futex::wait(m_sequence, seen, &timeout);
+        }
+        m_waiters.fetch_sub(1);
+        lck.lock();
+        return woken;
+    }
+
+    unsigned m_spins;                         /**< Spin budget before sleeping */
+    std::atomic<std::uint32_t> m_sequence{0}; /**< Futex word, incremented by every notification */
+    std::atomic<int> m_waiters{0};           /**< Threads sleeping or about to */
+};
+
+/**
+ * @brief Condition that wakes the most recently parked waiter first.
+ *
+ * Waiters park on a stack, each on its own futex word, and notify_one()
+ * pops the top. With several consumers on one queue, the one that just went
+ * back to sleep takes the next element while its cache is still warm, and
+ * under light load the others stay parked instead of taking turns. Wakes
+ * are never spurious; a timed out waiter leaves the stack.
+ */
+class LifoCondition : public BasicCondition<LifoCondition>
+{
+public:
+    using BasicCondition<LifoCondition>::wait;
+    using BasicCondition<LifoCondition>::wait_until;
+
+    LifoCondition() = default;
+    LifoCondition(const LifoCondition &) = delete;
+    LifoCondition &operator=(const LifoCondition &) = delete;
+
+    void notify_one()
+    {
+        if (m_waiters.load() == 0)
+            return;
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_top != nullptr)
+            wake(pop());
+    }
+
+    void notify_all()
+    {
+        if (m_waiters.load() == 0)
+            return;
+        std::lock_guard<std::mutex> guard(m_lock);
+        while (m_top != nullptr)
+            wake(pop());
+    }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        sleep<Mutex, std::chrono::steady_clock::time_point>(lck, nullptr);
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return sleep(lck, &deadline) ? std::cv_status::no_timeout : std::cv_status::timeout;
+    }
+
+private:
+    /**
+     * @brief A parked thread, on its own stack for the duration of the wait.
+     */
+    struct Waiter
+    {
+        std::atomic<std::uint32_t> woken{0}; /**< Futex word, set to 1 by the notifier */
+        Waiter *below = nullptr;             /**< Parked earlier */
+        Waiter *above = nullptr;             /**< Parked later */
+    };
+
+    /**
+     * @brief Removes the top waiter. m_lock must be held.
+     */
+    Waiter *pop()
+    {
+        Waiter *waiter = m_top;
+        m_top = waiter->below;
+        if (m_top != nullptr)
+            m_top->above = nullptr;
+        m_waiters.fetch_sub(1);
+        return waiter;
+    }
+
+    /**
+     * @brief Removes a timed out waiter from anywhere in the stack. m_lock
+     * must be held.
+     */
+    void unlink(Waiter *waiter)
+    {
+        if (waiter->above != nullptr)
+            waiter->above->below = waiter->below;
+        else
+            m_top = waiter->below;
+        if (waiter->below != nullptr)
+            waiter->below->above = waiter->above;
+        m_waiters.fetch_sub(1);
+    }
+
+    static void wake(Waiter *waiter)
+    {
+        waiter->woken.store(1, std::memory_order_release);
+        Futex::wake(waiter->woken, 1);
+    }
+
+    template <typename Mutex, typename TimePoint>
+    bool sleep(std::unique_lock<Mutex> &lck, const TimePoint *deadline)
+    {
+        // park before releasing lck, so that a notification issued after
+        // the caller's predicate check cannot miss this thread
+        Waiter self;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            self.below = m_top;
+            if (m_top != nullptr)
+                m_top->above = &self;
+            m_top = &self;
+            m_waiters.fetch_add(1);
+        }
+        lck.unlock();
+
+        while (self.woken.load(std::memory_order_acquire) == 0)
+        {
+            if (deadline == nullptr)
+                Futex::wait(self.woken, 0, nullptr);
+            else
+            {
+                std::chrono::nanoseconds left = remaining(*deadline);
+                if (left == std::chrono::nanoseconds::zero())
+                    break;
+                timespec timeout = Futex::toTimespec(left);
+                Futex::wait(self.woken, 0, &timeout);
+            }
+        }
+
+        // either leave the stack, or wait for the notifier to be done with
+        // self before it goes out of scope
+        bool woken = true;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (self.woken.load(std::memory_order_relaxed) == 0)
+            {
+                unlink(&self);
+                woken = false;
+            }
+        }
+        lck.lock();
+        return woken;
+    }
+
+    std::mutex m_lock;             /**< Guards the stack */
+    Waiter *m_top = nullptr;       /**< Most recently parked waiter */
+    std::atomic<int> m_waiters{0}; /**< Threads on the stack */
+};
+
+/**
+ * @brief Limits within which an AdaptiveCondition tunes itself.
+ */
+struct AdaptiveLimits
+{
+    std::chrono::nanoseconds max_spin{20000};  /**< Longest a waiter spins before parking, its CPU budget per wait */
+    int max_batch = 1;                         /**< Most notifications coalesced into one wake, 1 to never defer */
+    std::chrono::nanoseconds max_delay{50000}; /**< Longest a parked waiter may miss a coalesced notification */
+};
+
+/**
+ * @brief Decisions and counters of an AdaptiveCondition.
+ */
+struct AdaptiveStats
+{
+    std::chrono::nanoseconds arrival_interval; /**< Average time between notifications */
+    std::chrono::nanoseconds wait_time;        /**< Average time a waiter waited */
+    std::chrono::nanoseconds spin_budget;      /**< Current spin before parking */
+    int batch;                                 /**< Current number of notifications per wake */
+    int parked;                                /**< Waiters parked right now */
+    std::uint64_t waits;                       /**< Waits started */
+    std::uint64_t spin_hits;                   /**< Waits that ended while spinning */
+    std::uint64_t parks;                       /**< Waits that parked */
+    std::uint64_t wakes;                       /**< Wake system calls issued */
+    std::uint64_t coalesced;                   /**< Notifications that left parked waiters asleep */
+};
+
+/**
+ * @brief Condition that tunes its spin and wake batching to the traffic.
+ *
+ * Keeps moving averages of the time between notifications and of how long
+ * waiters actually wait. A waiter spins for twice the average wait if that
+ * fits in AdaptiveLimits::max_spin and parks right away otherwise, so short
+ * handoffs skip the sleep and wake system calls while long idle periods
+ * cost no CPU.
+ *
+ * With max_batch above 1, a notification arriving while waiters are parked
+ * may skip the wake when notifications are frequent: as many as arrive
+ * within max_delay, at most max_batch, are coalesced into one wake. Parked
+ * waiters then sleep at most max_delay at a time and pick up coalesced
+ * notifications on their own, which bounds the added latency.
+ *
+ * The averages are updated without locking and are estimates. stats()
+ * reports the current decisions.
+ */
+class AdaptiveCondition : public BasicCondition<AdaptiveCondition>
+{
+public:
+    using BasicCondition<AdaptiveCondition>::wait;
+    using BasicCondition<AdaptiveCondition>::wait_until;
+
+    explicit AdaptiveCondition(const AdaptiveLimits &limits = AdaptiveLimits()) { setLimits(limits); }
+
+    AdaptiveCondition(const AdaptiveCondition &) = delete;
+    AdaptiveCondition &operator=(const AdaptiveCondition &) = delete;
+
+    /**
+     * @brief Changes the limits, also while threads wait.
+     *
+     * @param limits The new limits. max_batch is raised to at least 1.
+     */
+    void setLimits(const AdaptiveLimits &limits)
+    {
+        m_max_spin.store(limits.max_spin.count(), std::memory_order_relaxed);
+        m_max_batch.store(std::max(limits.max_batch, 1), std::memory_order_relaxed);
+        m_max_delay.store(limits.max_delay.count(), std::memory_order_relaxed);
+        m_spin.store(std::min(m_spin.load(std::memory_order_relaxed), limits.max_spin.count()),
+                     std::memory_order_relaxed);
+    }
+
+    AdaptiveLimits limits() const
+    {
+        AdaptiveLimits limits;
+        limits.max_spin = std::chrono::nanoseconds(m_max_spin.load(std::memory_order_relaxed));
+        limits.max_batch = m_max_batch.load(std::memory_order_relaxed);
+        limits.max_delay = std::chrono::nanoseconds(m_max_delay.load(std::memory_order_relaxed));
+        return limits;
+    }
+
+    AdaptiveStats stats() const
+    {
+        AdaptiveStats stats;
+        stats.arrival_interval = std::chrono::nanoseconds(std::max<std::int64_t>(m_arrival.load(), 0));
+        stats.wait_time = std::chrono::nanoseconds(std::max<std::int64_t>(m_wait.load(), 0));
+        stats.spin_budget = std::chrono::nanoseconds(m_spin.load());
+        stats.batch = m_batch.load();
+        stats.parked = m_waiters.load();
+        stats.waits = m_waits.load();
+        stats.spin_hits = m_spin_hits.load();
+        stats.parks = m_parks.load();
+        stats.wakes = m_wakes.load();
+        stats.coalesced = m_coalesced.load();
+        return stats;
+    }
+
+    void notify_one()
+    {
+        std::int64_t now = nowNs();
+        std::int64_t last = m_last_notify.exchange(now, std::memory_order_relaxed);
+        if (last != 0)
+            average(m_arrival, now - last);
+        int batch = batchSize();
+        m_batch.store(batch, std::memory_order_relaxed);
+
+        m_sequence.fetch_add(1);
+        if (m_waiters.load() == 0)
+            return;
+        if (batch > 1 && m_pending.fetch_add(1, std::memory_order_relaxed) + 1 < batch)
+        {
+            m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_pending.store(0, std::memory_order_relaxed);
+        m_wakes.fetch_add(1, std::memory_order_relaxed);
+        Futex::wake(m_sequence, 1);
+    }
+
+    void notify_all()
+    {
+        // used for shutdown and bulk changes, never deferred
+        m_sequence.fetch_add(1);
+        if (m_waiters.load() != 0)
+        {
+            m_pending.store(0, std::memory_order_relaxed);
+            m_wakes.fetch_add(1, std::memory_order_relaxed);
+            Futex::wake(m_sequence, INT_MAX);
+        }
+    }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        sleep<Mutex, std::chrono::steady_clock::time_point>(lck, nullptr);
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        return sleep(lck, &deadline) ? std::cv_status::no_timeout : std::cv_status::timeout;
+    }
+
+private:
+    static std::int64_t nowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Adds a sample to a moving average with weight 1/8; the first
+     * sample replaces the initial -1.
+     */
+    static void average(std::atomic<std::int64_t> &avg, std::int64_t sample)
+    {
+        std::int64_t old = avg.load(std::memory_order_relaxed);
+        avg.store(old < 0 ? sample : old + (sample - old) / 8, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Notifications expected within max_delay, within [1, max_batch].
+     */
+    int batchSize() const
+    {
+        int max_batch = m_max_batch.load(std::memory_order_relaxed);
+        std::int64_t interval = m_arrival.load(std::memory_order_relaxed);
+        if (max_batch == 1 || interval < 0)
+            return 1;
+        std::int64_t expected = m_max_delay.load(std::memory_order_relaxed) / std::max<std::int64_t>(interval, 1);
+        return static_cast<int>(std::clamp<std::int64_t>(expected, 1, max_batch));
+    }
+
+    template <typename Mutex, typename TimePoint>
+    bool sleep(std::unique_lock<Mutex> &lck, const TimePoint *deadline)
+    {
+        std::uint32_t seen = m_sequence.load();
+        lck.unlock();
+        m_waits.fetch_add(1, std::memory_order_relaxed);
+
+        std::int64_t start = nowNs();
+        std::int64_t spin_end = start + m_spin.load(std::memory_order_relaxed);
+        bool woken = false;
+        // reading the clock costs more than a pause, check it now and then
+        for (unsigned spins = 1; !woken; spins++)
+        {
+            if (m_sequence.load(std::memory_order_acquire) != seen)
+                woken = true;
+            else if (spins % 64 == 0 && (nowNs() >= spin_end || (deadline && TimePoint::clock::now() >= *deadline)))
+                break;
+            else
+                cpuRelax();
+        }
+
+        if (woken)
+            m_spin_hits.fetch_add(1, std::memory_order_relaxed);
+        else
+            woken = park(seen, deadline);
+
+        // a timed out wait still tells how long nothing arrived
+        adapt(nowNs() - start);
+        lck.lock();
+        return woken;
+    }
+
+    /**
+     * @brief Sleeps until the sequence moves past seen or the deadline
+     * passes, waking up every max_delay while coalescing is enabled.
+     *
+     * @return bool False if the deadline passed.
+     */
+    template <typename TimePoint>
+    bool park(std::uint32_t seen, const TimePoint *deadline)
+    {
+        m_parks.fetch_add(1, std::memory_order_relaxed);
+        m_waiters.fetch_add(1);
+        bool woken = true;
+        while (m_sequence.load() == seen)
+        {
+            std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max();
+            if (m_max_batch.load(std::memory_order_relaxed) > 1)
+                timeout = std::chrono::nanoseconds(m_max_delay.load(std::memory_order_relaxed));
+            if (deadline != nullptr)
+            {
+                std::chrono::nanoseconds left = remaining(*deadline);
+                if (left == std::chrono::nanoseconds::zero())
+                {
+                    woken = false;
+                    break;
+                }
+                timeout = std::min(timeout, left);
+            }
+
+            if (timeout == std::chrono::nanoseconds::max())
+                Futex::wait(m_sequence, seen, nullptr);
+            else
+            {
+                timespec ts = Futex::toTimespec(timeout);
+                Futex::wait(m_sequence, seen, &ts);
+            }
+        }
+        m_waiters.fetch_sub(1);
+        return woken;
+    }
+
+    /**
+     * @brief Updates the average wait and the spin budget: twice the
+     * average wait if that fits in max_spin, no spinning otherwise.
+     */
+    void adapt(std::int64_t waited)
+    {
+        average(m_wait, waited);
+        std::int64_t budget = 2 * m_wait.load(std::memory_order_relaxed);
+        m_spin.store(budget <= m_max_spin.load(std::memory_order_relaxed) ? budget : 0, std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint32_t> m_sequence{0}; /**< Futex word, incremented by every notification */
+    std::atomic<int> m_waiters{0};           /**< Threads parked or about to */
+    std::atomic<int> m_pending{0};           /**< Notifications coalesced since the last wake */
+
+    std::atomic<std::int64_t> m_max_spin{0};  /**< AdaptiveLimits::max_spin in nanoseconds */
+    std::atomic<int> m_max_batch{1};          /**< AdaptiveLimits::max_batch */
+    std::atomic<std::int64_t> m_max_delay{0}; /**< AdaptiveLimits::max_delay in nanoseconds */
+
+    std::atomic<std::int64_t> m_last_notify{0}; /**< Time of the last notify_one(), 0 before the first */
+    std::atomic<std::int64_t> m_arrival{-1};    /**< Average time between notifications, -1 before the first */
+    std::atomic<std::int64_t> m_wait{-1};       /**< Average wait, -1 before the first */
+    std::atomic<std::int64_t> m_spin{INT64_MAX}; /**< Spin budget in nanoseconds, max_spin until a wait completes */
+    std::atomic<int> m_batch{1};                /**< Last computed batch size */
+
+    std::atomic<std::uint64_t> m_waits{0};     /**< See AdaptiveStats */
+    std::atomic<std::uint64_t> m_spin_hits{0}; /**< See AdaptiveStats */
+    std::atomic<std::uint64_t> m_parks{0};     /**< See AdaptiveStats */
+    std::atomic<std::uint64_t> m_wakes{0};     /**< See AdaptiveStats */
+    std::atomic<std::uint64_t> m_coalesced{0}; /**< See AdaptiveStats */
+};
+
+/**
+ * @brief Condition signalled through an eventfd, as used to integrate with
+ * poll/epoll based event loops.
+ *
+ * The eventfd works as a semaphore: every notification posts one token per
+ * woken waiter. A token posted for a waiter that already left makes a later
+ * wait return spuriously.
+ */
+class EventfdCondition : public BasicCondition<EventfdCondition>
+{
+public:
+    using BasicCondition<EventfdCondition>::wait;
+    using BasicCondition<EventfdCondition>::wait_until;
+
+    /**
+     * @throws std::system_error If the eventfd cannot be created.
+     */
+    EventfdCondition() : m_fd(::eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC))
+    {
+        if (m_fd < 0)
+            throw std::system_error(errno, std::generic_category(), "EventfdCondition: eventfd() failed");
+    }
+
+    ~EventfdCondition() { ::close(m_fd); }
+
+    EventfdCondition(const EventfdCondition &) = delete;
+    EventfdCondition &operator=(const EventfdCondition &) = delete;
+
+    /**
+     * @brief File descriptor that becomes readable on notification.
+     */
+    int fd() const { return m_fd; }
+
+    void notify_one()
+    {
+        if (m_waiters.load() != 0)
+            post(1);
+    }
+
+    void notify_all()
+    {
+        int waiters = m_waiters.load();
+        if (waiters != 0)
+            post(static_cast<std::uint64_t>(waiters));
+    }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        sleep(lck, -1);
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        // poll() takes milliseconds, round up so that the deadline has passed on timeout
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(remaining(deadline) + std::chrono::microseconds(999));
+        // past INT_MAX ms (about 24.8 days) the cast would turn negative and poll() would never time out;
+        // waking up early is a spurious wakeup, the caller waits again
+        left = std::min(left, std::chrono::milliseconds(INT_MAX));
+        sleep(lck, static_cast<int>(left.count()));
+        return Clock::now() >= deadline ? std::cv_status::timeout : std::cv_status::no_timeout;
+    }
+
+private:
+    void post(std::uint64_t tokens)
+    {
+        while (::write(m_fd, &tokens, sizeof(tokens)) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    template <typename Mutex>
+    void sleep(std::unique_lock<Mutex> &lck, int timeout_ms)
+    {
+        m_waiters.fetch_add(1);
+        lck.unlock();
+
+        pollfd pfd{m_fd, POLLIN, 0};
+        if (::poll(&pfd, 1, timeout_ms) > 0)
+        {
+            // another waiter may have taken the token first
+            std::uint64_t token;
+            (void)::read(m_fd, &token, sizeof(token));
+        }
+
+        m_waiters.fetch_sub(1);
+        lck.lock();
+    }
+
+    int m_fd;                      /**< The eventfd */
+    std::atomic<int> m_waiters{0}; /**< Threads about to poll or polling */
+};
+
+#endif
+
+#if defined(__cpp_lib_atomic_wait)
+
+/**
+ * @brief Condition built on C++20 std::atomic::wait/notify.
+ *
+ * The standard has no timed atomic wait, so wait_until() spins, yielding,
+ * until notified or the deadline passes.
+ */
+class AtomicWaitCondition : public BasicCondition<AtomicWaitCondition>
+{
+public:
+    using BasicCondition<AtomicWaitCondition>::wait;
+    using BasicCondition<AtomicWaitCondition>::wait_until;
+
+    void notify_one()
+    {
+        m_sequence.fetch_add(1, std::memory_order_release);
+        m_sequence.notify_one();
+    }
+
+    void notify_all()
+    {
+        m_sequence.fetch_add(1, std::memory_order_release);
+        m_sequence.notify_all();
+    }
+
+    template <typename Mutex>
+    void wait(std::unique_lock<Mutex> &lck)
+    {
+        std::uint32_t seen = m_sequence.load(std::memory_order_relaxed);
+        lck.unlock();
+        m_sequence.wait(seen, std::memory_order_acquire);
+        lck.lock();
+    }
+
+    template <typename Mutex, typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<Mutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        std::uint32_t seen = m_sequence.load(std::memory_order_relaxed);
+        lck.unlock();
+        std::cv_status status = std::cv_status::no_timeout;
+        while (m_sequence.load(std::memory_order_acquire) == seen)
+        {
+            if (Clock::now() >= deadline)
+            {
+                status = std::cv_status::timeout;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        lck.lock();
+        return status;
+    }
+
+private:
+    std::atomic<std::uint32_t> m_sequence{0}; /**< Incremented by every notification */
+};
+
+#endif
+
+#endif
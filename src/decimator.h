@@ -0,0 +1,403 @@
+#ifndef __DECIMATOR_H__
+#define __DECIMATOR_H__
+
+#include <cmath>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Keeps the first element of every bucket of n elements.
+ *
+ * @tparam T The type of the elements.
+ */
+template <typename T>
+class KeepEveryNth
+{
+public:
+    using value_type = T;
+
+    /**
+     * @brief Constructs the policy.
+     *
+     * @param n Bucket size.
+     *
+     * @throws std::invalid_argument If n is less than 1.
+     */
+    explicit KeepEveryNth(int n) : m_n(n), m_seen()
+    {
+        if (n < 1)
+            throw std::invalid_argument("KeepEveryNth: bucket size must be positive");
+    }
+
+    template <typename Emit>
+    void add(const T &value, Emit &&emit)
+    {
+        if (m_seen == 0)
+            emit(value);
+        m_seen = m_seen + 1 == m_n ? 0 : m_seen + 1;
+    }
+
+    template <typename Emit>
+    void flush(Emit &&) { m_seen = 0; }
+
+private:
+    int m_n;    /**< Bucket size */
+    int m_seen; /**< Elements seen in the current bucket */
+};
+
+/**
+ * @brief Emits the mean of every bucket of n elements.
+ *
+ * @tparam T An arithmetic element type.
+ */
+template <typename T>
+class BucketMean
+{
+    static_assert(std::is_arithmetic<T>::value, "BucketMean: T must be arithmetic");
+
+public:
+    using value_type = T;
+
+    /**
+     * @brief Constructs the policy.
+     *
+     * @param n Bucket size.
+     *
+     * @throws std::invalid_argument If n is less than 1.
+     */
+    explicit BucketMean(int n) : m_n(n), m_seen(), m_sum()
+    {
+        if (n < 1)
+            throw std::invalid_argument("BucketMean: bucket size must be positive");
+    }
+
+    template <typename Emit>
+    void add(const T &value, Emit &&emit)
+    {
+        m_sum += static_cast<double>(value);
+        if (++m_seen == m_n)
+            flush(emit);
+    }
+
+    template <typename Emit>
+    void flush(Emit &&emit)
+    {
+        if (m_seen != 0)
+        {
+            double mean = m_sum / m_seen;
+            emit(static_cast<T>(std::is_integral<T>::value ? std::round(mean) : mean));
+        }
+        m_seen = 0;
+        m_sum = 0;
+    }
+
+private:
+    int m_n;      /**< Bucket size */
+    int m_seen;   /**< Elements seen in the current bucket */
+    double m_sum; /**< Sum of the current bucket */
+};
+
+/**
+ * @brief Emits the minimum and the maximum of every bucket of n elements, in
+ * the order in which they occurred, so that peaks survive decimation.
+ *
+ * @tparam T A type ordered by operator<.
+ */
+template <typename T>
+class BucketMinMax
+{
+public:
+    using value_type = T;
+
+    /**
+     * @brief Constructs the policy.
+     *
+     * @param n Bucket size.
+     *
+     * @throws std::invalid_argument If n is less than 1.
+     */
+    explicit BucketMinMax(int n) : m_n(n), m_seen(), m_min_index(), m_max_index()
+    {
+        if (n < 1)
+            throw std::invalid_argument("BucketMinMax: bucket size must be positive");
+    }
+
+    template <typename Emit>
+    void add(const T &value, Emit &&emit)
+    {
+        if (m_seen == 0 || value < *m_min)
+        {
+            m_min.reset(value);
+            m_min_index = m_seen;
+        }
+        if (m_seen == 0 || *m_max < value)
+        {
+            m_max.reset(value);
+            m_max_index = m_seen;
+        }
+
+        if (++m_seen == m_n)
+            flush(emit);
+    }
+
+    template <typename Emit>
+    void flush(Emit &&emit)
+    {
+        if (m_seen == 0)
+            return;
+
+        if (m_min_index == m_max_index)
+            emit(*m_min);
+        else if (m_min_index < m_max_index)
+        {
+            emit(*m_min);
+            emit(*m_max);
+        }
+        else
+        {
+            emit(*m_max);
+            emit(*m_min);
+        }
+        m_seen = 0;
+    }
+
+private:
+    /**
+     * @brief Storage for one candidate that does not need T to be default constructible.
+     */
+    class Slot
+    {
+    public:
+        Slot() : m_full(false) {}
+        ~Slot() { clear(); }
+        void reset(const T &value)
+        {
+            clear();
+            new (&m_storage) T(value);
+            m_full = true;
+        }
+        const T &operator*() const { return *reinterpret_cast<const T *>(&m_storage); }
+
+    private:
+        void clear()
+        {
+            if (m_full)
+                reinterpret_cast<T *>(&m_storage)->~T();
+            m_full = false;
+        }
+
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+        bool m_full;
+    };
+
+    int m_n;         /**< Bucket size */
+    int m_seen;      /**< Elements seen in the current bucket */
+    Slot m_min;      /**< Smallest element of the bucket */
+    Slot m_max;      /**< Largest element of the bucket */
+    int m_min_index; /**< Position of the minimum in the bucket */
+    int m_max_index; /**< Position of the maximum in the bucket */
+};
+
+/**
+ * @brief Streaming Largest-Triangle-Three-Buckets downsampling.
+ *
+ * Keeps the first element, then from each bucket of n elements the one that
+ * forms the largest triangle with the previously kept element and the mean
+ * of the following bucket, with the element index as x coordinate. This
+ * keeps the visual shape of the signal, peaks included, at one element per
+ * bucket. The choice for a bucket needs the next bucket, so output lags by
+ * one bucket; flush() emits the pending buckets and the last element.
+ *
+ * @tparam T An arithmetic element type.
+ */
+template <typename T>
+class Lttb
+{
+    static_assert(std::is_arithmetic<T>::value, "Lttb: T must be arithmetic");
+
+public:
+    using value_type = T;
+
+    /**
+     * @brief Constructs the policy.
+     *
+     * @param n Bucket size.
+     *
+     * @throws std::invalid_argument If n is less than 1.
+     */
+    explicit Lttb(int n)
+        : m_n(n), m_current(), m_next(), m_current_size(), m_next_size(),
+          m_index(), m_current_start(), m_kept(), m_kept_x(), m_has_kept(false)
+    {
+        if (n < 1)
+            throw std::invalid_argument("Lttb: bucket size must be positive");
+        m_current.reset(new T[n]);
+        m_next.reset(new T[n]);
+    }
+
+    template <typename Emit>
+    void add(const T &value, Emit &&emit)
+    {
+        long long x = m_index++;
+        if (!m_has_kept)
+        {
+            emit(value);
+            m_kept = value;
+            m_kept_x = x;
+            m_has_kept = true;
+            m_current_start = m_index;
+            return;
+        }
+
+        if (m_current_size < m_n)
+        {
+            m_current[m_current_size++] = value;
+            return;
+        }
+
+        m_next[m_next_size++] = value;
+        if (m_next_size == m_n)
+        {
+            double sum = 0;
+            for (int i = 0; i < m_next_size; i++)
+                sum += static_cast<double>(m_next[i]);
+            double next_x = static_cast<double>(m_current_start + m_n) + (m_n - 1) / 2.0;
+            select(next_x, sum / m_next_size, emit);
+            advance();
+        }
+    }
+
+    template <typename Emit>
+    void flush(Emit &&emit)
+    {
+        if (m_current_size != 0)
+        {
+            if (m_next_size != 0)
+            {
+                double sum = 0;
+                for (int i = 0; i < m_next_size; i++)
+                    sum += static_cast<double>(m_next[i]);
+                double next_x = static_cast<double>(m_current_start + m_n) + (m_next_size - 1) / 2.0;
+                select(next_x, sum / m_next_size, emit);
+                // the last element is always kept
+                emit(m_next[m_next_size - 1]);
+            }
+            else
+                emit(m_current[m_current_size - 1]);
+        }
+
+        m_current_size = 0;
+        m_next_size = 0;
+        m_has_kept = false;
+    }
+
+private:
+    /**
+     * @brief Emits the element of the current bucket with the largest triangle.
+     */
+    template <typename Emit>
+    void select(double next_x, double next_y, Emit &emit)
+    {
+        double ax = static_cast<double>(m_kept_x);
+        double ay = static_cast<double>(m_kept);
+        int best = 0;
+        double best_area = -1;
+        for (int i = 0; i < m_current_size; i++)
+        {
+            double px = static_cast<double>(m_current_start + i);
+            double py = static_cast<double>(m_current[i]);
+            double area = std::fabs((ax - next_x) * (py - ay) - (ax - px) * (next_y - ay));
+            if (area > best_area)
+            {
+                best_area = area;
+                best = i;
+            }
+        }
+
+        emit(m_current[best]);
+        m_kept = m_current[best];
+        m_kept_x = m_current_start + best;
+    }
+
+    /**
+     * @brief The next bucket becomes the current one.
+     */
+    void advance()
+    {
+        std::swap(m_current, m_next);
+        m_current_size = m_next_size;
+        m_next_size = 0;
+        m_current_start += m_n;
+    }
+
+    int m_n;                        /**< Bucket size */
+    std::unique_ptr<T[]> m_current; /**< Bucket to choose from */
+    std::unique_ptr<T[]> m_next;    /**< Following bucket, gives the third triangle point */
+    int m_current_size;             /**< Elements in the current bucket */
+    int m_next_size;                /**< Elements in the next bucket */
+    long long m_index;              /**< Index of the next element */
+    long long m_current_start;      /**< Index of the first element of the current bucket */
+    T m_kept;                       /**< Last kept element */
+    long long m_kept_x;             /**< Index of the last kept element */
+    bool m_has_kept;                /**< An element was kept already */
+};
+
+/**
+ * @brief Decimating front end of a queue.
+ *
+ * Runs every pushed element through a decimation policy and forwards only the
+ * elements the policy keeps to the queue, so discarded elements never take
+ * the queue lock and are never stored. A decimator holds per-stream state
+ * and is meant to be owned by a single producer; several producers each use
+ * their own decimator in front of the same queue.
+ *
+ * @tparam QueueT The queue type, anything with push(const T&).
+ * @tparam Policy KeepEveryNth, BucketMean, BucketMinMax, Lttb or any type
+ * with add(value, emit) and flush(emit).
+ */
+template <typename QueueT, typename Policy>
+class Decimator
+{
+public:
+    using value_type = typename Policy::value_type;
+
+    /**
+     * @brief Constructs a decimator in front of a queue.
+     *
+     * @param queue The queue receiving the kept elements.
+     * @param args Arguments of the policy constructor, usually the bucket size.
+     */
+    template <typename... Args>
+    Decimator(QueueT &queue, Args &&...args) : m_queue(queue), m_policy(std::forward<Args>(args)...) {}
+
+    /**
+     * @brief Offers an element to the policy.
+     *
+     * @param element The element produced.
+     */
+    void push(const value_type &element)
+    {
+        m_policy.add(element, [this](const value_type &kept)
+                     { m_queue.push(kept); });
+    }
+
+    /**
+     * @brief Forwards whatever the policy still holds, e.g. at end of stream.
+     */
+    void flush()
+    {
+        m_policy.flush([this](const value_type &kept)
+                       { m_queue.push(kept); });
+    }
+
+    Policy &policy() { return m_policy; }
+
+private:
+    QueueT &m_queue; /**< Queue receiving the kept elements */
+    Policy m_policy; /**< Decimation policy */
+};
+
+#endif
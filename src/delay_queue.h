@@ -0,0 +1,424 @@
+#ifndef __DELAY_QUEUE_H__
+#define __DELAY_QUEUE_H__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include "queue.h"
+
+/**
+ * @brief A queue whose elements become visible at a scheduled time.
+ *
+ * push() takes the time an element is due; pop() returns due elements only,
+ * waiting until the earliest one is due. Pending elements are kept in a
+ * hierarchical timing wheel: four levels of 64 slots, each level covering
+ * 64 times the range of the one below, so scheduling an element is O(1)
+ * whatever the number pending. Elements move down a level at most four
+ * times before they are due; those beyond the wheel's range (2^24 ticks)
+ * wait in an overflow list that is revisited once per range.
+ *
+ * A consumer with nothing due sleeps in a single timed wait until the next
+ * slot needs attention; a push that is due earlier wakes it up. A consumer
+ * leaving while elements are pending wakes another one, which takes over
+ * the timed wait, so no pending element is left without a waiter. Elements
+ * are released no earlier than their due time and at most one tick later
+ * than it, in the order they became due. Storage for every element is
+ * allocated at construction; a producer waits while the queue is full.
+ *
+ * @tparam T The type of the elements.
+ * @tparam Traits Compile-time configuration, see DefaultQueueTraits.
+ */
+template <typename T, typename Traits = DefaultQueueTraits>
+class DelayQueue
+{
+public:
+    using mutex_type = typename Traits::mutex_type;
+    using condition_type = typename Traits::condition_type;
+    using clock_type = typename Traits::clock_type;
+    using duration = typename clock_type::duration;
+    using time_point = typename clock_type::time_point;
+
+    DelayQueue() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs an empty queue.
+     *
+     * @param size The maximum number of elements, due or not.
+     * @param tick Resolution of the wheel: how late past its due time an
+     * element may be released.
+     *
+     * @throws std::invalid_argument If tick is not positive.
+     */
+    explicit DelayQueue(int size, duration tick = std::chrono::duration_cast<duration>(std::chrono::milliseconds(1)))
+        : m_data(nullptr), m_due(nullptr), m_link(nullptr), m_capacity(size), m_filled(), m_free(size > 0 ? 0 : kNone),
+          m_tick(tick), m_epoch(clock_type::now()), m_current(), m_next_wake(kNever), m_sleepers(),
+          m_occupied()
+    {
+        if (tick <= duration::zero())
+            throw std::invalid_argument("DelayQueue: tick must be positive");
+
+        m_data = static_cast<T *>(operator new(size * sizeof(T)));
+        m_due = new std::uint64_t[size];
+        m_link = new int[size];
+        for (int i = 0; i < size; i++)
+            m_link[i] = i + 1 < size ? i + 1 : kNone;
+    }
+
+    DelayQueue(const DelayQueue &) = delete;
+    DelayQueue &operator=(const DelayQueue &) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys the pending elements, releasing allocated memory.
+     */
+    ~DelayQueue()
+    {
+        destroy(m_ready);
+        destroy(m_overflow);
+        for (auto &level : m_wheel)
+            for (List &list : level)
+                destroy(list);
+        operator delete(m_data);
+        delete[] m_due;
+        delete[] m_link;
+    }
+
+    /**
+     * @brief Schedules an element, waiting while the queue is full.
+     *
+     * @param element The element.
+     * @param ready_at When the element becomes visible to pop(); a time in
+     * the past makes it visible at once.
+     */
+    void push(T element, time_point ready_at)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        space_cv.wait(lck, [this]()
+                      { return m_filled != m_capacity; });
+
+        int node = m_free;
+        m_free = m_link[node];
+        new (m_data + node) T(std::move(element));
+        m_due[node] = tickAt(ready_at);
+        m_filled += 1;
+        place(node);
+
+        // wake a consumer if this is due before whatever it sleeps for
+        std::uint64_t due = m_due[node];
+        if (due <= m_current || due < m_next_wake)
+        {
+            if (due < m_next_wake)
+                m_next_wake = due;
+            cv.notify_one();
+        }
+    }
+
+    /**
+     * @brief Removes the element that became due first, waiting until one
+     * is due.
+     *
+     * @return T The element.
+     */
+    T pop()
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        while (true)
+        {
+            advance();
+            if (m_ready.head != kNone)
+                return take();
+
+            std::uint64_t next = nextEvent();
+            time_point until = next == kNever ? time_point() : timeOf(next);
+            sleep(lck, next, next == kNever ? nullptr : &until);
+        }
+    }
+
+    /**
+     * @brief Removes the element that became due first, with a timeout.
+     *
+     * @param milliseconds_val The timeout period in milliseconds.
+     * @return T The element.
+     *
+     * @throws std::system_error If no element is due within the timeout.
+     */
+    T popWithTimeout(int milliseconds_val)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        time_point deadline = clock_type::now() + std::chrono::milliseconds(milliseconds_val);
+        while (true)
+        {
+            advance();
+            if (m_ready.head != kNone)
+                return take();
+            if (clock_type::now() >= deadline)
+            {
+                // the timed wait may have been this thread's, hand it over
+                if (m_filled != 0)
+                    cv.notify_one();
+                throw std::system_error{std::make_error_code(std::errc::operation_would_block),
+                                        "DelayQueue: pop() timeout"};
+            }
+
+            std::uint64_t next = nextEvent();
+            time_point until = next == kNever || timeOf(next) > deadline ? deadline : timeOf(next);
+            sleep(lck, next, &until);
+        }
+    }
+
+    /**
+     * @brief Removes the element that became due first, if one is due.
+     *
+     * @param element Receives the element on success.
+     * @return bool False if no element is due.
+     */
+    bool tryPop(T &element)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        advance();
+        if (m_ready.head == kNone)
+            return false;
+
+        element = take();
+        return true;
+    }
+
+    /**
+     * @brief Number of elements, due or not.
+     */
+    int count() const { return m_filled; }
+
+    /**
+     * @brief Maximum number of elements.
+     */
+    int size() const { return m_capacity; }
+
+    /**
+     * @brief Resolution of the wheel.
+     */
+    duration tick() const { return m_tick; }
+
+private:
+    static constexpr int kLevels = 4;                   /**< Wheel levels */
+    static constexpr int kBits = 6;                     /**< log2 of the slots per level */
+    static constexpr int kSlots = 1 << kBits;           /**< Slots per level */
+    static constexpr int kNone = -1;                    /**< End of a list */
+    static constexpr std::uint64_t kNever = UINT64_MAX; /**< No event pending */
+
+    /**
+     * @brief Singly linked FIFO list of nodes, through m_link.
+     */
+    struct List
+    {
+        int head = kNone;
+        int tail = kNone;
+    };
+
+    void append(List &list, int node)
+    {
+        m_link[node] = kNone;
+        if (list.tail == kNone)
+            list.head = node;
+        else
+            m_link[list.tail] = node;
+        list.tail = node;
+    }
+
+    void destroy(const List &list)
+    {
+        for (int node = list.head; node != kNone; node = m_link[node])
+            (m_data + node)->~T();
+    }
+
+    /**
+     * @brief First tick at or after a time, so that no element is early.
+     */
+    std::uint64_t tickAt(time_point t) const
+    {
+        if (t <= m_epoch)
+            return 0;
+        auto ticks = ((t - m_epoch) + m_tick - duration(1)) / m_tick;
+        return static_cast<std::uint64_t>(ticks);
+    }
+
+    time_point timeOf(std::uint64_t tick) const { return m_epoch + m_tick * static_cast<typename duration::rep>(tick); }
+
+    /**
+     * @brief Puts a node where its due tick belongs relative to m_current:
+     * the ready list, the lowest level whose slot range contains it, or the
+     * overflow list.
+     *
+     * At the chosen level the due tick's digit is above m_current's, so an
+     * occupied slot never lies behind the wheel's position.
+     */
+    void place(int node)
+    {
+        std::uint64_t due = m_due[node];
+        if (due <= m_current)
+        {
+            append(m_ready, node);
+            return;
+        }
+        for (int level = 0; level < kLevels; level++)
+        {
+            if (((due ^ m_current) >> (kBits * (level + 1))) == 0)
+            {
+                int slot = static_cast<int>((due >> (kBits * level)) & (kSlots - 1));
+                append(m_wheel[level][slot], node);
+                m_occupied[level] |= std::uint64_t(1) << slot;
+                return;
+            }
+        }
+        append(m_overflow, node);
+    }
+
+    /**
+     * @brief Tick at which the first occupied slot of a level is reached.
+     */
+    std::uint64_t slotStart(int level, int slot) const
+    {
+        std::uint64_t block = m_current >> (kBits * (level + 1)) << (kBits * (level + 1));
+        return block | (static_cast<std::uint64_t>(slot) << (kBits * level));
+    }
+
+    std::uint64_t overflowStart() const { return ((m_current >> (kBits * kLevels)) + 1) << (kBits * kLevels); }
+
+    /**
+     * @brief Earliest tick at which some list must be processed.
+     */
+    std::uint64_t nextEvent() const
+    {
+        std::uint64_t next = kNever;
+        for (int level = 0; level < kLevels; level++)
+            if (m_occupied[level] != 0)
+                next = std::min(next, slotStart(level, __builtin_ctzll(m_occupied[level])));
+        if (m_overflow.head != kNone)
+            next = std::min(next, overflowStart());
+        return next;
+    }
+
+    /**
+     * @brief Moves the wheel to the current time, processing each slot
+     * reached on the way; skips directly over empty stretches.
+     */
+    void advance()
+    {
+        std::uint64_t now = static_cast<std::uint64_t>((clock_type::now() - m_epoch) / m_tick);
+        for (std::uint64_t next = nextEvent(); next <= now; next = nextEvent())
+        {
+            m_current = next;
+            for (int level = 0; level < kLevels; level++)
+            {
+                if (m_occupied[level] == 0)
+                    continue;
+                int slot = __builtin_ctzll(m_occupied[level]);
+                if (slotStart(level, slot) != next)
+                    continue;
+                List list = m_wheel[level][slot];
+                m_wheel[level][slot] = List();
+                m_occupied[level] &= ~(std::uint64_t(1) << slot);
+                replace(list);
+            }
+            if (m_overflow.head != kNone && next % (std::uint64_t(1) << (kBits * kLevels)) == 0)
+            {
+                List list = m_overflow;
+                m_overflow = List();
+                replace(list);
+            }
+        }
+        if (now > m_current)
+            m_current = now;
+    }
+
+    /**
+     * @brief Places every node of a detached list again, one level lower
+     * or into the ready list.
+     */
+    void replace(const List &list)
+    {
+        int node = list.head;
+        while (node != kNone)
+        {
+            int next = m_link[node];
+            place(node);
+            node = next;
+        }
+    }
+
+    /**
+     * @brief Waits on cv, publishing the tick the wait ends at so that
+     * push() knows whether to wake the sleepers. The lock must be held.
+     *
+     * @param lck The held lock.
+     * @param next Tick of the next event, kNever if none.
+     * @param until End of the wait, nullptr to wait until notified.
+     */
+    void sleep(std::unique_lock<mutex_type> &lck, std::uint64_t next, const time_point *until)
+    {
+        m_next_wake = next;
+        m_sleepers += 1;
+        if (until == nullptr)
+            cv.wait(lck);
+        else
+            cv.wait_until(lck, *until);
+        m_sleepers -= 1;
+        // nobody sleeps on the published tick any more
+        if (m_sleepers == 0)
+            m_next_wake = kNever;
+    }
+
+    /**
+     * @brief Removes the head of the ready list. The lock must be held and
+     * the list must not be empty.
+     */
+    T take()
+    {
+        int node = m_ready.head;
+        m_ready.head = m_link[node];
+        if (m_ready.head == kNone)
+            m_ready.tail = kNone;
+
+        T element = std::move(*(m_data + node));
+        (m_data + node)->~T();
+        m_link[node] = m_free;
+        m_free = node;
+        m_filled -= 1;
+
+        space_cv.notify_one();
+        // more may be due, or the timed wait may have been this thread's:
+        // let another consumer take over
+        if (m_filled != 0)
+            cv.notify_one();
+        return element;
+    }
+
+    T *m_data;                 /**< Element storage, one per node */
+    std::uint64_t *m_due;      /**< Due tick of each node */
+    int *m_link;               /**< Next node in the node's list */
+    int m_capacity;            /**< Number of nodes */
+    int m_filled;              /**< Number of elements, due or not */
+    int m_free;                /**< Head of the free node list */
+    duration m_tick;           /**< Wheel resolution */
+    time_point m_epoch;        /**< Time of tick 0 */
+    std::uint64_t m_current;   /**< Tick the wheel has advanced to */
+    std::uint64_t m_next_wake; /**< Tick sleeping consumers wake up at, kNever if none */
+    int m_sleepers;            /**< Consumers waiting on cv */
+
+    List m_wheel[kLevels][kSlots];     /**< Pending nodes by level and slot */
+    std::uint64_t m_occupied[kLevels]; /**< Non-empty slots per level */
+    List m_overflow;                   /**< Pending nodes beyond the wheel's range */
+    List m_ready;                      /**< Due nodes, in the order they became due */
+
+    mutex_type mtx{};          /**< Mutex for thread safety */
+    condition_type cv{};       /**< Signals consumers: an element is due earlier */
+    condition_type space_cv{}; /**< Signals producers: a node was freed */
+};
+
+#endif
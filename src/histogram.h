@@ -0,0 +1,199 @@
+#ifndef __HISTOGRAM_H__
+#define __HISTOGRAM_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A lock-free log-linear histogram of non-negative integer values.
+ *
+ * Values are bucketed with 16 linear sub-buckets per power of two, giving a
+ * relative error below 6.25% over the whole 64-bit range. Recording is a
+ * single relaxed atomic increment (plus sum/max updates), so any number of
+ * threads may record and read concurrently without a lock.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 4;                           /**< log2 of sub-buckets per power of two */
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;            /**< Sub-buckets per power of two */
+    static constexpr int kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets; /**< Total number of buckets */
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    /**
+     * @brief Records one value.
+     *
+     * @param value Value to record, usually nanoseconds.
+     */
+    void record(std::uint64_t value)
+    {
+        m_counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+
+        std::uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Records one value when all writers are serialized externally.
+     *
+     * Same as record() but with plain loads and stores instead of atomic
+     * read-modify-write operations, for callers that already hold a lock.
+     * Readers may still run concurrently without locking.
+     *
+     * @param value Value to record, usually nanoseconds.
+     */
+    void recordSerialized(std::uint64_t value)
+    {
+        auto &bucket = m_counts[bucketOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        if (value > m_max.load(std::memory_order_relaxed))
+            m_max.store(value, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of recorded values.
+     *
+     * @return std::uint64_t Count of values.
+     */
+    std::uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Largest recorded value (exact).
+     *
+     * @return std::uint64_t Maximum value, 0 if empty.
+     */
+    std::uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Mean of the recorded values (exact up to concurrent updates).
+     *
+     * @return double Mean value, 0 if empty.
+     */
+    double mean() const
+    {
+        std::uint64_t n = count();
+        return n == 0 ? 0.0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+    }
+
+    /**
+     * @brief Value below which the given fraction of the recorded values fall.
+     *
+     * The result is the upper bound of the bucket containing the percentile,
+     * capped at the exact maximum.
+     *
+     * @param fraction Percentile as a fraction in [0, 1], e.g. 0.99.
+     * @return std::uint64_t Percentile value, 0 if empty.
+     */
+    std::uint64_t percentile(double fraction) const
+    {
+        std::uint64_t total = 0;
+        std::uint64_t counts[kBuckets];
+        for (int i = 0; i < kBuckets; i++)
+        {
+            counts[i] = m_counts[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        if (total == 0)
+            return 0;
+
+        std::uint64_t rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5);
+        if (rank == 0)
+            rank = 1;
+
+        std::uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                std::uint64_t upper = upperBound(i);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    /**
+     * @brief Adds the values recorded by another histogram.
+     *
+     * Lets every thread record into its own histogram without contention
+     * and combine them afterwards.
+     *
+     * @param other Histogram to add.
+     */
+    void merge(const LatencyHistogram &other)
+    {
+        for (int i = 0; i < kBuckets; i++)
+            m_counts[i].fetch_add(other.m_counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_count.fetch_add(other.count(), std::memory_order_relaxed);
+        m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+        std::uint64_t value = other.max();
+        std::uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Clears all recorded values.
+     */
+    void reset()
+    {
+        for (auto &count : m_counts)
+            count.store(0, std::memory_order_relaxed);
+        m_count.store(0, std::memory_order_relaxed);
+        m_sum.store(0, std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Index of the bucket holding a value.
+     *
+     * @param value Recorded value.
+     * @return int Bucket index.
+     */
+    static int bucketOf(std::uint64_t value)
+    {
+        if (value < kSubBuckets)
+            return static_cast<int>(value);
+
+        int msb = 63 - __builtin_clzll(value);
+        int shift = msb - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + static_cast<int>((value >> shift) - kSubBuckets);
+    }
+
+    /**
+     * @brief Largest value that falls into a bucket.
+     *
+     * @param bucket Bucket index.
+     * @return std::uint64_t Inclusive upper bound.
+     */
+    static std::uint64_t upperBound(int bucket)
+    {
+        if (bucket < kSubBuckets)
+            return static_cast<std::uint64_t>(bucket);
+
+        int shift = bucket / kSubBuckets - 1;
+        std::uint64_t mantissa = static_cast<std::uint64_t>(bucket % kSubBuckets + kSubBuckets);
+        return (mantissa << shift) + ((std::uint64_t{1} << shift) - 1);
+    }
+
+private:
+    std::atomic<std::uint64_t> m_counts[kBuckets]{}; /**< Per-bucket counts */
+    std::atomic<std::uint64_t> m_count{0};           /**< Total number of values */
+    std::atomic<std::uint64_t> m_sum{0};             /**< Sum of all values */
+    std::atomic<std::uint64_t> m_max{0};             /**< Largest value */
+};
+
+#endif
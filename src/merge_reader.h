@@ -0,0 +1,211 @@
+#ifndef __MERGE_READER_H__
+#define __MERGE_READER_H__
+
+#include <algorithm>
+#include <climits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Merges several queues into one stream ordered by timestamp.
+ *
+ * Each input queue must receive its elements in non-decreasing timestamp
+ * order, e.g. one queue per sensor. The reader keeps the oldest element of
+ * every input in a min-heap and emits the smallest one, but only once it is
+ * safe: an input with nothing queued could still deliver an older element,
+ * so output is held back until every input has advanced past the timestamp
+ * about to be emitted. An input advances by delivering an element, by an
+ * explicit watermark (advance(), e.g. from a heartbeat) or by being closed.
+ *
+ * The reader polls the queues with tryPop() and never blocks; it is meant
+ * for a single consumer thread. Elements must be default constructible.
+ *
+ * @tparam QueueT The input queue type, anything with value_type and
+ * bool tryPop(value_type &), e.g. Queue.
+ * @tparam KeyFn Callable returning the timestamp of an element, any type
+ * ordered with <.
+ */
+template <typename QueueT, typename KeyFn>
+class MergeReader
+{
+public:
+    using value_type = typename QueueT::value_type;
+    using key_type = typename std::decay<decltype(std::declval<KeyFn &>()(std::declval<const value_type &>()))>::type;
+
+    /**
+     * @brief Constructs a reader over the given queues.
+     *
+     * @param inputs The queues, which must outlive the reader.
+     * @param key Extracts the timestamp of an element.
+     */
+    explicit MergeReader(const std::vector<QueueT *> &inputs, KeyFn key = KeyFn()) : m_key(std::move(key))
+    {
+        m_inputs.reserve(inputs.size());
+        for (QueueT *queue : inputs)
+            m_inputs.push_back(Input{queue, std::nullopt, key_type(), false, false});
+        m_heap.reserve(inputs.size());
+    }
+
+    /**
+     * @brief Emits the elements that are safe to emit, oldest first.
+     *
+     * Does not wait: returns as soon as an input with nothing queued holds
+     * back the next element, or after max elements.
+     *
+     * @param out Output iterator receiving the elements.
+     * @param max Largest number of elements to emit in this batch.
+     * @return int Number of elements emitted.
+     */
+    template <typename OutputIt>
+    int poll(OutputIt out, int max = INT_MAX)
+    {
+        for (std::size_t i = 0; i < m_inputs.size(); i++)
+            if (!m_inputs[i].head)
+                refill(i);
+
+        // an open input with nothing queued holds back everything after
+        // its watermark
+        Limit limit;
+        for (const Input &input : m_inputs)
+            if (!input.head && !input.closed)
+                limit.lower(input);
+
+        int emitted = 0;
+        while (emitted < max && !m_heap.empty())
+        {
+            std::size_t i = m_heap.front();
+            Input &input = m_inputs[i];
+            key_type key = m_key(*input.head);
+            if (!limit.allows(key))
+                break;
+
+            std::pop_heap(m_heap.begin(), m_heap.end(), Later{this});
+            m_heap.pop_back();
+            *out++ = std::move(*input.head);
+            input.head.reset();
+            emitted++;
+
+            // an earlier advance() may have declared a later watermark
+            if (!input.has_watermark || input.watermark < key)
+                input.watermark = key;
+            input.has_watermark = true;
+            if (!refill(i) && !input.closed)
+                limit.lower(input);
+        }
+        return emitted;
+    }
+
+    /**
+     * @brief Declares that an input will deliver nothing older than a
+     * timestamp, releasing output held back by it.
+     *
+     * @param input Index of the input, in the order given to the constructor.
+     * @param watermark Timestamp the input has advanced to.
+     */
+    void advance(int input, const key_type &watermark)
+    {
+        Input &in = m_inputs.at(input);
+        if (!in.has_watermark || in.watermark < watermark)
+            in.watermark = watermark;
+        in.has_watermark = true;
+    }
+
+    /**
+     * @brief Declares that an input will receive no more elements. What is
+     * already queued is still emitted.
+     *
+     * @param input Index of the input, in the order given to the constructor.
+     */
+    void close(int input) { m_inputs.at(input).closed = true; }
+
+    /**
+     * @brief Number of inputs.
+     */
+    int inputs() const { return static_cast<int>(m_inputs.size()); }
+
+    /**
+     * @brief Whether every input is closed and every element emitted.
+     */
+    bool done()
+    {
+        for (std::size_t i = 0; i < m_inputs.size(); i++)
+            if (!m_inputs[i].closed || m_inputs[i].head || refill(i))
+                return false;
+        return true;
+    }
+
+private:
+    struct Input
+    {
+        QueueT *queue;                  /**< Source queue */
+        std::optional<value_type> head; /**< Oldest element taken from the queue, not yet emitted */
+        key_type watermark;             /**< Nothing older will come from this input */
+        bool has_watermark;             /**< watermark is set */
+        bool closed;                    /**< No more elements will be pushed */
+    };
+
+    /**
+     * @brief Latest timestamp that may be emitted, the smallest watermark of
+     * the open inputs with nothing queued.
+     */
+    struct Limit
+    {
+        bool held = false;    /**< Some input holds output back */
+        bool blocked = false; /**< Some input never advanced: nothing may be emitted */
+        key_type key{};       /**< Smallest watermark of the holding inputs */
+
+        void lower(const Input &input)
+        {
+            if (!input.has_watermark)
+                blocked = true;
+            else if (!held || input.watermark < key)
+                key = input.watermark;
+            held = true;
+        }
+
+        bool allows(const key_type &k) const { return !held || (!blocked && !(key < k)); }
+    };
+
+    /**
+     * @brief Heap order: the input with the later head sinks, ties go to the
+     * lower input index.
+     */
+    struct Later
+    {
+        const MergeReader *reader;
+
+        bool operator()(std::size_t a, std::size_t b) const
+        {
+            const key_type ka = reader->m_key(*reader->m_inputs[a].head);
+            const key_type kb = reader->m_key(*reader->m_inputs[b].head);
+            return kb < ka || (!(ka < kb) && b < a);
+        }
+    };
+
+    /**
+     * @brief Takes the next element of an input into its head.
+     *
+     * @return bool False if the input queue was empty.
+     */
+    bool refill(std::size_t i)
+    {
+        Input &input = m_inputs[i];
+        value_type element;
+        if (!input.queue->tryPop(element))
+            return false;
+
+        input.head = std::move(element);
+        m_heap.push_back(i);
+        std::push_heap(m_heap.begin(), m_heap.end(), Later{this});
+        return true;
+    }
+
+    mutable KeyFn m_key;             /**< Timestamp of an element */
+    std::vector<Input> m_inputs;     /**< Per-input state */
+    std::vector<std::size_t> m_heap; /**< Inputs with a head, min-heap on the head timestamp */
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef __MESSAGE_QUEUE_H__
+#define __MESSAGE_QUEUE_H__
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "queue.h"
+
+/**
+ * @brief Combines lambdas into one visitor with an overload per message type.
+ *
+ * `queue.pop(Overloaded{[](const Start &s) {...}, [](const Stop &s) {...}});`
+ */
+template <typename... Handlers>
+struct Overloaded : Handlers...
+{
+    using Handlers::operator()...;
+};
+
+template <typename... Handlers>
+Overloaded(Handlers...) -> Overloaded<Handlers...>;
+
+/**
+ * @brief A Queue carrying several message types, stored inline.
+ *
+ * Every slot is a std::variant of the message types, so it is as large as
+ * the largest message and no message is allocated on its own. Consumers
+ * pass a visitor to pop(), which is called with the message as its concrete
+ * type through the variant's dispatch table instead of a virtual call.
+ *
+ * Keep the types small or of similar size: every slot pays for the largest
+ * one. Large or variable-length payloads belong in an ObjectPool or a
+ * ByteRing.
+ *
+ * @tparam Traits Compile-time configuration, see DefaultQueueTraits.
+ * @tparam Msgs The message types, each at most once.
+ */
+template <typename Traits, typename... Msgs>
+class BasicMessageQueue
+{
+public:
+    using message_type = std::variant<Msgs...>;
+
+    BasicMessageQueue() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a queue with a specified capacity.
+     *
+     * @param size The maximum number of messages that the queue can hold.
+     */
+    explicit BasicMessageQueue(int size) : m_queue(size) {}
+
+    /**
+     * @brief Adds a message, overwriting the oldest one if the queue is full.
+     *
+     * @param message A message of one of the types Msgs, copied or moved
+     * straight into the queue.
+     */
+    template <typename M>
+    void push(M &&message)
+    {
+        using type = typename std::decay<M>::type;
+        static_assert((std::is_same<type, Msgs>::value || ...), "MessageQueue: not one of the message types");
+
+        m_queue.push(message_type(std::in_place_type<type>, std::forward<M>(message)));
+    }
+
+    /**
+     * @brief Removes the oldest message and hands it to a visitor.
+     *
+     * Waits indefinitely until a message is available.
+     *
+     * @param visitor Callable with every message type, e.g. an Overloaded.
+     * @return The value returned by the visitor.
+     */
+    template <typename Visitor>
+    decltype(auto) pop(Visitor &&visitor)
+    {
+        return std::visit(std::forward<Visitor>(visitor), m_queue.pop());
+    }
+
+    /**
+     * @brief Removes the oldest message and hands it to a visitor, with a
+     * timeout.
+     *
+     * @param milliseconds_val The timeout period in milliseconds.
+     * @param visitor Callable with every message type, e.g. an Overloaded.
+     * @return The value returned by the visitor.
+     *
+     * @throws std::system_error If the timeout period elapses.
+     */
+    template <typename Visitor>
+    decltype(auto) popWithTimeout(int milliseconds_val, Visitor &&visitor)
+    {
+        return std::visit(std::forward<Visitor>(visitor), m_queue.popWithTimeout(milliseconds_val));
+    }
+
+    /**
+     * @brief Removes and returns the oldest message as a variant.
+     *
+     * @return message_type The oldest message.
+     */
+    message_type pop() { return m_queue.pop(); }
+
+    int count() const { return m_queue.count(); } // Amount of messages stored now
+    int size() const { return m_queue.size(); }   // Max number of messages
+
+private:
+    Queue<message_type, Traits> m_queue; /**< Slots holding the messages */
+};
+
+/**
+ * @brief BasicMessageQueue with the default traits.
+ *
+ * @tparam Msgs The message types.
+ */
+template <typename... Msgs>
+using MessageQueue = BasicMessageQueue<DefaultQueueTraits, Msgs...>;
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef __OBJECT_POOL_H__
+#define __OBJECT_POOL_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include "queue.h"
+
+/**
+ * @brief Reference to an object of an ObjectPool.
+ *
+ * A plain index, cheap to copy through a Queue. It does not own the object:
+ * whoever holds it last returns it with ObjectPool::release().
+ */
+struct PoolHandle
+{
+    std::uint32_t index; /**< Slot of the object in the pool */
+};
+
+/**
+ * @brief Fixed set of pre-constructed objects handed out by index.
+ *
+ * Meant for large payloads passed through a Queue<PoolHandle>: producers
+ * acquire an object, fill it and push its handle, consumers read it and
+ * release the handle. Objects are constructed once with the pool and reused,
+ * so the steady state allocates nothing, and a producer running ahead of its
+ * consumers waits in acquire() once every object is in flight.
+ *
+ * Acquire and release go through a lock-free free list (a Treiber stack with
+ * a version tag against ABA); the mutex is only taken to sleep when the pool
+ * is empty and to wake such sleepers.
+ *
+ * Use a queue at least as large as the pool: a queue that overwrites its
+ * oldest element would lose that handle.
+ *
+ * @tparam T The type of the pooled objects.
+ * @tparam Traits Compile-time configuration of the blocking acquire, see
+ * DefaultQueueTraits.
+ */
+template <typename T, typename Traits = DefaultQueueTraits>
+class ObjectPool
+{
+public:
+    using mutex_type = typename Traits::mutex_type;
+    using condition_type = typename Traits::condition_type;
+    using clock_type = typename Traits::clock_type;
+
+    ObjectPool() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a pool of objects, all free.
+     *
+     * @param size Number of objects.
+     * @param args Arguments of the constructor of every object.
+     */
+    template <typename... Args>
+    explicit ObjectPool(int size, const Args &...args)
+        : m_objects(static_cast<T *>(operator new(size * sizeof(T)))), m_next(new std::atomic<std::uint32_t>[size]),
+          m_capacity(size), m_free(pack(kEmpty, 0)), m_waiters(0)
+    {
+        int built = 0;
+        try
+        {
+            for (; built < size; built++)
+                new (m_objects + built) T(args...);
+        }
+        catch (...)
+        {
+            destroy(built);
+            delete[] m_next;
+            throw;
+        }
+
+        // chain every slot, lowest index on top
+        for (int i = size - 1; i >= 0; i--)
+            pushFree(static_cast<std::uint32_t>(i));
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys every object, acquired or not.
+     */
+    ~ObjectPool()
+    {
+        destroy(m_capacity);
+        delete[] m_next;
+    }
+
+    /**
+     * @brief Takes a free object if there is one, without waiting.
+     *
+     * @param handle Set to the acquired object on success.
+     * @return bool False if every object is in use.
+     */
+    bool tryAcquire(PoolHandle &handle)
+    {
+        // seq_cst: see release()
+        std::uint64_t top = m_free.load();
+        while (index(top) != kEmpty)
+        {
+            // may read a stale link if another thread took the slot meanwhile;
+            // the tag then makes the exchange fail
+            std::uint32_t next = m_next[index(top)].load(std::memory_order_relaxed);
+            if (m_free.compare_exchange_weak(top, pack(next, tag(top) + 1), std::memory_order_acquire,
+                                             std::memory_order_acquire))
+            {
+                handle.index = index(top);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Takes a free object, waiting for a release while there is none.
+     *
+     * @return PoolHandle The acquired object.
+     */
+    PoolHandle acquire()
+    {
+        PoolHandle handle;
+        if (tryAcquire(handle))
+            return handle;
+
+        std::unique_lock<mutex_type> lck(mtx);
+        m_waiters.fetch_add(1);
+        cv.wait(lck, [&]()
+                { return tryAcquire(handle); });
+        m_waiters.fetch_sub(1);
+        return handle;
+    }
+
+    /**
+     * @brief Takes a free object, waiting at most a given time for a release.
+     *
+     * @param milliseconds_val The timeout period in milliseconds.
+     * @return PoolHandle The acquired object.
+     *
+     * @throws std::system_error If the timeout period elapses.
+     */
+    PoolHandle acquireWithTimeout(int milliseconds_val)
+    {
+        PoolHandle handle;
+        if (tryAcquire(handle))
+            return handle;
+
+        auto deadline = clock_type::now() + std::chrono::milliseconds(milliseconds_val);
+        std::unique_lock<mutex_type> lck(mtx);
+        m_waiters.fetch_add(1);
+        bool acquired = cv.wait_until(lck, deadline, [&]()
+                                      { return tryAcquire(handle); });
+        m_waiters.fetch_sub(1);
+
+        if (!acquired)
+            throw std::system_error{std::make_error_code(std::errc::operation_would_block),
+                                    "ObjectPool: acquire() timeout"};
+        return handle;
+    }
+
+    /**
+     * @brief Returns an object to the pool.
+     *
+     * The object is not reset; the next owner sees its last contents.
+     *
+     * @param handle An object acquired from this pool and not yet released.
+     */
+    void release(PoolHandle handle)
+    {
+        pushFree(handle.index);
+
+        // seq_cst pairs with the increment and the free list load in
+        // acquire(): either the waiter sees the released slot or this sees
+        // the waiter
+        if (m_waiters.load() != 0)
+        {
+            std::lock_guard<mutex_type> lck(mtx);
+            cv.notify_one();
+        }
+    }
+
+    /**
+     * @brief The object of a handle.
+     *
+     * @param handle An acquired object.
+     * @return T& The object.
+     */
+    T &operator[](PoolHandle handle) { return m_objects[handle.index]; }
+    const T &operator[](PoolHandle handle) const { return m_objects[handle.index]; }
+
+    /**
+     * @brief Pool capacity getter.
+     *
+     * @return int Number of objects in the pool.
+     */
+    int size() const { return m_capacity; }
+
+private:
+    static constexpr std::uint32_t kEmpty = ~std::uint32_t{0}; /**< Index marking the end of the free list */
+
+    static std::uint64_t pack(std::uint32_t index, std::uint32_t tag)
+    {
+        return static_cast<std::uint64_t>(tag) << 32 | index;
+    }
+    static std::uint32_t index(std::uint64_t top) { return static_cast<std::uint32_t>(top); }
+    static std::uint32_t tag(std::uint64_t top) { return static_cast<std::uint32_t>(top >> 32); }
+
+    void pushFree(std::uint32_t slot)
+    {
+        std::uint64_t top = m_free.load(std::memory_order_relaxed);
+        do
+        {
+            m_next[slot].store(index(top), std::memory_order_relaxed);
+        } while (!m_free.compare_exchange_weak(top, pack(slot, tag(top) + 1), std::memory_order_seq_cst,
+                                               std::memory_order_relaxed));
+    }
+
+    void destroy(int count)
+    {
+        for (int i = 0; i < count; i++)
+            (m_objects + i)->~T();
+        operator delete(m_objects);
+    }
+
+    T *m_objects;                       /**< The pooled objects */
+    std::atomic<std::uint32_t> *m_next; /**< Free list link of every slot */
+    int m_capacity;                     /**< Number of objects */
+    std::atomic<std::uint64_t> m_free;  /**< Top of the free list: version tag << 32 | index */
+    std::atomic<int> m_waiters;         /**< Threads sleeping in acquire() */
+
+    mutex_type mtx{};    /**< Mutex for sleeping while the pool is empty */
+    condition_type cv{}; /**< Signalled by release() when there are sleepers */
+};
+
+#endif
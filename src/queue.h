@@ -4,6 +4,67 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "record.h"
+#include "residency.h"
+#include "queue_snapshot.h"
+#include "trace.h"
+
+/**
+ * @brief Observer that ignores every element, the default.
+ *
+ * An observer is constructed with the queue capacity and is called with
+ * the queue lock held whenever an element enters or leaves the queue.
+ *
+ * @tparam T The type of elements stored in the queue.
+ */
+template <typename T>
+struct NullObserver
+{
+    explicit NullObserver(int) {}
+    void onPush(const T &) {}
+    void onPop(const T &) {}
+    void onOverwrite(const T &, const T &) {}
+};
+
+/**
+ * @brief Compile-time configuration of a Queue.
+ *
+ * Derive from this struct and override members to customise a queue, e.g.
+ * `struct Traced : DefaultQueueTraits { using tracer_type = LockTracer; };`.
+ */
+struct DefaultQueueTraits
+{
+#ifdef QUEUE_ENABLE_TRACING
+    using tracer_type = LockTracer; /**< Hooks called around lock and wait operations */
+#else
+    using tracer_type = NullTracer; /**< Hooks called around lock and wait operations */
+#endif
+
+    using mutex_type = std::mutex;                   /**< Mutex guarding the queue state */
+    using condition_type = std::condition_variable;  /**< Wait primitive, must accept std::unique_lock<mutex_type> */
+    using clock_type = std::chrono::steady_clock;    /**< Clock used for timeouts and element timestamps */
+
+#ifdef QUEUE_TRACK_RESIDENCY
+    static constexpr bool track_residency = true;  /**< Record time spent in the queue per element */
+#else
+    static constexpr bool track_residency = false; /**< Record time spent in the queue per element */
+#endif
+
+#ifdef QUEUE_ENABLE_RECORDING
+    template <typename T>
+    using observer_type = RecordingObserver<T>; /**< Notified of every element entering or leaving */
+#else
+    template <typename T>
+    using observer_type = NullObserver<T>; /**< Notified of every element entering or leaving */
+#endif
+};
 
 /**
  * @brief A thread-safe queue class.
@@ -12,11 +73,19 @@
  * writing and reading operations.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Traits Compile-time configuration, see DefaultQueueTraits.
  */
-template <typename T>
+template <typename T, typename Traits = DefaultQueueTraits>
 class Queue
 {
 public:
+    using tracer_type = typename Traits::tracer_type;
+    using mutex_type = typename Traits::mutex_type;
+    using condition_type = typename Traits::condition_type;
+    using clock_type = typename Traits::clock_type;
+    using observer_type = typename Traits::template observer_type<T>;
+    using value_type = T;
+
     Queue() = delete; ///< Deleted default constructor to enforce size specification.
 
     /**
@@ -26,7 +95,8 @@ public:
      * 
      * @param size The maximum number of elements that the queue can hold.
      */
-    Queue(int size) : m_filled(), m_data(nullptr), m_capacity(size)
+    Queue(int size)
+        : m_data(nullptr), m_head(), m_filled(), m_capacity(size), m_residency(size), m_observer(size)
     {
         // allocate without constructing
         m_data = static_cast<T *>(operator new(size * sizeof(T)));
@@ -39,11 +109,13 @@ public:
      * 
      * @param src The Queue object to copy from.
      */
-    Queue(const Queue &src) : m_filled(src.m_filled), m_data(nullptr), m_capacity(src.m_capacity)
+    Queue(const Queue &src)
+        : m_data(nullptr), m_head(src.m_head), m_filled(src.m_filled), m_capacity(src.m_capacity),
+          m_residency(src.m_residency), m_observer(src.m_observer)
     {
         m_data = static_cast<T *>(operator new(m_capacity * sizeof(T)));
         for (int i = 0; i < m_filled; i++)
-            new (m_data + i) T(*(src.m_data + i));
+            new (m_data + slot(i)) T(*(src.m_data + slot(i)));
     }
 
     /**
@@ -55,7 +127,7 @@ public:
     {
         // destroy objects that exist
         for (int i = 0; i < m_filled; i++)
-            (m_data + i)->~T();
+            (m_data + slot(i))->~T();
 
         // free all space
         operator delete(m_data);
@@ -71,27 +143,16 @@ public:
      * 
      * @param element The element to add to the queue.
      */
-    void push(const T& element)
-    {
-        std::unique_lock<std::mutex> lck(mtx);
-        if (m_filled < m_capacity)
-        {
-            new (m_data + m_filled) T(element);
-            m_filled += 1;
-        }
-        else
-        {
-            // the queue is full, so we copy all elements to the previous
-            // position
-            for (int i = 1; i < m_filled; i++)
-                *(m_data + i - 1) = *(m_data + i);
-
-            *(m_data + m_filled - 1) = element;
-        }
+    void push(const T& element) { emplace(element); }
 
-        // a new element is added, so notify the reader thread
-        cv.notify_one();
-    }
+    /**
+     * @brief Adds a new element to the queue, moving it into its slot.
+     * 
+     * Same as push(const T&), for elements that are expensive to copy.
+     * 
+     * @param element The element to add to the queue.
+     */
+    void push(T &&element) { emplace(std::move(element)); }
 
     /**
      * @brief Removes and returns the oldest element in the queue.
@@ -104,20 +165,11 @@ public:
     T pop()
     {
         // get stuck while there's no new elements
-        std::unique_lock<std::mutex> lck(mtx);
-        cv.wait(lck, [this]()
-                { return m_filled != 0; });
-        
-        // take 1st element and copy all the others to the previous position
-        T popped = *(m_data);
-        for (int i = 1; i < m_filled; i++)
-            *(m_data + i - 1) = *(m_data + i);
-
-        // clear the last one and decrease the number of elements in the queue
-        (m_data + m_filled)->~T();
-        m_filled -= 1;
+        TracedLock lck(*this);
+        wait(lck, [this]()
+             { return m_filled != 0; });
 
-        return popped;
+        return take();
     }
 
     /**
@@ -136,24 +188,57 @@ public:
     T popWithTimeout(int milliseconds_val)
     {
         // get stuck while there's no elements
-        std::unique_lock<std::mutex> lck(mtx);
-        bool not_empty = cv.wait_for(lck, std::chrono::milliseconds(milliseconds_val), [this]()
-                                     { return m_filled != 0; });
+        TracedLock lck(*this);
+        auto deadline = clock_type::now() + std::chrono::milliseconds(milliseconds_val);
+        bool not_empty = waitUntil(lck, deadline, [this]()
+                                   { return m_filled != 0; });
 
         // queue is still empty and lock was freed.
         if (!not_empty)
             throw std::system_error{std::make_error_code(std::errc::operation_would_block),
                                     "Queue: pop() timeout"};
 
-        // pop the oldest element.
-        T popped = *(m_data);
-        for (int i = 1; i < m_filled; i++)
-            *(m_data + i - 1) = *(m_data + i);
+        return take();
+    }
 
-        (m_data + m_filled)->~T();
-        m_filled -= 1;
+    /**
+     * @brief Removes the oldest element if there is one, without waiting.
+     * 
+     * @param element Receives the oldest element on success.
+     * 
+     * @return bool False if the queue was empty.
+     */
+    bool tryPop(T &element)
+    {
+        TracedLock lck(*this);
+        if (m_filled == 0)
+            return false;
 
-        return popped;
+        element = take();
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element, waiting at most a given time for one.
+     * 
+     * Like popWithTimeout() but reports a timeout by its return value, for
+     * callers that must not throw, e.g. real-time threads.
+     * 
+     * @param element Receives the oldest element on success.
+     * @param milliseconds_val The timeout period in milliseconds.
+     * 
+     * @return bool False if the timeout period elapsed.
+     */
+    bool tryPopFor(T &element, int milliseconds_val)
+    {
+        TracedLock lck(*this);
+        auto deadline = clock_type::now() + std::chrono::milliseconds(milliseconds_val);
+        if (!waitUntil(lck, deadline, [this]()
+                       { return m_filled != 0; }))
+            return false;
+
+        element = take();
+        return true;
     }
 
     /**
@@ -177,19 +262,334 @@ public:
     /**
      * @brief Gets the data pointer of the queue elements.
      * 
-     * Returns a constant pointer to the queue elements.
+     * Returns a constant pointer to the queue elements, oldest first. The
+     * elements are stored in a ring, so this rotates the storage in place,
+     * with the queue locked, to start at the oldest element. The pointer is
+     * valid until the next push, pop or data() call; reading through it
+     * while other threads use the queue is not synchronized.
      * 
      * @return const T* Constant pointer to the queue elements.
      */
-    const T *data() const { return m_data; }
+    const T *data() const
+    {
+        TracedLock lck(*this);
+        linearize();
+        return m_data;
+    }
+
+    /**
+     * @brief Writes the queue contents to a writer.
+     * 
+     * Writes a QueueSnapshotHeader followed by the elements, oldest first,
+     * as a single write() of at most three segments: the header and the
+     * one or two contiguous regions of the ring. Nothing is copied or
+     * allocated, so with FdWriter a checkpoint runs at the speed of the
+     * kernel copy. The queue is locked while writing.
+     * 
+     * @param writer Object with write(const IoSegment *, int), e.g. FdWriter.
+     */
+    template <typename Writer>
+    void serialize(Writer &writer)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Queue: serialize() needs a trivially copyable T");
+
+        TracedLock lck(*this);
+        QueueSnapshotHeader header{QueueSnapshotHeader::kMagic, QueueSnapshotHeader::kVersion,
+                                   static_cast<std::uint32_t>(sizeof(T)), 0,
+                                   static_cast<std::uint64_t>(m_capacity), static_cast<std::uint64_t>(m_filled)};
+
+        // live elements run from m_head to the end of the buffer, then wrap
+        int first = std::min(m_filled, m_capacity - m_head);
+        IoSegment segments[3] = {{&header, sizeof(header)},
+                                 {m_data + m_head, first * sizeof(T)},
+                                 {m_data, (m_filled - first) * sizeof(T)}};
+        writer.write(segments, m_filled - first > 0 ? 3 : 2);
+    }
+
+    /**
+     * @brief Replaces the queue contents with data written by serialize().
+     * 
+     * The elements are read straight into the queue storage, with the
+     * queue locked, so nothing is allocated. The current contents are
+     * dropped first: if the read fails the queue is left empty. Waiting
+     * consumers are woken up.
+     * 
+     * @param reader Object with read(void *, std::size_t), e.g. FdReader.
+     * 
+     * @throws std::invalid_argument If the data is not a compatible snapshot
+     * or holds more elements than the queue capacity. The queue is left
+     * unchanged.
+     */
+    template <typename Reader>
+    void deserialize(Reader &reader)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Queue: deserialize() needs a trivially copyable T");
+
+        QueueSnapshotHeader header;
+        reader.read(&header, sizeof(header));
+        if (header.magic != QueueSnapshotHeader::kMagic || header.version != QueueSnapshotHeader::kVersion ||
+            header.element_size != sizeof(T))
+            throw std::invalid_argument("Queue: incompatible snapshot");
+        if (header.count > static_cast<std::uint64_t>(m_capacity))
+            throw std::invalid_argument("Queue: snapshot exceeds the queue capacity");
+
+        TracedLock lck(*this);
+
+        // drop the current contents
+        for (int i = 0; i < m_filled; i++)
+            m_observer.onPop(*(m_data + slot(i)));
+        m_head = 0;
+        m_filled = 0;
+
+        reader.read(m_data, header.count * sizeof(T));
+        m_filled = static_cast<int>(header.count);
+        for (int i = 0; i < m_filled; i++)
+        {
+            m_residency.onPush(i);
+            m_observer.onPush(*(m_data + i));
+        }
+
+        cv.notify_all();
+    }
+
+    /**
+     * @brief Calls a function with the observer while holding the queue lock.
+     * 
+     * E.g. `queue.observe([](const auto &stats) { return stats.mean(); })`
+     * with a WindowAggregate observer.
+     * 
+     * @param fn Function taking observer_type&.
+     * @return The result of fn.
+     */
+    template <typename Fn>
+    auto observe(Fn fn) -> decltype(fn(std::declval<observer_type &>()))
+    {
+        TracedLock lck(*this);
+        return fn(m_observer);
+    }
+
+    /**
+     * @brief Time spent in the queue by popped elements, in nanoseconds.
+     * 
+     * Only available when Traits::track_residency is true.
+     * 
+     * @return const LatencyHistogram& Residency histogram.
+     */
+    const LatencyHistogram &residency() const
+    {
+        static_assert(Traits::track_residency, "Queue: residency tracking is disabled");
+        return m_residency.popped();
+    }
+
+    /**
+     * @brief Time spent in the queue by overwritten elements, in nanoseconds.
+     * 
+     * Only available when Traits::track_residency is true.
+     * 
+     * @return const LatencyHistogram& Residency histogram.
+     */
+    const LatencyHistogram &overwrittenResidency() const
+    {
+        static_assert(Traits::track_residency, "Queue: residency tracking is disabled");
+        return m_residency.overwritten();
+    }
+
+    /**
+     * @brief The condition consumers wait on.
+     * 
+     * E.g. for the limits and statistics of an AdaptiveCondition or the fd
+     * of an EventfdCondition.
+     * 
+     * @return condition_type& The condition.
+     */
+    condition_type &condition() { return cv; }
 
 private:
+    /**
+     * @brief Scoped lock on the queue mutex that reports to the tracer.
+     *
+     * The release hook runs in the destructor body, i.e. right before the
+     * mutex is unlocked by the member lock.
+     */
+    class TracedLock
+    {
+    public:
+        explicit TracedLock(const Queue &queue) : m_queue(queue)
+        {
+            tracer_type::onLockAcquire(&m_queue);
+            m_lck = std::unique_lock<mutex_type>(m_queue.mtx);
+            tracer_type::onLockAcquired(&m_queue);
+        }
+
+        ~TracedLock() { tracer_type::onLockRelease(&m_queue); }
+
+        TracedLock(const TracedLock &) = delete;
+        TracedLock &operator=(const TracedLock &) = delete;
+
+        std::unique_lock<mutex_type> &get() { return m_lck; }
+
+    private:
+        const Queue &m_queue;               /**< Queue whose mutex is held */
+        std::unique_lock<mutex_type> m_lck; /**< The underlying lock */
+    };
+
+    /**
+     * @brief Waits on the condition variable until the predicate holds.
+     *
+     * @param lck Lock on the queue mutex.
+     * @param pred Predicate to wait for.
+     */
+    template <typename Predicate>
+    void wait(TracedLock &lck, Predicate pred)
+    {
+        if (pred())
+            return;
+
+        tracer_type::onWaitEnter(this);
+        cv.wait(lck.get(), pred);
+        tracer_type::onWaitExit(this);
+    }
+
+    /**
+     * @brief Waits on the condition variable until the predicate holds or the
+     * deadline passes.
+     *
+     * @param lck Lock on the queue mutex.
+     * @param deadline Time point of clock_type after which waiting stops.
+     * @param pred Predicate to wait for.
+     * @return bool Value of the predicate on return.
+     */
+    template <typename Predicate>
+    bool waitUntil(TracedLock &lck, const typename clock_type::time_point &deadline, Predicate pred)
+    {
+        if (pred())
+            return true;
+
+        tracer_type::onWaitEnter(this);
+        bool result = cv.wait_until(lck.get(), deadline, pred);
+        tracer_type::onWaitExit(this);
+        return result;
+    }
+
+    /**
+     * @brief Stores an element, overwriting the oldest one when full, and
+     * wakes a reader.
+     *
+     * @param element The element, copied or moved into its slot.
+     */
+    template <typename U>
+    void emplace(U &&element)
+    {
+        TracedLock lck(*this);
+        if (m_filled < m_capacity)
+        {
+            int tail = slot(m_filled);
+            new (m_data + tail) T(std::forward<U>(element));
+            m_residency.onPush(tail);
+            m_observer.onPush(*(m_data + tail));
+            m_filled += 1;
+        }
+        else
+        {
+            // the queue is full, so the oldest element is overwritten in
+            // place and the next one becomes the oldest; the observer sees
+            // the evicted element before it is replaced
+            m_observer.onOverwrite(*(m_data + m_head), element);
+            *(m_data + m_head) = std::forward<U>(element);
+            m_residency.onOverwrite(m_head);
+            m_head = slot(1);
+        }
+
+        // a new element is added, so notify the reader thread
+        cv.notify_one();
+    }
+
+    /**
+     * @brief Removes and returns the oldest element. The lock must be held
+     * and the queue must not be empty.
+     *
+     * @return The oldest element in the queue.
+     */
+    T take()
+    {
+        // take the oldest element and clear its slot
+        m_observer.onPop(*(m_data + m_head));
+        T popped = std::move(*(m_data + m_head));
+        (m_data + m_head)->~T();
+        m_residency.onPop(m_head);
+
+        m_head = slot(1);
+        m_filled -= 1;
+
+        return popped;
+    }
+
+    /**
+     * @brief Storage index of the i-th oldest element.
+     * 
+     * @param i Position relative to the oldest element, in [0, m_capacity].
+     * @return int Index into m_data.
+     */
+    int slot(int i) const
+    {
+        int index = m_head + i;
+        return index >= m_capacity ? index - m_capacity : index;
+    }
+
+    /**
+     * @brief Rotates the storage so that the oldest element is at index 0.
+     * The lock must be held.
+     *
+     * Works in place: free slots hold no objects, so the elements are
+     * relocated around them instead of rotating the whole buffer.
+     */
+    void linearize() const
+    {
+        if (m_head == 0)
+            return;
+
+        // oldest elements in [m_head, m_head + a), newest wrapped to [0, b)
+        int a = std::min(m_filled, m_capacity - m_head);
+        int b = m_filled - a;
+        int start = m_head - b;
+
+        // close the gap: move the newest up against the oldest, last first
+        for (int i = b - 1; i >= 0; i--)
+            relocate(i, start + i);
+        if (b > 0)
+            std::rotate(m_data + start, m_data + m_head, m_data + m_capacity);
+        // move the now contiguous elements down to index 0, first first
+        for (int i = 0; i < m_filled; i++)
+            relocate(start + i, i);
+
+        m_residency.rotate(m_head);
+        m_head = 0;
+    }
+
+    /**
+     * @brief Moves an element to a free slot and destroys the original.
+     *
+     * @param from Slot holding the element.
+     * @param to Free slot, or from.
+     */
+    void relocate(int from, int to) const
+    {
+        if (from == to)
+            return;
+        new (m_data + to) T(std::move(*(m_data + from)));
+        (m_data + from)->~T();
+    }
+
+    // storage layout is logically const: data() may rotate it under the lock
     T *m_data;                    /**< Pointer to the queue elements */
+    mutable int m_head;           /**< Index of the oldest element */
     int m_filled;                 /**< Current number of elements in the queue */
     int m_capacity;               /**< Maximum capacity of the queue */
+    mutable ResidencyTracker<clock_type, Traits::track_residency> m_residency; /**< Element timestamps (empty when disabled) */
+    observer_type m_observer;     /**< Notified of elements entering and leaving */
 
-    std::mutex mtx{};             /**< Mutex for thread safety */
-    std::condition_variable cv{}; /**< Condition variable for synchronization */
+    mutable mutex_type mtx{};     /**< Mutex for thread safety */
+    condition_type cv{};          /**< Condition variable for synchronization */
 };
 
 #endif
\ No newline at end of file
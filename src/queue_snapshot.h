@@ -0,0 +1,32 @@
+#ifndef __QUEUE_SNAPSHOT_H__
+#define __QUEUE_SNAPSHOT_H__
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief A contiguous piece of memory to write, like struct iovec.
+ */
+struct IoSegment
+{
+    const void *data; /**< Start of the segment */
+    std::size_t size; /**< Size in bytes */
+};
+
+/**
+ * @brief Header written in front of a serialized queue.
+ */
+struct QueueSnapshotHeader
+{
+    static constexpr std::uint32_t kMagic = 0x45555142; /**< "BQUE" */
+    static constexpr std::uint32_t kVersion = 1;
+
+    std::uint32_t magic;        /**< kMagic */
+    std::uint32_t version;      /**< kVersion */
+    std::uint32_t element_size; /**< sizeof(T) of the serialized queue */
+    std::uint32_t reserved;     /**< Zero */
+    std::uint64_t capacity;     /**< Capacity of the serialized queue */
+    std::uint64_t count;        /**< Number of elements that follow */
+};
+
+#endif
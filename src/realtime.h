@@ -0,0 +1,138 @@
+#ifndef __REALTIME_H__
+#define __REALTIME_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+
+#include <pthread.h>
+#include <time.h>
+
+#include "condition.h"
+#include "queue.h"
+
+/**
+ * @brief Mutex with priority inheritance.
+ *
+ * While a thread waits for the mutex, its owner runs at the waiter's
+ * priority if that is higher, so a real-time thread is delayed by the
+ * critical section only and not by whatever else outranks the owner.
+ * Usable wherever std::mutex is, e.g. with std::unique_lock.
+ */
+class PiMutex
+{
+public:
+    /**
+     * @brief Constructs an unlocked mutex.
+     *
+     * @throws std::system_error If the system does not support priority
+     * inheritance.
+     */
+    PiMutex()
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        int error = pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+        if (error == 0)
+            error = pthread_mutex_init(&m_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+        if (error != 0)
+            throw std::system_error(error, std::generic_category(), "PiMutex: pthread_mutex_init() failed");
+    }
+
+    PiMutex(const PiMutex &) = delete;
+    PiMutex &operator=(const PiMutex &) = delete;
+
+    ~PiMutex() { pthread_mutex_destroy(&m_mutex); }
+
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    bool try_lock() { return pthread_mutex_trylock(&m_mutex) == 0; }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+
+    pthread_mutex_t *native_handle() { return &m_mutex; }
+
+private:
+    pthread_mutex_t m_mutex; /**< The underlying mutex */
+};
+
+/**
+ * @brief Condition variable for PiMutex, timed on CLOCK_MONOTONIC.
+ *
+ * Timed waits are immune to changes of the wall clock. Nothing is allocated
+ * and nothing is thrown after construction.
+ */
+class PiCondition : public BasicCondition<PiCondition>
+{
+public:
+    using BasicCondition<PiCondition>::wait;
+    using BasicCondition<PiCondition>::wait_until;
+
+    /**
+     * @brief Constructs the condition variable.
+     *
+     * @throws std::system_error If the system refuses the monotonic clock.
+     */
+    PiCondition()
+    {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        int error = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        if (error == 0)
+            error = pthread_cond_init(&m_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        if (error != 0)
+            throw std::system_error(error, std::generic_category(), "PiCondition: pthread_cond_init() failed");
+    }
+
+    PiCondition(const PiCondition &) = delete;
+    PiCondition &operator=(const PiCondition &) = delete;
+
+    ~PiCondition() { pthread_cond_destroy(&m_cond); }
+
+    void notify_one() { pthread_cond_signal(&m_cond); }
+    void notify_all() { pthread_cond_broadcast(&m_cond); }
+
+    void wait(std::unique_lock<PiMutex> &lck) { pthread_cond_wait(&m_cond, lck.mutex()->native_handle()); }
+
+    template <typename Clock, typename Duration>
+    std::cv_status wait_until(std::unique_lock<PiMutex> &lck, const std::chrono::time_point<Clock, Duration> &deadline)
+    {
+        // the deadline may be on any clock: wait for the time left on ours
+        std::chrono::nanoseconds left = remaining(deadline);
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        long long ns = static_cast<long long>(ts.tv_nsec) + left.count() % 1000000000;
+        ts.tv_sec += static_cast<time_t>(left.count() / 1000000000 + ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+
+        pthread_cond_timedwait(&m_cond, lck.mutex()->native_handle(), &ts);
+        return Clock::now() >= deadline ? std::cv_status::timeout : std::cv_status::no_timeout;
+    }
+
+private:
+    pthread_cond_t m_cond; /**< The underlying condition variable */
+};
+
+/**
+ * @brief Queue configuration for real-time threads.
+ *
+ * Priority-inheriting mutex, monotonic timed waits and no tracing,
+ * residency tracking or recording regardless of the build options, so that
+ * push(), pop(), tryPop() and tryPopFor() do constant work, allocate nothing
+ * and throw nothing after construction (provided T's copy and move do not).
+ * Avoid popWithTimeout(), which reports a timeout with an exception.
+ */
+struct RealTimeQueueTraits : DefaultQueueTraits
+{
+    using tracer_type = NullTracer;
+    using mutex_type = PiMutex;
+    using condition_type = PiCondition;
+    using clock_type = std::chrono::steady_clock;
+    static constexpr bool track_residency = false;
+
+    template <typename T>
+    using observer_type = NullObserver<T>;
+};
+
+#endif
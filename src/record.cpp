@@ -0,0 +1,214 @@
+#include "record.h"
+#include "serialization.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+std::atomic<bool> OpRecorder::s_active{false};
+std::atomic<bool> OpRecorder::s_capture_payload{false};
+
+namespace
+{
+    std::mutex registry_mtx;
+    std::vector<std::unique_ptr<RecordRing>> registry;
+    std::size_t ring_capacity = 1 << 14;
+
+    /**
+     * @brief State of the running capture, guarded by control_mtx.
+     */
+    std::mutex control_mtx;
+    std::condition_variable control_cv;
+    bool stopping = false;
+    int log_fd = -1;
+    std::thread writer;
+    std::exception_ptr writer_error;
+
+    constexpr auto kFlushInterval = std::chrono::milliseconds(2);
+
+    std::size_t roundUpPowerOfTwo(std::size_t value)
+    {
+        std::size_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    /**
+     * @brief Moves the records of every ring to the log.
+     *
+     * Queue addresses are replaced by sequential indices in order of first
+     * appearance, which keeps the log independent of the memory layout.
+     */
+    void drainAll(std::vector<OpRecord> &buffer, std::unordered_map<std::uint64_t, std::uint64_t> &queues, FdWriter &out)
+    {
+        buffer.clear();
+        {
+            std::lock_guard<std::mutex> lck(registry_mtx);
+            for (const auto &ring : registry)
+                ring->drain(buffer);
+        }
+
+        for (auto &record : buffer)
+            record.queue = queues.emplace(record.queue, queues.size()).first->second;
+
+        if (!buffer.empty())
+        {
+            IoSegment segment{buffer.data(), buffer.size() * sizeof(OpRecord)};
+            out.write(&segment, 1);
+        }
+    }
+
+    void writerLoop(int fd)
+    {
+        FdWriter out(fd);
+        std::vector<OpRecord> buffer;
+        std::unordered_map<std::uint64_t, std::uint64_t> queues;
+        try
+        {
+            std::unique_lock<std::mutex> lck(control_mtx);
+            while (!stopping)
+            {
+                control_cv.wait_for(lck, kFlushInterval);
+                lck.unlock();
+                drainAll(buffer, queues, out);
+                lck.lock();
+            }
+            lck.unlock();
+            drainAll(buffer, queues, out);
+        }
+        catch (...)
+        {
+            writer_error = std::current_exception();
+        }
+    }
+}
+
+RecordRing::RecordRing(std::size_t capacity, std::uint32_t thread_index)
+    : m_records(new OpRecord[roundUpPowerOfTwo(capacity)]), m_mask(roundUpPowerOfTwo(capacity) - 1),
+      m_thread_index(thread_index)
+{
+}
+
+void RecordRing::drain(std::vector<OpRecord> &out)
+{
+    std::uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    std::uint64_t head = m_head.load(std::memory_order_acquire);
+    for (; tail != head; tail++)
+        out.push_back(m_records[tail & m_mask]);
+    m_tail.store(tail, std::memory_order_release);
+}
+
+void OpRecorder::start(const std::string &path, bool capture_payload)
+{
+    std::lock_guard<std::mutex> lck(control_mtx);
+    if (log_fd >= 0)
+        throw std::logic_error("OpRecorder: a capture is already running");
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "OpRecorder: cannot open " + path);
+
+    try
+    {
+        OpLogHeader header{OpLogHeader::kMagic, OpLogHeader::kVersion, sizeof(OpRecord), 0};
+        IoSegment segment{&header, sizeof(header)};
+        FdWriter(fd).write(&segment, 1);
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+
+    // forget records left over from a previous capture
+    {
+        std::lock_guard<std::mutex> registry_lck(registry_mtx);
+        for (const auto &ring : registry)
+            ring->skip();
+    }
+
+    log_fd = fd;
+    stopping = false;
+    writer_error = nullptr;
+    s_capture_payload.store(capture_payload, std::memory_order_relaxed);
+    writer = std::thread(writerLoop, fd);
+    s_active.store(true, std::memory_order_relaxed);
+}
+
+void OpRecorder::stop()
+{
+    s_active.store(false, std::memory_order_relaxed);
+
+    std::thread finished;
+    {
+        std::lock_guard<std::mutex> lck(control_mtx);
+        if (log_fd < 0)
+            return;
+        stopping = true;
+        finished = std::move(writer);
+    }
+    control_cv.notify_all();
+    finished.join();
+
+    std::lock_guard<std::mutex> lck(control_mtx);
+    ::close(log_fd);
+    log_fd = -1;
+    if (writer_error)
+        std::rethrow_exception(writer_error);
+}
+
+void OpRecorder::setRingCapacity(std::size_t records)
+{
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    ring_capacity = records;
+}
+
+std::uint64_t OpRecorder::dropped()
+{
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    std::uint64_t total = 0;
+    for (const auto &ring : registry)
+        total += ring->dropped();
+    return total;
+}
+
+RecordRing &OpRecorder::registerThread()
+{
+    // rings outlive their threads so that records of finished threads are
+    // still written
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    registry.push_back(std::make_unique<RecordRing>(ring_capacity, static_cast<std::uint32_t>(registry.size())));
+    return *registry.back();
+}
+
+std::vector<OpRecord> OpRecorder::readLog(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::system_error(std::make_error_code(std::errc::no_such_file_or_directory), "OpRecorder: cannot open " + path);
+
+    OpLogHeader header{};
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || header.magic != OpLogHeader::kMagic || header.version != OpLogHeader::kVersion ||
+        header.record_size != sizeof(OpRecord))
+        throw std::invalid_argument("OpRecorder: " + path + " is not an operation log");
+
+    std::vector<OpRecord> records;
+    OpRecord record;
+    while (in.read(reinterpret_cast<char *>(&record), sizeof(record)))
+        records.push_back(record);
+
+    std::stable_sort(records.begin(), records.end(), [](const OpRecord &a, const OpRecord &b)
+                     { return a.timestamp < b.timestamp; });
+    return records;
+}
@@ -0,0 +1,265 @@
+#ifndef __RECORD_H__
+#define __RECORD_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Kinds of queue operations captured by OpRecorder.
+ */
+enum class RecordOp : std::uint8_t
+{
+    Push,      ///< An element entered a queue with room left.
+    Pop,       ///< An element left the queue.
+    Overwrite  ///< An element entered a full queue and evicted the oldest one.
+};
+
+/**
+ * @brief One captured operation, as stored in the binary log.
+ */
+struct OpRecord
+{
+    std::uint64_t timestamp;   /**< Steady clock time in nanoseconds */
+    std::uint64_t queue;       /**< Queue identity: the observer address while buffered, replaced by a
+                                    sequential index in order of first appearance when written to the log */
+    std::uint64_t payload;     /**< First payload_size bytes of the element */
+    std::uint32_t thread;      /**< Sequential index of the recording thread */
+    std::uint32_t depth;       /**< Number of queued elements after the operation */
+    RecordOp op;               /**< What happened */
+    std::uint8_t payload_size; /**< Bytes of payload captured, 0 if none */
+    std::uint16_t reserved;    /**< Zero */
+    std::uint32_t reserved2;   /**< Zero */
+};
+
+/**
+ * @brief Header at the start of a binary operation log.
+ */
+struct OpLogHeader
+{
+    static constexpr std::uint32_t kMagic = 0x43455242; /**< "BREC" */
+    static constexpr std::uint32_t kVersion = 1;
+
+    std::uint32_t magic;       /**< kMagic */
+    std::uint32_t version;     /**< kVersion */
+    std::uint32_t record_size; /**< sizeof(OpRecord) */
+    std::uint32_t reserved;    /**< Zero */
+};
+
+/**
+ * @brief Single-producer single-consumer ring of records filled by one thread
+ * and drained by the recorder writer thread.
+ *
+ * When the ring is full new records are dropped and counted, so a slow disk
+ * never blocks the recording thread.
+ */
+class RecordRing
+{
+public:
+    RecordRing() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a ring for the given thread.
+     *
+     * @param capacity Number of records buffered, rounded up to a power of two.
+     * @param thread_index Sequential index of the owning thread.
+     */
+    RecordRing(std::size_t capacity, std::uint32_t thread_index);
+
+    /**
+     * @brief Appends a record, must only be called from the owning thread.
+     *
+     * @param record The record, its thread field is filled in.
+     */
+    void push(OpRecord record)
+    {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) > m_mask)
+        {
+            m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        record.thread = m_thread_index;
+        m_records[head & m_mask] = record;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Moves the buffered records to out, must only be called from the
+     * writer thread.
+     *
+     * @param out Destination, records are appended.
+     */
+    void drain(std::vector<OpRecord> &out);
+
+    /**
+     * @brief Discards the buffered records, called by the writer thread.
+     */
+    void skip() { m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    std::uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    std::unique_ptr<OpRecord[]> m_records;   /**< Record storage */
+    std::size_t m_mask;                      /**< capacity - 1 */
+    std::uint32_t m_thread_index;            /**< Sequential index of the owning thread */
+    std::atomic<std::uint64_t> m_head{0};    /**< Records written, owned by the recording thread */
+    std::atomic<std::uint64_t> m_tail{0};    /**< Records drained, owned by the writer thread */
+    std::atomic<std::uint64_t> m_dropped{0}; /**< Records lost because the ring was full */
+};
+
+/**
+ * @brief Captures queue operations into a binary log for offline analysis
+ * and replay.
+ *
+ * Recording threads append fixed-size records to their own ring without
+ * taking a lock; a background writer thread drains all rings to the log
+ * file. Records of different threads are not ordered in the file, sort them
+ * by timestamp when reading. Queues report their operations through
+ * RecordingObserver, and nothing is recorded unless a capture is running.
+ */
+class OpRecorder
+{
+public:
+    /**
+     * @brief Starts a capture, replacing the content of the log file.
+     *
+     * @param path Log file to write.
+     * @param capture_payload Also store up to 8 bytes of every trivially
+     * copyable element.
+     *
+     * @throws std::system_error If the file cannot be opened.
+     * @throws std::logic_error If a capture is already running.
+     */
+    static void start(const std::string &path, bool capture_payload = false);
+
+    /**
+     * @brief Stops the capture, writes the pending records and closes the log.
+     */
+    static void stop();
+
+    /**
+     * @brief Sets the capacity of rings created from now on.
+     *
+     * @param records Number of records buffered per thread.
+     */
+    static void setRingCapacity(std::size_t records);
+
+    static bool active() { return s_active.load(std::memory_order_relaxed); }
+    static bool capturePayload() { return s_capture_payload.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of records lost because a thread ring was full, over all
+     * captures.
+     *
+     * @return std::uint64_t Number of records.
+     */
+    static std::uint64_t dropped();
+
+    /**
+     * @brief Records an operation from the calling thread.
+     *
+     * @param queue Queue instance the operation belongs to, stored as its
+     * address; the writer thread turns addresses into sequential indices, so
+     * a queue destroyed and another created at the same address during one
+     * capture share an index.
+     * @param op What happened.
+     * @param depth Number of queued elements after the operation.
+     * @param payload Element bytes, or nullptr.
+     * @param size Number of payload bytes, at most 8.
+     */
+    static void record(const void *queue, RecordOp op, int depth, const void *payload, std::size_t size)
+    {
+        OpRecord record{};
+        record.timestamp = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+        record.queue = reinterpret_cast<std::uintptr_t>(queue);
+        record.depth = static_cast<std::uint32_t>(depth);
+        record.op = op;
+        if (payload != nullptr)
+        {
+            std::memcpy(&record.payload, payload, size);
+            record.payload_size = static_cast<std::uint8_t>(size);
+        }
+        ring().push(record);
+    }
+
+    /**
+     * @brief Reads a log written by a capture.
+     *
+     * @param path Log file to read.
+     * @return std::vector<OpRecord> The records, sorted by timestamp.
+     *
+     * @throws std::system_error If the file cannot be read.
+     * @throws std::invalid_argument If the file is not an operation log.
+     */
+    static std::vector<OpRecord> readLog(const std::string &path);
+
+private:
+    static RecordRing &ring()
+    {
+        thread_local RecordRing *local = nullptr;
+        if (local == nullptr)
+            local = &registerThread();
+        return *local;
+    }
+
+    static RecordRing &registerThread();
+
+    static std::atomic<bool> s_active;          /**< A capture is running */
+    static std::atomic<bool> s_capture_payload; /**< Element bytes are stored */
+};
+
+/**
+ * @brief Queue observer that reports every operation to OpRecorder.
+ *
+ * `struct Traits : DefaultQueueTraits { template <typename T> using observer_type = RecordingObserver<T>; };`
+ * or build with QUEUE_ENABLE_RECORDING to make it the default observer.
+ * Costs one relaxed load per operation while no capture is running.
+ *
+ * @tparam T The type of elements stored in the queue.
+ */
+template <typename T>
+class RecordingObserver
+{
+public:
+    explicit RecordingObserver(int) : m_depth() {}
+
+    void onPush(const T &value)
+    {
+        m_depth += 1;
+        record(RecordOp::Push, value);
+    }
+
+    void onPop(const T &value)
+    {
+        m_depth -= 1;
+        record(RecordOp::Pop, value);
+    }
+
+    void onOverwrite(const T &, const T &added) { record(RecordOp::Overwrite, added); }
+
+private:
+    void record(RecordOp op, const T &value)
+    {
+        if (!OpRecorder::active())
+            return;
+
+        const void *payload = nullptr;
+        if (std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(std::uint64_t) && OpRecorder::capturePayload())
+            payload = &value;
+        OpRecorder::record(this, op, m_depth, payload, sizeof(T) <= sizeof(std::uint64_t) ? sizeof(T) : 0);
+    }
+
+    int m_depth; /**< Number of queued elements */
+};
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef __REORDER_BUFFER_H__
+#define __REORDER_BUFFER_H__
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <utility>
+
+#include "queue.h"
+
+/**
+ * @brief Puts elements completed out of order back into sequence order.
+ *
+ * Producers push each element with its sequence number; the consumer
+ * receives them in sequence order, every contiguous run that is ready in
+ * one batch. Elements are stored in a ring of slots indexed by sequence
+ * number modulo the capacity, so a push and the release of an element are
+ * O(1) and nothing is allocated after construction.
+ *
+ * A producer whose sequence number is a full ring ahead of the next one to
+ * release waits for the consumer. When an element is missing while later
+ * ones are ready, the consumer waits at most the gap timeout, then skips the
+ * missing sequence numbers; they are dropped if they arrive afterwards.
+ *
+ * @tparam T The type of the elements.
+ * @tparam Traits Compile-time configuration, see DefaultQueueTraits.
+ */
+template <typename T, typename Traits = DefaultQueueTraits>
+class ReorderBuffer
+{
+public:
+    using mutex_type = typename Traits::mutex_type;
+    using condition_type = typename Traits::condition_type;
+    using clock_type = typename Traits::clock_type;
+    using duration = typename clock_type::duration;
+
+    ReorderBuffer() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs an empty buffer.
+     *
+     * @param size Number of slots, the largest distance between the next
+     * sequence number to release and any buffered one.
+     * @param first Sequence number of the first element.
+     */
+    explicit ReorderBuffer(int size, std::uint64_t first = 0)
+        : m_data(static_cast<T *>(operator new(size * sizeof(T)))), m_ready(new bool[size]()), m_capacity(size),
+          m_next(first), m_filled(), m_skipped(), m_gap_timeout(duration::zero()), m_gap_open(false)
+    {
+    }
+
+    ReorderBuffer(const ReorderBuffer &) = delete;
+    ReorderBuffer &operator=(const ReorderBuffer &) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys the buffered elements, releasing allocated memory.
+     */
+    ~ReorderBuffer()
+    {
+        for (int i = 0; i < m_capacity; i++)
+            if (m_ready[i])
+                (m_data + i)->~T();
+        operator delete(m_data);
+        delete[] m_ready;
+    }
+
+    /**
+     * @brief Sets how long a missing element may hold back later ones.
+     *
+     * @param timeout Time after which the missing sequence numbers are
+     * skipped. Zero (the default) waits forever.
+     */
+    void setGapTimeout(duration timeout)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        m_gap_timeout = timeout;
+        cv.notify_all();
+    }
+
+    /**
+     * @brief Adds an element, waiting while its sequence number is a full
+     * ring ahead of the next one to release.
+     *
+     * @param sequence Sequence number of the element.
+     * @param element The element.
+     * @return bool False if the element was dropped: its sequence number was
+     * already released or skipped, or is already buffered.
+     */
+    bool push(std::uint64_t sequence, T element)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        space_cv.wait(lck, [this, sequence]()
+                      { return sequence < m_next + m_capacity; });
+        if (sequence < m_next)
+            return false;
+
+        int index = slot(sequence);
+        if (m_ready[index])
+            return false;
+
+        new (m_data + index) T(std::move(element));
+        m_ready[index] = true;
+        m_filled += 1;
+
+        if (sequence == m_next)
+        {
+            m_gap_open = false;
+            cv.notify_one();
+        }
+        else if (!m_gap_open && !m_ready[slot(m_next)])
+        {
+            // later elements are ready but the next one is missing
+            m_gap_open = true;
+            m_gap_since = clock_type::now();
+            cv.notify_one(); // the consumer may need a deadline now
+        }
+        return true;
+    }
+
+    /**
+     * @brief Releases the next contiguous run of elements, waiting until the
+     * next element arrives or the gap timeout skips to a later one.
+     *
+     * @param out Output iterator receiving the elements in sequence order.
+     * @param max Largest number of elements to release in this batch.
+     * @return int Number of elements released, at least 1.
+     */
+    template <typename OutputIt>
+    int popRun(OutputIt out, int max = INT_MAX)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        while (!releasable())
+        {
+            if (m_gap_open && m_gap_timeout != duration::zero())
+                cv.wait_until(lck, m_gap_since + m_gap_timeout);
+            else
+                cv.wait(lck);
+        }
+        return release(out, max);
+    }
+
+    /**
+     * @brief Releases the next contiguous run of elements, with a timeout.
+     *
+     * @param milliseconds_val The timeout period in milliseconds.
+     * @param out Output iterator receiving the elements in sequence order.
+     * @param max Largest number of elements to release in this batch.
+     * @return int Number of elements released, at least 1.
+     *
+     * @throws std::system_error If the timeout period elapses.
+     */
+    template <typename OutputIt>
+    int popRunWithTimeout(int milliseconds_val, OutputIt out, int max = INT_MAX)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        auto deadline = clock_type::now() + std::chrono::milliseconds(milliseconds_val);
+        while (!releasable())
+        {
+            if (clock_type::now() >= deadline)
+                throw std::system_error{std::make_error_code(std::errc::operation_would_block),
+                                        "ReorderBuffer: pop() timeout"};
+
+            // wake up for whichever comes first, the deadline or the gap timeout
+            auto until = deadline;
+            if (m_gap_open && m_gap_timeout != duration::zero() && m_gap_since + m_gap_timeout < deadline)
+                until = m_gap_since + m_gap_timeout;
+            cv.wait_until(lck, until);
+        }
+        return release(out, max);
+    }
+
+    /**
+     * @brief Sequence number of the next element to release.
+     */
+    std::uint64_t next() const { return m_next; }
+
+    /**
+     * @brief Number of buffered elements.
+     */
+    int count() const { return m_filled; }
+
+    /**
+     * @brief Number of slots.
+     */
+    int size() const { return m_capacity; }
+
+    /**
+     * @brief Number of sequence numbers skipped by the gap timeout.
+     */
+    std::uint64_t skipped() const { return m_skipped; }
+
+private:
+    int slot(std::uint64_t sequence) const { return static_cast<int>(sequence % static_cast<std::uint64_t>(m_capacity)); }
+
+    /**
+     * @brief Whether the next element is ready or the gap before the next
+     * ready one has timed out. The lock must be held.
+     */
+    bool releasable() const
+    {
+        if (m_ready[slot(m_next)])
+            return true;
+        return m_gap_open && m_gap_timeout != duration::zero() && clock_type::now() >= m_gap_since + m_gap_timeout;
+    }
+
+    /**
+     * @brief Skips a timed out gap and hands out the run starting at the
+     * next element. The lock must be held and releasable() true.
+     */
+    template <typename OutputIt>
+    int release(OutputIt out, int max)
+    {
+        // each sequence number is skipped once, so this is O(1) amortized
+        while (!m_ready[slot(m_next)])
+        {
+            m_next += 1;
+            m_skipped += 1;
+        }
+
+        int released = 0;
+        while (released < max && m_ready[slot(m_next)])
+        {
+            int index = slot(m_next);
+            *out++ = std::move(*(m_data + index));
+            (m_data + index)->~T();
+            m_ready[index] = false;
+            m_filled -= 1;
+            m_next += 1;
+            released += 1;
+        }
+
+        // a new gap starts now if later elements are waiting
+        m_gap_open = m_filled != 0 && !m_ready[slot(m_next)];
+        if (m_gap_open)
+            m_gap_since = clock_type::now();
+
+        space_cv.notify_all();
+        return released;
+    }
+
+    T *m_data;                                   /**< Slots, an element is constructed where m_ready is set */
+    bool *m_ready;                               /**< Whether each slot holds an element */
+    int m_capacity;                              /**< Number of slots */
+    std::uint64_t m_next;                        /**< Sequence number of the next element to release */
+    int m_filled;                                /**< Number of buffered elements */
+    std::uint64_t m_skipped;                     /**< Sequence numbers skipped so far */
+    duration m_gap_timeout;                      /**< Longest wait for a missing element, zero for no limit */
+    bool m_gap_open;                             /**< The next element is missing while later ones are ready */
+    typename clock_type::time_point m_gap_since; /**< When the current gap opened */
+
+    mutex_type mtx{};          /**< Mutex for thread safety */
+    condition_type cv{};       /**< Signals the consumer: an element or a gap arrived */
+    condition_type space_cv{}; /**< Signals producers: slots were freed */
+};
+
+#endif
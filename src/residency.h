@@ -0,0 +1,120 @@
+#ifndef __RESIDENCY_H__
+#define __RESIDENCY_H__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "histogram.h"
+
+/**
+ * @brief Measures how long elements stay in a queue.
+ *
+ * Keeps one insertion timestamp per queue slot. On removal the age of the
+ * element goes into the residency histogram, on overwrite into a separate
+ * histogram so that evicted elements do not skew the delivered latency.
+ * All calls except the histogram getters must be serialized by the owner
+ * (the queue mutex), which keeps recording free of atomic read-modify-writes.
+ *
+ * @tparam Clock Clock used for timestamps.
+ * @tparam Enabled When false the tracker is empty and all calls are no-ops.
+ */
+template <typename Clock, bool Enabled>
+class ResidencyTracker
+{
+public:
+    ResidencyTracker() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a tracker for a queue with the given number of slots.
+     *
+     * @param slots Capacity of the queue.
+     */
+    explicit ResidencyTracker(int slots) : m_stamps(new typename Clock::time_point[slots]), m_slots(slots) {}
+
+    /**
+     * @brief Copy constructor. Copies the timestamps, not the histograms.
+     *
+     * @param src The tracker to copy from.
+     */
+    ResidencyTracker(const ResidencyTracker &src) : ResidencyTracker(src.m_slots)
+    {
+        std::copy(src.m_stamps.get(), src.m_stamps.get() + m_slots, m_stamps.get());
+    }
+
+    /**
+     * @brief An element was stored in a free slot.
+     *
+     * @param slot Slot index.
+     */
+    void onPush(int slot) { m_stamps[slot] = Clock::now(); }
+
+    /**
+     * @brief The element in a slot was removed by a consumer.
+     *
+     * @param slot Slot index.
+     */
+    void onPop(int slot) { m_popped.recordSerialized(age(slot, Clock::now())); }
+
+    /**
+     * @brief The element in a slot was overwritten by a new one.
+     *
+     * @param slot Slot index.
+     */
+    void onOverwrite(int slot)
+    {
+        auto now = Clock::now();
+        m_overwritten.recordSerialized(age(slot, now));
+        m_stamps[slot] = now;
+    }
+
+    /**
+     * @brief Rotates the timestamps left so that slot first becomes slot 0.
+     *
+     * @param first Slot that becomes the first one.
+     */
+    void rotate(int first) { std::rotate(m_stamps.get(), m_stamps.get() + first, m_stamps.get() + m_slots); }
+
+    /**
+     * @brief Time in queue of the elements that were popped, in nanoseconds.
+     *
+     * @return const LatencyHistogram& Residency histogram.
+     */
+    const LatencyHistogram &popped() const { return m_popped; }
+
+    /**
+     * @brief Time in queue of the elements that were overwritten, in nanoseconds.
+     *
+     * @return const LatencyHistogram& Residency histogram.
+     */
+    const LatencyHistogram &overwritten() const { return m_overwritten; }
+
+private:
+    std::uint64_t age(int slot, typename Clock::time_point now) const
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_stamps[slot]).count();
+        return ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+    }
+
+    std::unique_ptr<typename Clock::time_point[]> m_stamps; /**< Insertion time of each slot */
+    int m_slots;                                             /**< Number of slots */
+    LatencyHistogram m_popped;                               /**< Residency of popped elements */
+    LatencyHistogram m_overwritten;                          /**< Residency of overwritten elements */
+};
+
+/**
+ * @brief Disabled tracker: no timestamps are stored and nothing is recorded.
+ */
+template <typename Clock>
+class ResidencyTracker<Clock, false>
+{
+public:
+    explicit ResidencyTracker(int) {}
+    void onPush(int) {}
+    void onPop(int) {}
+    void onOverwrite(int) {}
+    void rotate(int) {}
+};
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef __SERIALIZATION_H__
+#define __SERIALIZATION_H__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "queue_snapshot.h"
+
+/**
+ * @brief Writer sending segments to a file descriptor with writev().
+ *
+ * The segments go straight from their memory to the kernel: nothing is
+ * copied or allocated in user space.
+ */
+class FdWriter
+{
+public:
+    explicit FdWriter(int fd) : m_fd(fd) {}
+
+    /**
+     * @brief Writes all segments, in order.
+     *
+     * Segments are passed to writev() in batches of kBatch, which stays
+     * below IOV_MAX.
+     *
+     * @param segments Segments to write.
+     * @param count Number of segments.
+     *
+     * @throws std::system_error If writev() fails.
+     */
+    void write(const IoSegment *segments, int count)
+    {
+        for (int first = 0; first < count; first += kBatch)
+            writeBatch(segments + first, std::min(count - first, kBatch));
+    }
+
+private:
+    static constexpr int kBatch = 8; /**< Segments per writev() call */
+
+    void writeBatch(const IoSegment *segments, int n)
+    {
+        iovec iov[kBatch];
+        for (int i = 0; i < n; i++)
+            iov[i] = {const_cast<void *>(segments[i].data), segments[i].size};
+
+        // writev may write less than asked: skip what was written and retry
+        iovec *pending = iov;
+        while (n > 0)
+        {
+            ssize_t written = ::writev(m_fd, pending, n);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "FdWriter: writev() failed");
+            }
+
+            std::size_t left = static_cast<std::size_t>(written);
+            while (n > 0 && left >= pending->iov_len)
+            {
+                left -= pending->iov_len;
+                pending++;
+                n--;
+            }
+            if (n > 0)
+            {
+                pending->iov_base = static_cast<char *>(pending->iov_base) + left;
+                pending->iov_len -= left;
+            }
+        }
+    }
+
+    int m_fd; /**< Destination file descriptor */
+};
+
+/**
+ * @brief Reader filling memory from a file descriptor.
+ */
+class FdReader
+{
+public:
+    explicit FdReader(int fd) : m_fd(fd) {}
+
+    /**
+     * @brief Reads exactly size bytes.
+     *
+     * @param data Destination.
+     * @param size Number of bytes.
+     *
+     * @throws std::system_error If read() fails or the input ends early.
+     */
+    void read(void *data, std::size_t size)
+    {
+        char *out = static_cast<char *>(data);
+        while (size > 0)
+        {
+            ssize_t got = ::read(m_fd, out, size);
+            if (got < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "FdReader: read() failed");
+            }
+            if (got == 0)
+                throw std::system_error(std::make_error_code(std::errc::io_error), "FdReader: unexpected end of input");
+            out += got;
+            size -= static_cast<std::size_t>(got);
+        }
+    }
+
+private:
+    int m_fd; /**< Source file descriptor */
+};
+
+/**
+ * @brief Writer appending segments to a byte vector.
+ */
+class BufferWriter
+{
+public:
+    explicit BufferWriter(std::vector<std::uint8_t> &buffer) : m_buffer(buffer) {}
+
+    void write(const IoSegment *segments, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const auto *bytes = static_cast<const std::uint8_t *>(segments[i].data);
+            m_buffer.insert(m_buffer.end(), bytes, bytes + segments[i].size);
+        }
+    }
+
+private:
+    std::vector<std::uint8_t> &m_buffer; /**< Destination */
+};
+
+/**
+ * @brief Reader consuming a byte buffer.
+ */
+class BufferReader
+{
+public:
+    BufferReader(const std::uint8_t *data, std::size_t size) : m_data(data), m_size(size), m_pos() {}
+
+    /**
+     * @throws std::system_error If the buffer ends early.
+     */
+    void read(void *data, std::size_t size)
+    {
+        if (size > m_size - m_pos)
+            throw std::system_error(std::make_error_code(std::errc::io_error), "BufferReader: unexpected end of input");
+        std::memcpy(data, m_data + m_pos, size);
+        m_pos += size;
+    }
+
+private:
+    const std::uint8_t *m_data; /**< Source */
+    std::size_t m_size;         /**< Size of the source */
+    std::size_t m_pos;          /**< Bytes consumed */
+};
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef __TIME_SERIES_QUEUE_H__
+#define __TIME_SERIES_QUEUE_H__
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "queue.h"
+
+/**
+ * @brief A thread-safe ring of timestamped samples with time-window access.
+ *
+ * Timestamps must not decrease from one push to the next, so the ring is
+ * sorted by time and window queries are a binary search over the ring
+ * followed by a copy of the k matching samples: O(log n + k). As with Queue,
+ * pushing to a full ring overwrites the oldest sample.
+ *
+ * @tparam T The type of the sample values.
+ * @tparam Traits Compile-time configuration, see DefaultQueueTraits. The
+ * mutex, condition and clock types are used.
+ */
+template <typename T, typename Traits = DefaultQueueTraits>
+class TimeSeriesQueue
+{
+public:
+    using mutex_type = typename Traits::mutex_type;
+    using condition_type = typename Traits::condition_type;
+    using clock_type = typename Traits::clock_type;
+    using time_point = typename clock_type::time_point;
+    using duration = typename clock_type::duration;
+
+    /**
+     * @brief A value with its timestamp.
+     */
+    struct Sample
+    {
+        time_point timestamp; /**< When the value was taken */
+        T value;              /**< The value */
+    };
+
+    TimeSeriesQueue() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a ring with a specified capacity.
+     *
+     * @param size The maximum number of samples that the ring can hold.
+     */
+    TimeSeriesQueue(int size)
+        : m_stamps(new time_point[size]), m_data(static_cast<T *>(operator new(size * sizeof(T)))),
+          m_head(), m_filled(), m_capacity(size), m_window(duration::zero())
+    {
+    }
+
+    TimeSeriesQueue(const TimeSeriesQueue &) = delete;
+    TimeSeriesQueue &operator=(const TimeSeriesQueue &) = delete;
+
+    /**
+     * @brief Destructor.
+     *
+     * Destroys the ring and its samples, releasing allocated memory.
+     */
+    ~TimeSeriesQueue()
+    {
+        for (int i = 0; i < m_filled; i++)
+            (m_data + slot(i))->~T();
+        operator delete(m_data);
+
+        cv.notify_all();
+    }
+
+    /**
+     * @brief Keeps only samples within a window of the newest one.
+     *
+     * After each push, samples older than the pushed timestamp minus the
+     * window are evicted. A zero window (the default) disables eviction.
+     *
+     * @param window Maximum age of a sample relative to the newest one.
+     */
+    void setWindow(duration window)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        m_window = window;
+    }
+
+    /**
+     * @brief Adds a sample.
+     *
+     * If the ring is full, the oldest sample is removed to make room.
+     *
+     * @param timestamp Time of the sample, not older than the newest one.
+     * @param value The value to add.
+     *
+     * @throws std::invalid_argument If the timestamp is older than the newest sample.
+     */
+    void push(time_point timestamp, const T &value)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        if (m_filled != 0 && timestamp < m_stamps[slot(m_filled - 1)])
+            throw std::invalid_argument("TimeSeriesQueue: timestamps must not decrease");
+
+        if (m_window != duration::zero())
+            evict(lowerBound(timestamp - m_window));
+
+        if (m_filled < m_capacity)
+        {
+            int tail = slot(m_filled);
+            new (m_data + tail) T(value);
+            m_stamps[tail] = timestamp;
+            m_filled += 1;
+        }
+        else
+        {
+            // overwrite the oldest sample, which becomes the newest
+            *(m_data + m_head) = value;
+            m_stamps[m_head] = timestamp;
+            m_head = slot(1);
+        }
+
+        cv.notify_one();
+    }
+
+    /**
+     * @brief Adds a sample taken now.
+     *
+     * @param value The value to add.
+     */
+    void push(const T &value) { push(clock_type::now(), value); }
+
+    /**
+     * @brief Removes and returns the oldest sample, waiting for one if empty.
+     *
+     * @return Sample The oldest sample.
+     */
+    Sample pop()
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        cv.wait(lck, [this]()
+                { return m_filled != 0; });
+
+        Sample sample{m_stamps[m_head], std::move(*(m_data + m_head))};
+        evict(1);
+        return sample;
+    }
+
+    /**
+     * @brief Removes all samples with a timestamp up to and including ts.
+     *
+     * Does not wait: returns immediately when there are none.
+     *
+     * @param ts Latest timestamp to remove.
+     * @param out Output iterator receiving the removed samples, oldest first.
+     * @return OutputIt Iterator past the last sample written.
+     */
+    template <typename OutputIt>
+    OutputIt popUntil(time_point ts, OutputIt out)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        int count = upperBound(ts);
+        for (int i = 0; i < count; i++)
+        {
+            int index = slot(i);
+            *out++ = Sample{m_stamps[index], std::move(*(m_data + index))};
+        }
+        evict(count);
+        return out;
+    }
+
+    /**
+     * @brief Copies the samples with a timestamp in [t0, t1].
+     *
+     * @param t0 Earliest timestamp.
+     * @param t1 Latest timestamp.
+     * @param out Output iterator receiving the samples, oldest first.
+     * @return OutputIt Iterator past the last sample written.
+     */
+    template <typename OutputIt>
+    OutputIt peekRange(time_point t0, time_point t1, OutputIt out) const
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        int last = upperBound(t1);
+        for (int i = lowerBound(t0); i < last; i++)
+        {
+            int index = slot(i);
+            *out++ = Sample{m_stamps[index], *(m_data + index)};
+        }
+        return out;
+    }
+
+    /**
+     * @brief Removes all samples older than a cutoff.
+     *
+     * @param cutoff Samples with a timestamp before this are removed.
+     * @return int Number of samples removed.
+     */
+    int evictOlderThan(time_point cutoff)
+    {
+        std::unique_lock<mutex_type> lck(mtx);
+        int count = lowerBound(cutoff);
+        evict(count);
+        return count;
+    }
+
+    /**
+     * @brief Number of samples getter.
+     *
+     * @return int Number of samples in the ring.
+     */
+    int count() const { return m_filled; }
+
+    /**
+     * @brief Capacity getter.
+     *
+     * @return int Capacity of the ring.
+     */
+    int size() const { return m_capacity; }
+
+private:
+    /**
+     * @brief Storage index of the i-th oldest sample.
+     */
+    int slot(int i) const
+    {
+        int index = m_head + i;
+        return index >= m_capacity ? index - m_capacity : index;
+    }
+
+    /**
+     * @brief Logical index of the first sample with timestamp >= ts.
+     */
+    int lowerBound(time_point ts) const
+    {
+        int first = 0, count = m_filled;
+        while (count > 0)
+        {
+            int step = count / 2;
+            if (m_stamps[slot(first + step)] < ts)
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+        return first;
+    }
+
+    /**
+     * @brief Logical index of the first sample with timestamp > ts.
+     */
+    int upperBound(time_point ts) const
+    {
+        int first = 0, count = m_filled;
+        while (count > 0)
+        {
+            int step = count / 2;
+            if (!(ts < m_stamps[slot(first + step)]))
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+        return first;
+    }
+
+    /**
+     * @brief Destroys the n oldest samples. The lock must be held.
+     */
+    void evict(int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            (m_data + m_head)->~T();
+            m_head = slot(1);
+        }
+        m_filled -= n;
+    }
+
+    std::unique_ptr<time_point[]> m_stamps; /**< Timestamp of each slot */
+    T *m_data;                              /**< Pointer to the sample values */
+    int m_head;                             /**< Index of the oldest sample */
+    int m_filled;                           /**< Current number of samples */
+    int m_capacity;                         /**< Maximum number of samples */
+    duration m_window;                      /**< Maximum age relative to the newest sample */
+
+    mutable mutex_type mtx{};               /**< Mutex for thread safety */
+    condition_type cv{};                    /**< Condition variable for synchronization */
+};
+
+#endif
@@ -0,0 +1,269 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::mutex registry_mtx;
+    std::vector<std::unique_ptr<TraceRing>> registry;
+    std::size_t ring_capacity = 1 << 14;
+
+    std::size_t roundUpPowerOfTwo(std::size_t value)
+    {
+        std::size_t result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    /**
+     * @brief A begin or end of a named slice on one thread.
+     */
+    struct Slice
+    {
+        std::uint64_t timestamp;
+        const void *queue;
+        const char *name;
+        bool begin;
+    };
+
+    /**
+     * @brief Turns the raw events of one thread into slice begin/end pairs.
+     *
+     * Acquire opens "lock wait", acquired switches to "lock held", waiting on
+     * the condition variable switches to "cv wait" and back, release closes
+     * "lock held".
+     */
+    std::vector<Slice> toSlices(const TraceEvent *events, std::size_t count)
+    {
+        std::vector<Slice> slices;
+        slices.reserve(count * 2);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const TraceEvent &e = events[i];
+            switch (e.type)
+            {
+            case TraceEventType::LockAcquire:
+                slices.push_back({e.timestamp, e.queue, "lock wait", true});
+                break;
+            case TraceEventType::LockAcquired:
+                slices.push_back({e.timestamp, e.queue, "lock wait", false});
+                slices.push_back({e.timestamp, e.queue, "lock held", true});
+                break;
+            case TraceEventType::LockRelease:
+                slices.push_back({e.timestamp, e.queue, "lock held", false});
+                break;
+            case TraceEventType::WaitEnter:
+                slices.push_back({e.timestamp, e.queue, "lock held", false});
+                slices.push_back({e.timestamp, e.queue, "cv wait", true});
+                break;
+            case TraceEventType::WaitExit:
+                slices.push_back({e.timestamp, e.queue, "cv wait", false});
+                slices.push_back({e.timestamp, e.queue, "lock held", true});
+                break;
+            }
+        }
+        return slices;
+    }
+
+    /**
+     * @brief Calls fn(thread_index, slices) for every registered ring.
+     */
+    template <typename Fn>
+    void forEachThread(Fn fn)
+    {
+        std::lock_guard<std::mutex> lck(registry_mtx);
+        std::vector<TraceEvent> buffer;
+        for (const auto &ring : registry)
+        {
+            buffer.resize(ring->capacity());
+            std::size_t count = ring->copy(buffer.data());
+            fn(ring->threadIndex(), toSlices(buffer.data(), count));
+        }
+    }
+
+    // minimal protobuf encoding helpers for the Perfetto writer
+
+    void putVarint(std::string &out, std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    void putVarintField(std::string &out, int field, std::uint64_t value)
+    {
+        putVarint(out, static_cast<std::uint64_t>(field) << 3);
+        putVarint(out, value);
+    }
+
+    void putBytesField(std::string &out, int field, const std::string &bytes)
+    {
+        putVarint(out, (static_cast<std::uint64_t>(field) << 3) | 2);
+        putVarint(out, bytes.size());
+        out += bytes;
+    }
+
+    // field numbers from perfetto/protos/perfetto/trace
+    constexpr int kTracePacket = 1;
+    constexpr int kPacketTimestamp = 8;
+    constexpr int kPacketSequenceId = 10;
+    constexpr int kPacketTrackEvent = 11;
+    constexpr int kPacketSequenceFlags = 13;
+    constexpr int kPacketTrackDescriptor = 60;
+    constexpr int kTrackUuid = 1;
+    constexpr int kTrackName = 2;
+    constexpr int kTrackThread = 4;
+    constexpr int kThreadPid = 1;
+    constexpr int kThreadTid = 2;
+    constexpr int kThreadName = 5;
+    constexpr int kEventType = 9;
+    constexpr int kEventTrackUuid = 11;
+    constexpr int kEventName = 23;
+    constexpr int kSliceBegin = 1;
+    constexpr int kSliceEnd = 2;
+    constexpr int kSequenceId = 1;
+    constexpr int kIncrementalStateCleared = 1;
+}
+
+TraceRing::TraceRing(std::size_t capacity, int thread_index)
+    : m_events(new TraceEvent[roundUpPowerOfTwo(capacity)]),
+      m_mask(roundUpPowerOfTwo(capacity) - 1),
+      m_thread_index(thread_index)
+{
+}
+
+std::size_t TraceRing::copy(TraceEvent *out) const
+{
+    std::uint64_t cleared = m_cleared.load(std::memory_order_acquire);
+    std::uint64_t head = m_head.load(std::memory_order_acquire);
+    std::uint64_t first = head - std::min<std::uint64_t>(head, capacity());
+    first = std::max(first, cleared);
+    for (std::uint64_t i = first; i < head; i++)
+        *out++ = m_events[i & m_mask];
+    return static_cast<std::size_t>(head - first);
+}
+
+void LockTracer::setRingCapacity(std::size_t events)
+{
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    ring_capacity = events;
+}
+
+void LockTracer::clear()
+{
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    for (auto &ring : registry)
+        ring->clear();
+}
+
+std::size_t LockTracer::eventCount()
+{
+    std::size_t total = 0;
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    std::vector<TraceEvent> buffer;
+    for (const auto &ring : registry)
+    {
+        buffer.resize(ring->capacity());
+        total += ring->copy(buffer.data());
+    }
+    return total;
+}
+
+TraceRing &LockTracer::registerThread()
+{
+    // rings outlive their threads so that events of finished threads can
+    // still be exported
+    std::lock_guard<std::mutex> lck(registry_mtx);
+    registry.push_back(std::make_unique<TraceRing>(ring_capacity, static_cast<int>(registry.size())));
+    return *registry.back();
+}
+
+void LockTracer::writeChromeTrace(std::ostream &out)
+{
+    std::uint64_t origin = std::numeric_limits<std::uint64_t>::max();
+    std::vector<std::pair<int, std::vector<Slice>>> threads;
+    forEachThread([&](int thread, std::vector<Slice> slices)
+                  {
+                      if (!slices.empty())
+                          origin = std::min(origin, slices.front().timestamp);
+                      threads.emplace_back(thread, std::move(slices)); });
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    char buffer[256];
+    for (const auto &thread : threads)
+    {
+        std::snprintf(buffer, sizeof(buffer),
+                      "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                      thread.first, thread.first);
+        out << (first ? "" : ",") << buffer;
+        first = false;
+
+        for (const Slice &slice : thread.second)
+        {
+            std::snprintf(buffer, sizeof(buffer),
+                          ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"queue\":\"%p\"}}",
+                          slice.name, slice.begin ? 'B' : 'E',
+                          static_cast<double>(slice.timestamp - origin) / 1000.0,
+                          thread.first, slice.queue);
+            out << buffer;
+        }
+    }
+    out << "]}\n";
+}
+
+void LockTracer::writePerfettoTrace(std::ostream &out)
+{
+    bool first = true;
+    auto writePacket = [&](std::string packet)
+    {
+        putVarintField(packet, kPacketSequenceId, kSequenceId);
+        if (first)
+            putVarintField(packet, kPacketSequenceFlags, kIncrementalStateCleared);
+        first = false;
+
+        std::string framed;
+        putBytesField(framed, kTracePacket, packet);
+        out.write(framed.data(), static_cast<std::streamsize>(framed.size()));
+    };
+
+    forEachThread([&](int thread, std::vector<Slice> slices)
+                  {
+                      std::uint64_t uuid = static_cast<std::uint64_t>(thread) + 1;
+
+                      std::string descriptor;
+                      std::string thread_descriptor;
+                      putVarintField(thread_descriptor, kThreadPid, 1);
+                      putVarintField(thread_descriptor, kThreadTid, uuid);
+                      putBytesField(thread_descriptor, kThreadName, "thread " + std::to_string(thread));
+                      putVarintField(descriptor, kTrackUuid, uuid);
+                      putBytesField(descriptor, kTrackName, "thread " + std::to_string(thread));
+                      putBytesField(descriptor, kTrackThread, thread_descriptor);
+
+                      std::string packet;
+                      putBytesField(packet, kPacketTrackDescriptor, descriptor);
+                      writePacket(std::move(packet));
+
+                      for (const Slice &slice : slices)
+                      {
+                          std::string event;
+                          putVarintField(event, kEventType, slice.begin ? kSliceBegin : kSliceEnd);
+                          putVarintField(event, kEventTrackUuid, uuid);
+                          if (slice.begin)
+                              putBytesField(event, kEventName, slice.name);
+
+                          std::string packet;
+                          putVarintField(packet, kPacketTimestamp, slice.timestamp);
+                          putBytesField(packet, kPacketTrackEvent, event);
+                          writePacket(std::move(packet));
+                      } });
+}
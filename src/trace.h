@@ -0,0 +1,180 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+/**
+ * @brief Kinds of events recorded around the queue mutex and condition variable.
+ */
+enum class TraceEventType : std::uint8_t
+{
+    LockAcquire,  ///< The thread starts waiting for the queue mutex.
+    LockAcquired, ///< The thread now holds the queue mutex.
+    LockRelease,  ///< The thread is about to release the queue mutex.
+    WaitEnter,    ///< The thread blocks on the condition variable (mutex released).
+    WaitExit      ///< The thread woke up from the condition variable (mutex held again).
+};
+
+/**
+ * @brief A single timestamped trace event.
+ */
+struct TraceEvent
+{
+    std::uint64_t timestamp; /**< Steady clock time in nanoseconds */
+    const void *queue;       /**< Queue instance that produced the event */
+    TraceEventType type;     /**< What happened */
+};
+
+/**
+ * @brief Fixed-size ring of trace events owned by a single thread.
+ *
+ * Only the owning thread writes to the ring, so recording is a plain store
+ * followed by a release increment of the head. When the ring is full the
+ * oldest events are overwritten.
+ */
+class TraceRing
+{
+public:
+    TraceRing() = delete; ///< Deleted default constructor to enforce size specification.
+
+    /**
+     * @brief Constructs a ring for the given thread.
+     *
+     * @param capacity Number of events kept, rounded up to a power of two.
+     * @param thread_index Sequential index of the owning thread.
+     */
+    TraceRing(std::size_t capacity, int thread_index);
+
+    /**
+     * @brief Appends an event to the ring.
+     *
+     * Must only be called from the owning thread.
+     *
+     * @param queue Queue instance that produced the event.
+     * @param type Event type.
+     */
+    void record(const void *queue, TraceEventType type)
+    {
+        std::uint64_t head = m_head.load(std::memory_order_relaxed);
+        TraceEvent &event = m_events[head & m_mask];
+        event.timestamp = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+        event.queue = queue;
+        event.type = type;
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies the events currently held, oldest first.
+     *
+     * The result is exact when the owning thread is not recording
+     * concurrently; otherwise the oldest entries may be torn.
+     *
+     * @param out Destination buffer of at least capacity() events.
+     * @return std::size_t Number of events copied.
+     */
+    std::size_t copy(TraceEvent *out) const;
+
+    /**
+     * @brief Discards all recorded events.
+     *
+     * May be called from any thread: it only moves the start of the
+     * exported range, m_head stays owned by the recording thread.
+     */
+    void clear() { m_cleared.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+    std::size_t capacity() const { return m_mask + 1; }
+    int threadIndex() const { return m_thread_index; }
+
+private:
+    std::unique_ptr<TraceEvent[]> m_events;  /**< Event storage */
+    std::size_t m_mask;                      /**< capacity - 1 */
+    int m_thread_index;                      /**< Sequential index of the owning thread */
+    std::atomic<std::uint64_t> m_head{0};    /**< Total number of events recorded */
+    std::atomic<std::uint64_t> m_cleared{0}; /**< Value of m_head at the last clear() */
+};
+
+/**
+ * @brief Tracer that records lock and wait events into per-thread rings.
+ *
+ * Select it through the queue traits (or build with QUEUE_ENABLE_TRACING to
+ * make it the default) and export the result with writeChromeTrace() or
+ * writePerfettoTrace(). Each thread gets its own ring the first time it
+ * records, so the recording path never takes a lock.
+ */
+class LockTracer
+{
+public:
+    static void onLockAcquire(const void *queue) { ring().record(queue, TraceEventType::LockAcquire); }
+    static void onLockAcquired(const void *queue) { ring().record(queue, TraceEventType::LockAcquired); }
+    static void onLockRelease(const void *queue) { ring().record(queue, TraceEventType::LockRelease); }
+    static void onWaitEnter(const void *queue) { ring().record(queue, TraceEventType::WaitEnter); }
+    static void onWaitExit(const void *queue) { ring().record(queue, TraceEventType::WaitExit); }
+
+    /**
+     * @brief Sets the capacity of rings created from now on.
+     *
+     * @param events Number of events kept per thread.
+     */
+    static void setRingCapacity(std::size_t events);
+
+    /**
+     * @brief Discards the events recorded by every thread.
+     */
+    static void clear();
+
+    /**
+     * @brief Total number of events currently held by all rings.
+     *
+     * @return std::size_t Number of events.
+     */
+    static std::size_t eventCount();
+
+    /**
+     * @brief Writes all recorded events in Chrome trace event JSON format.
+     *
+     * The output can be loaded in chrome://tracing or ui.perfetto.dev.
+     *
+     * @param out Stream to write to.
+     */
+    static void writeChromeTrace(std::ostream &out);
+
+    /**
+     * @brief Writes all recorded events as a binary Perfetto protobuf trace.
+     *
+     * @param out Stream to write to (should be opened in binary mode).
+     */
+    static void writePerfettoTrace(std::ostream &out);
+
+private:
+    static TraceRing &ring()
+    {
+        thread_local TraceRing *local = nullptr;
+        if (local == nullptr)
+            local = &registerThread();
+        return *local;
+    }
+
+    static TraceRing &registerThread();
+};
+
+/**
+ * @brief Tracer that does nothing, the default when tracing is disabled.
+ */
+struct NullTracer
+{
+    static void onLockAcquire(const void *) {}
+    static void onLockAcquired(const void *) {}
+    static void onLockRelease(const void *) {}
+    static void onWaitEnter(const void *) {}
+    static void onWaitExit(const void *) {}
+};
+
+#endif
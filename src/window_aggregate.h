@@ -0,0 +1,194 @@
+#ifndef __WINDOW_AGGREGATE_H__
+#define __WINDOW_AGGREGATE_H__
+
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief Fixed-capacity double-ended queue kept monotonic by the caller.
+ *
+ * Used by WindowAggregate: it never allocates after construction because a
+ * monotonic deque never holds more elements than the queue it follows.
+ *
+ * @tparam T The type of the elements.
+ */
+template <typename T>
+class BoundedDeque
+{
+public:
+    explicit BoundedDeque(int capacity)
+        : m_data(new T[capacity > 0 ? capacity : 1]), m_head(), m_size(), m_capacity(capacity > 0 ? capacity : 1)
+    {
+    }
+
+    BoundedDeque(const BoundedDeque &src) : BoundedDeque(src.m_capacity)
+    {
+        for (int i = 0; i < src.m_size; i++)
+            push_back(src.at(i));
+    }
+
+    bool empty() const { return m_size == 0; }
+    const T &front() const { return m_data[m_head]; }
+    const T &back() const { return at(m_size - 1); }
+
+    void push_back(const T &value)
+    {
+        m_data[index(m_size)] = value;
+        m_size += 1;
+    }
+
+    void pop_back() { m_size -= 1; }
+
+    void pop_front()
+    {
+        m_head = index(1);
+        m_size -= 1;
+    }
+
+private:
+    int index(int i) const { return (m_head + i) % m_capacity; }
+    const T &at(int i) const { return m_data[index(i)]; }
+
+    std::unique_ptr<T[]> m_data; /**< Element storage */
+    int m_head;                  /**< Index of the front element */
+    int m_size;                  /**< Number of elements */
+    int m_capacity;              /**< Maximum number of elements */
+};
+
+/**
+ * @brief Point-in-time copy of the statistics of a WindowAggregate.
+ */
+template <typename T, typename Sum>
+struct WindowSnapshot
+{
+    int count;   /**< Number of elements in the queue */
+    Sum sum;     /**< Sum of the elements */
+    double mean; /**< Mean of the elements, 0 if empty */
+    T min;       /**< Smallest element, T{} if empty */
+    T max;       /**< Largest element, T{} if empty */
+};
+
+/**
+ * @brief Queue observer maintaining count, sum, mean, min and max of the
+ * elements currently queued.
+ *
+ * Sum and count are updated in O(1) per element. Min and max are the fronts
+ * of two monotonic deques, which costs amortized O(1) per element since each
+ * element enters and leaves each deque at most once. Queries are O(1).
+ *
+ * Elements leave in the order they entered, so the sum is kept in two
+ * parts: the elements queued before the current epoch, which only shrinks,
+ * and those queued since. When the first part empties it is reset to
+ * exactly zero and the second takes its place. Floating-point rounding
+ * error therefore builds up over at most one queue length instead of the
+ * whole stream, and cancellation against large elements that have left
+ * does not persist.
+ *
+ * A NaN element makes sum() and mean() NaN until it has left the queue and
+ * the epoch it belongs to has drained, at most one queue length later.
+ * min() and max() ignore NaN elements.
+ *
+ * Use it as the observer of a Queue and read it through Queue::observe():
+ * `struct Traits : DefaultQueueTraits { template <typename T> using observer_type = WindowAggregate<T>; };`
+ *
+ * @tparam T An arithmetic element type.
+ */
+template <typename T>
+class WindowAggregate
+{
+    static_assert(std::is_arithmetic<T>::value, "WindowAggregate: T must be arithmetic");
+
+public:
+    using sum_type = typename std::conditional<std::is_integral<T>::value, long long, double>::type;
+    using snapshot_type = WindowSnapshot<T, sum_type>;
+
+    /**
+     * @brief Constructs the aggregate for a queue of the given capacity.
+     *
+     * @param capacity Capacity of the observed queue.
+     */
+    explicit WindowAggregate(int capacity)
+        : m_count(), m_old_count(), m_old_sum(), m_new_sum(), m_min(capacity), m_max(capacity)
+    {
+    }
+
+    void onPush(const T &value)
+    {
+        m_count += 1;
+        m_new_sum += static_cast<sum_type>(value);
+
+        // NaN compares false with everything and would break the ordering
+        if (isNan(value))
+            return;
+
+        // drop candidates that can never be the minimum/maximum again
+        while (!m_min.empty() && value < m_min.back())
+            m_min.pop_back();
+        m_min.push_back(value);
+
+        while (!m_max.empty() && m_max.back() < value)
+            m_max.pop_back();
+        m_max.push_back(value);
+    }
+
+    void onPop(const T &value)
+    {
+        if (m_old_count == 0)
+        {
+            // start an epoch: everything queued now is old
+            m_old_count = m_count;
+            m_old_sum = m_new_sum;
+            m_new_sum = sum_type();
+        }
+        m_count -= 1;
+        m_old_count -= 1;
+        // rebuilt exactly once the old elements are gone
+        m_old_sum = m_old_count == 0 ? sum_type() : m_old_sum - static_cast<sum_type>(value);
+
+        if (isNan(value))
+            return;
+
+        // the oldest element leaves, it is at the front if it was a candidate
+        if (!(m_min.front() < value) && !(value < m_min.front()))
+            m_min.pop_front();
+        if (!(m_max.front() < value) && !(value < m_max.front()))
+            m_max.pop_front();
+    }
+
+    void onOverwrite(const T &evicted, const T &added)
+    {
+        onPop(evicted);
+        onPush(added);
+    }
+
+    int count() const { return m_count; }
+    sum_type sum() const { return m_old_sum + m_new_sum; }
+    double mean() const { return m_count == 0 ? 0.0 : static_cast<double>(sum()) / m_count; }
+    T min() const { return m_min.empty() ? T{} : m_min.front(); }
+    T max() const { return m_max.empty() ? T{} : m_max.front(); }
+
+    /**
+     * @brief Copies all statistics at once.
+     *
+     * @return snapshot_type The statistics.
+     */
+    snapshot_type snapshot() const { return {count(), sum(), mean(), min(), max()}; }
+
+private:
+    static bool isNan(const T &value)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+            return value != value;
+        else
+            return false;
+    }
+
+    int m_count;               /**< Number of queued elements */
+    int m_old_count;           /**< Queued elements from before the current epoch */
+    sum_type m_old_sum;        /**< Sum of the elements from before the current epoch */
+    sum_type m_new_sum;        /**< Sum of the elements queued during the current epoch */
+    BoundedDeque<T> m_min;     /**< Increasing candidates for the minimum */
+    BoundedDeque<T> m_max;     /**< Decreasing candidates for the maximum */
+};
+
+#endif
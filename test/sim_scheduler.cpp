@@ -0,0 +1,312 @@
+#include "sim_scheduler.h"
+
+#include <stdexcept>
+
+namespace
+{
+    SimScheduler *current_instance = nullptr;
+    thread_local SimScheduler *thread_scheduler = nullptr;
+    thread_local int thread_index = -1;
+}
+
+SimClock::time_point SimClock::now() noexcept
+{
+    return current_instance != nullptr ? current_instance->now() : time_point{};
+}
+
+SimScheduler::SimScheduler(std::uint64_t seed) : m_random(seed)
+{
+    if (current_instance != nullptr)
+        throw std::logic_error("SimScheduler: only one scheduler may exist at a time");
+    current_instance = this;
+}
+
+SimScheduler::~SimScheduler()
+{
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        m_aborting = true;
+        m_cv.notify_all();
+    }
+    for (auto &thread : m_threads)
+        if (thread->thread.joinable())
+            thread->thread.join();
+    current_instance = nullptr;
+}
+
+void SimScheduler::spawn(std::function<void()> body)
+{
+    std::unique_lock<std::mutex> lck(m_mtx);
+    if (m_started)
+        throw std::logic_error("SimScheduler: spawn() after run()");
+
+    int id = static_cast<int>(m_threads.size());
+    m_threads.push_back(std::make_unique<Thread>());
+    m_threads.back()->body = std::move(body);
+    m_threads.back()->thread = std::thread(&SimScheduler::threadMain, this, id);
+}
+
+void SimScheduler::run()
+{
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        m_started = true;
+        m_current = pickNext();
+        m_cv.notify_all();
+        m_cv.wait(lck, [this]()
+                  { return m_current == -1; });
+
+        if (m_deadlock || m_steps > m_step_limit)
+        {
+            m_aborting = true;
+            m_cv.notify_all();
+        }
+    }
+
+    for (auto &thread : m_threads)
+        thread->thread.join();
+
+    if (m_exception)
+        std::rethrow_exception(m_exception);
+    if (m_steps > m_step_limit)
+        throw std::runtime_error("SimScheduler: step limit exceeded");
+    if (m_deadlock)
+        throw std::runtime_error("SimScheduler: deadlock, every remaining thread is blocked forever");
+}
+
+SimScheduler *SimScheduler::active() { return thread_scheduler; }
+
+SimScheduler *SimScheduler::instance() { return current_instance; }
+
+void SimScheduler::yield()
+{
+    SimScheduler *scheduler = active();
+    if (scheduler == nullptr)
+        return;
+
+    std::unique_lock<std::mutex> lck(scheduler->m_mtx);
+    scheduler->switchAway(lck);
+}
+
+void SimScheduler::sleepFor(SimClock::duration duration)
+{
+    SimScheduler *scheduler = active();
+    if (scheduler == nullptr)
+        throw std::logic_error("SimScheduler: sleepFor() outside a simulated thread");
+
+    scheduler->block(&scheduler->m_now, scheduler->m_now + duration);
+}
+
+int SimScheduler::self() const { return thread_index; }
+
+bool SimScheduler::block(const void *object, SimClock::time_point deadline)
+{
+    std::unique_lock<std::mutex> lck(m_mtx);
+    Thread &thread = *m_threads[self()];
+    thread.state = State::Blocked;
+    thread.blocked_on = object;
+    thread.deadline = deadline;
+    thread.timed_out = false;
+    switchAway(lck);
+    return thread.timed_out;
+}
+
+void SimScheduler::wakeOne(const void *object)
+{
+    std::unique_lock<std::mutex> lck(m_mtx);
+    std::vector<Thread *> waiters;
+    for (auto &thread : m_threads)
+        if (thread->state == State::Blocked && thread->blocked_on == object)
+            waiters.push_back(thread.get());
+    if (waiters.empty())
+        return;
+
+    Thread &woken = *waiters[m_random() % waiters.size()];
+    woken.state = State::Runnable;
+    woken.blocked_on = nullptr;
+    woken.deadline = SimClock::time_point::max();
+}
+
+void SimScheduler::wakeAll(const void *object)
+{
+    std::unique_lock<std::mutex> lck(m_mtx);
+    for (auto &thread : m_threads)
+        if (thread->state == State::Blocked && thread->blocked_on == object)
+        {
+            thread->state = State::Runnable;
+            thread->blocked_on = nullptr;
+            thread->deadline = SimClock::time_point::max();
+        }
+}
+
+void SimScheduler::threadMain(int id)
+{
+    thread_scheduler = this;
+    thread_index = id;
+
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        m_cv.wait(lck, [this, id]()
+                  { return m_current == id || m_aborting; });
+        if (m_aborting)
+            return;
+    }
+
+    try
+    {
+        m_threads[id]->body();
+    }
+    catch (const Abort &)
+    {
+    }
+    catch (...)
+    {
+        std::unique_lock<std::mutex> lck(m_mtx);
+        if (!m_exception)
+            m_exception = std::current_exception();
+    }
+
+    std::unique_lock<std::mutex> lck(m_mtx);
+    m_threads[id]->state = State::Done;
+    if (!m_aborting)
+    {
+        m_current = pickNext();
+        m_cv.notify_all();
+    }
+}
+
+void SimScheduler::switchAway(std::unique_lock<std::mutex> &lck)
+{
+    if (m_aborting)
+        throw Abort{};
+
+    if (++m_steps > m_step_limit)
+        abort(lck);
+
+    int me = self();
+    int next = pickNext();
+    if (next == me)
+        return;
+
+    m_current = next;
+    m_cv.notify_all();
+    m_cv.wait(lck, [this, me]()
+              { return m_current == me || m_aborting; });
+    if (m_aborting)
+        throw Abort{};
+}
+
+int SimScheduler::pickNext()
+{
+    std::vector<int> runnable;
+    auto collect = [&]()
+    {
+        for (int i = 0; i < static_cast<int>(m_threads.size()); i++)
+            if (m_threads[i]->state == State::Runnable)
+                runnable.push_back(i);
+    };
+
+    collect();
+    if (runnable.empty())
+    {
+        // everybody is blocked: advance virtual time to the next deadline
+        SimClock::time_point next = SimClock::time_point::max();
+        for (auto &thread : m_threads)
+            if (thread->state == State::Blocked && thread->deadline < next)
+                next = thread->deadline;
+
+        if (next != SimClock::time_point::max())
+        {
+            if (next > m_now)
+                m_now = next;
+            for (auto &thread : m_threads)
+                if (thread->state == State::Blocked && thread->deadline <= m_now)
+                {
+                    thread->state = State::Runnable;
+                    thread->blocked_on = nullptr;
+                    thread->deadline = SimClock::time_point::max();
+                    thread->timed_out = true;
+                }
+            collect();
+        }
+    }
+
+    if (runnable.empty())
+    {
+        for (auto &thread : m_threads)
+            if (thread->state != State::Done)
+                m_deadlock = true;
+        return -1;
+    }
+
+    return runnable[m_random() % runnable.size()];
+}
+
+void SimScheduler::abort(std::unique_lock<std::mutex> &)
+{
+    // hand control back to run(), which unwinds every thread
+    m_aborting = true;
+    m_current = -1;
+    m_cv.notify_all();
+    throw Abort{};
+}
+
+void SimMutex::lock()
+{
+    SimScheduler *scheduler = SimScheduler::active();
+    if (scheduler == nullptr)
+    {
+        // used outside the simulation, which is single threaded
+        m_owner = -2;
+        return;
+    }
+
+    SimScheduler::yield();
+    while (m_owner != -1)
+        scheduler->block(this, SimClock::time_point::max());
+    m_owner = scheduler->self();
+}
+
+bool SimMutex::try_lock()
+{
+    SimScheduler::yield();
+    if (m_owner != -1)
+        return false;
+
+    SimScheduler *scheduler = SimScheduler::active();
+    m_owner = scheduler != nullptr ? scheduler->self() : -2;
+    return true;
+}
+
+void SimMutex::unlock()
+{
+    m_owner = -1;
+    if (SimScheduler *scheduler = SimScheduler::instance())
+        scheduler->wakeAll(this);
+}
+
+void SimCondition::notify_one()
+{
+    if (SimScheduler *scheduler = SimScheduler::instance())
+        scheduler->wakeOne(this);
+}
+
+void SimCondition::notify_all()
+{
+    if (SimScheduler *scheduler = SimScheduler::instance())
+        scheduler->wakeAll(this);
+}
+
+std::cv_status SimCondition::wait_until(std::unique_lock<SimMutex> &lck, SimClock::time_point deadline)
+{
+    SimScheduler *scheduler = SimScheduler::active();
+    if (scheduler == nullptr)
+        throw std::logic_error("SimCondition: wait outside a simulated thread");
+
+    // nothing else runs between the unlock and the block, so a notification
+    // cannot be missed
+    lck.unlock();
+    bool timed_out = scheduler->block(this, deadline);
+    lck.lock();
+    return timed_out ? std::cv_status::timeout : std::cv_status::no_timeout;
+}
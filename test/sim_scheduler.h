@@ -0,0 +1,271 @@
+#ifndef __SIM_SCHEDULER_H__
+#define __SIM_SCHEDULER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "queue.h"
+
+/**
+ * @brief Virtual clock driven by the active SimScheduler.
+ *
+ * Time only moves when every simulated thread is blocked, and then jumps
+ * straight to the earliest pending deadline.
+ */
+struct SimClock
+{
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<SimClock, duration>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept;
+};
+
+/**
+ * @brief Deterministic scheduler for testing concurrent code.
+ *
+ * Every spawned function runs on its own thread, but only one of them runs
+ * at a time. Control changes hands only at scheduling points (SimMutex::lock,
+ * SimCondition waits, sleeps and yields), where the next thread is drawn
+ * from the runnable ones with a seeded random generator. The same seed
+ * therefore always produces the same interleaving, and looping over seeds
+ * explores different interleavings. Sleeps and timed waits use SimClock, so
+ * scenarios spanning seconds of virtual time run in microseconds.
+ */
+class SimScheduler
+{
+public:
+    /**
+     * @brief Creates the scheduler. Only one may exist at a time.
+     *
+     * @param seed Seed that selects the interleaving.
+     */
+    explicit SimScheduler(std::uint64_t seed = 0);
+
+    /**
+     * @brief Destructor. Aborts and joins threads if run() was not called.
+     */
+    ~SimScheduler();
+
+    SimScheduler(const SimScheduler &) = delete;
+    SimScheduler &operator=(const SimScheduler &) = delete;
+
+    /**
+     * @brief Adds a simulated thread. It starts running in run().
+     *
+     * @param body Function executed by the thread.
+     */
+    void spawn(std::function<void()> body);
+
+    /**
+     * @brief Runs all simulated threads to completion.
+     *
+     * @throws The first exception escaping a simulated thread.
+     * @throws std::runtime_error If every remaining thread is blocked forever
+     * or the step limit is exceeded.
+     */
+    void run();
+
+    /**
+     * @brief Limits the number of scheduling points, to catch livelocks.
+     *
+     * @param steps Maximum number of scheduling points in run().
+     */
+    void setStepLimit(std::uint64_t steps) { m_step_limit = steps; }
+
+    /**
+     * @brief Number of scheduling points passed so far.
+     *
+     * @return std::uint64_t Step count.
+     */
+    std::uint64_t steps() const { return m_steps; }
+
+    /**
+     * @brief The scheduler running the calling thread.
+     *
+     * @return SimScheduler* Scheduler, or nullptr outside simulated threads.
+     */
+    static SimScheduler *active();
+
+    /**
+     * @brief The scheduler that currently exists, if any.
+     *
+     * @return SimScheduler* Scheduler, or nullptr.
+     */
+    static SimScheduler *instance();
+
+    /**
+     * @brief Scheduling point: lets another runnable thread run.
+     */
+    static void yield();
+
+    /**
+     * @brief Blocks the calling simulated thread for a virtual duration.
+     *
+     * @param duration Virtual time to sleep.
+     */
+    static void sleepFor(SimClock::duration duration);
+
+    // primitives for SimMutex and SimCondition
+
+    /**
+     * @brief Index of the calling simulated thread.
+     *
+     * @return int Thread index.
+     */
+    int self() const;
+
+    /**
+     * @brief Blocks the calling thread on an object until woken or deadline.
+     *
+     * @param object Object waited on.
+     * @param deadline Virtual time to wake up at, time_point::max() for none.
+     * @return bool True if the deadline passed before a wake-up.
+     */
+    bool block(const void *object, SimClock::time_point deadline);
+
+    /**
+     * @brief Wakes one randomly chosen thread blocked on an object.
+     *
+     * @param object Object waited on.
+     */
+    void wakeOne(const void *object);
+
+    /**
+     * @brief Wakes every thread blocked on an object.
+     *
+     * @param object Object waited on.
+     */
+    void wakeAll(const void *object);
+
+    /**
+     * @brief Current virtual time.
+     *
+     * @return SimClock::time_point Virtual time.
+     */
+    SimClock::time_point now() const { return m_now; }
+
+private:
+    enum class State
+    {
+        Runnable,
+        Blocked,
+        Done
+    };
+
+    struct Thread
+    {
+        std::function<void()> body;
+        std::thread thread;
+        State state = State::Runnable;
+        const void *blocked_on = nullptr;
+        SimClock::time_point deadline = SimClock::time_point::max();
+        bool timed_out = false;
+    };
+
+    /**
+     * @brief Thrown inside simulated threads to unwind them on abort.
+     */
+    struct Abort
+    {
+    };
+
+    void threadMain(int id);
+    void switchAway(std::unique_lock<std::mutex> &lck);
+    int pickNext();
+    void abort(std::unique_lock<std::mutex> &lck);
+
+    std::mutex m_mtx;                              /**< Guards the scheduling state */
+    std::condition_variable m_cv;                  /**< Signals baton hand-over */
+    std::vector<std::unique_ptr<Thread>> m_threads; /**< Simulated threads */
+    std::mt19937_64 m_random;                      /**< Interleaving choices */
+    SimClock::time_point m_now{};                  /**< Virtual time */
+    int m_current = -1;                            /**< Thread holding the baton, -1 for run() */
+    bool m_started = false;                        /**< run() was called */
+    bool m_aborting = false;                       /**< Threads are being unwound */
+    bool m_deadlock = false;                       /**< Every remaining thread was blocked forever */
+    std::uint64_t m_steps = 0;                     /**< Scheduling points passed */
+    std::uint64_t m_step_limit = 1000000;          /**< Maximum scheduling points */
+    std::exception_ptr m_exception;                /**< First exception of a simulated thread */
+};
+
+/**
+ * @brief Mutex whose lock() is a scheduling point of the SimScheduler.
+ */
+class SimMutex
+{
+public:
+    void lock();
+    bool try_lock();
+    void unlock();
+
+private:
+    int m_owner = -1; /**< Index of the owning thread, -1 if free */
+};
+
+/**
+ * @brief Condition variable driven by the SimScheduler and SimClock.
+ *
+ * Supports the subset of the std::condition_variable interface used by Queue.
+ */
+class SimCondition
+{
+public:
+    void notify_one();
+    void notify_all();
+
+    /**
+     * @brief Waits until notified or the deadline passes.
+     *
+     * @param lck Lock on a SimMutex, released while waiting.
+     * @param deadline Virtual time to stop waiting at.
+     * @return std::cv_status Whether the deadline passed.
+     */
+    std::cv_status wait_until(std::unique_lock<SimMutex> &lck, SimClock::time_point deadline);
+
+    void wait(std::unique_lock<SimMutex> &lck) { wait_until(lck, SimClock::time_point::max()); }
+
+    template <typename Predicate>
+    void wait(std::unique_lock<SimMutex> &lck, Predicate pred)
+    {
+        while (!pred())
+            wait(lck);
+    }
+
+    template <typename Predicate>
+    bool wait_until(std::unique_lock<SimMutex> &lck, SimClock::time_point deadline, Predicate pred)
+    {
+        while (!pred())
+            if (wait_until(lck, deadline) == std::cv_status::timeout)
+                return pred();
+        return true;
+    }
+
+    template <typename Rep, typename Period, typename Predicate>
+    bool wait_for(std::unique_lock<SimMutex> &lck, const std::chrono::duration<Rep, Period> &timeout, Predicate pred)
+    {
+        return wait_until(lck, SimClock::now() + std::chrono::duration_cast<SimClock::duration>(timeout), pred);
+    }
+};
+
+/**
+ * @brief Queue traits that put a queue under SimScheduler control.
+ */
+struct SimQueueTraits : DefaultQueueTraits
+{
+    using mutex_type = SimMutex;
+    using condition_type = SimCondition;
+    using clock_type = SimClock;
+};
+
+#endif
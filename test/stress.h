@@ -0,0 +1,250 @@
+#ifndef __STRESS_H__
+#define __STRESS_H__
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "tsc_clock.h"
+
+/**
+ * @brief Parameters of a stress run.
+ */
+struct StressConfig
+{
+    int producers = 4;       /**< Number of producer threads */
+    int consumers = 4;       /**< Number of consumer threads */
+    int per_producer = 5000; /**< Elements pushed by each producer */
+};
+
+/**
+ * @brief One logged operation: the element and when the call started and returned.
+ */
+struct StressOperation
+{
+    std::uint64_t value; /**< producer << 32 | sequence number */
+    std::int64_t begin;  /**< Time before the call, in nanoseconds */
+    std::int64_t end;    /**< Time after the call returned, in nanoseconds */
+};
+
+/**
+ * @brief Operation history of a stress run, one log per thread.
+ */
+struct StressHistory
+{
+    int per_producer = 0;                              /**< Elements pushed by each producer */
+    std::vector<std::vector<StressOperation>> pushes;  /**< Push log of each producer */
+    std::vector<std::vector<StressOperation>> pops;    /**< Pop log of each consumer */
+    std::vector<std::uint64_t> remaining;              /**< Elements left in the queue, oldest first */
+};
+
+/**
+ * @brief Outcome of checking a history.
+ */
+struct StressReport
+{
+    bool ok = true;          /**< All invariants hold */
+    std::string error;       /**< First violated invariant */
+    std::size_t pushed = 0;  /**< Elements pushed */
+    std::size_t popped = 0;  /**< Elements popped */
+    std::size_t lost = 0;    /**< Elements neither popped nor left in the queue */
+};
+
+/**
+ * @brief Hammers a queue with producers and consumers at full speed.
+ *
+ * Every thread logs its operations into a preallocated vector with TSC
+ * timestamps, so logging does not serialize the threads. The history is
+ * checked afterwards with checkStressHistory().
+ *
+ * @tparam QueueT Queue type with push(), popWithTimeout(), count() and data().
+ * @param queue Queue to stress, empty on entry, holding uint64_t.
+ * @param config Thread and element counts.
+ * @return StressHistory Logged operations.
+ */
+template <typename QueueT>
+StressHistory runStress(QueueT &queue, const StressConfig &config)
+{
+    auto now = []()
+    { return static_cast<std::int64_t>(TscClock::now().time_since_epoch().count()); };
+
+    StressHistory history;
+    history.per_producer = config.per_producer;
+    history.pushes.resize(config.producers);
+    history.pops.resize(config.consumers);
+
+    std::atomic<int> running_producers{config.producers};
+    std::atomic<bool> start{false};
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < config.producers; p++)
+        threads.emplace_back([&, p]()
+                             {
+                                 auto &log = history.pushes[p];
+                                 log.reserve(config.per_producer);
+                                 while (!start.load())
+                                     std::this_thread::yield();
+
+                                 for (int i = 0; i < config.per_producer; i++)
+                                 {
+                                     std::uint64_t value = (static_cast<std::uint64_t>(p) << 32) | static_cast<std::uint64_t>(i);
+                                     std::int64_t begin = now();
+                                     queue.push(value);
+                                     log.push_back({value, begin, now()});
+                                 }
+                                 running_producers.fetch_sub(1); });
+
+    for (int c = 0; c < config.consumers; c++)
+        threads.emplace_back([&, c]()
+                             {
+                                 auto &log = history.pops[c];
+                                 log.reserve(static_cast<std::size_t>(config.producers) * config.per_producer);
+                                 while (!start.load())
+                                     std::this_thread::yield();
+
+                                 // keep popping until the producers are done and a
+                                 // timeout shows that the queue was drained
+                                 while (true)
+                                 {
+                                     bool producers_done = running_producers.load() == 0;
+                                     std::int64_t begin = now();
+                                     try
+                                     {
+                                         std::uint64_t value = queue.popWithTimeout(10);
+                                         log.push_back({value, begin, now()});
+                                     }
+                                     catch (const std::system_error &)
+                                     {
+                                         if (producers_done)
+                                             break;
+                                     }
+                                 } });
+
+    start.store(true);
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int i = 0; i < queue.count(); i++)
+        history.remaining.push_back(*(queue.data() + i));
+
+    return history;
+}
+
+/**
+ * @brief Checks a stress history against the FIFO queue invariants.
+ *
+ * - every popped element was pushed, and popped at most once;
+ * - each consumer sees the elements of a producer in push order;
+ * - real-time order: if push(a) returned before push(b) started, pop(b)
+ *   must not return before pop(a) started;
+ * - accounting: pushed == popped + remaining + lost, where lost must be 0
+ *   for a queue that never overflows or equal to the reported overwrites.
+ *
+ * @param history Logged operations.
+ * @param expected_lost Number of overwritten elements, -1 if unknown.
+ * @return StressReport Result of the check.
+ */
+inline StressReport checkStressHistory(const StressHistory &history, long expected_lost)
+{
+    StressReport report;
+    auto fail = [&report](const std::string &error)
+    {
+        if (report.ok)
+        {
+            report.ok = false;
+            report.error = error;
+        }
+    };
+
+    const std::size_t producers = history.pushes.size();
+    const std::size_t per_producer = static_cast<std::size_t>(history.per_producer);
+    auto index = [per_producer](std::uint64_t value)
+    { return (value >> 32) * per_producer + (value & 0xffffffffu); };
+
+    for (const auto &log : history.pushes)
+        report.pushed += log.size();
+
+    // every element popped at most once, and only if it was pushed
+    std::vector<const StressOperation *> popped_by(producers * per_producer, nullptr);
+    for (const auto &log : history.pops)
+        for (const StressOperation &op : log)
+        {
+            if ((op.value >> 32) >= producers || (op.value & 0xffffffffu) >= per_producer)
+            {
+                fail("popped an element that was never pushed");
+                continue;
+            }
+            if (popped_by[index(op.value)] != nullptr)
+                fail("element popped twice");
+            popped_by[index(op.value)] = &op;
+            report.popped += 1;
+        }
+
+    for (std::uint64_t value : history.remaining)
+        if ((value >> 32) < producers && (value & 0xffffffffu) < per_producer &&
+            popped_by[index(value)] != nullptr)
+            fail("element both popped and still queued");
+
+    // per consumer, elements of one producer arrive in push order
+    for (const auto &log : history.pops)
+    {
+        std::vector<long> last(producers, -1);
+        for (const StressOperation &op : log)
+        {
+            std::size_t producer = op.value >> 32;
+            long sequence = static_cast<long>(op.value & 0xffffffffu);
+            if (producer >= producers)
+                continue;
+            if (sequence <= last[producer])
+                fail("consumer saw a producer's elements out of order");
+            last[producer] = sequence;
+        }
+    }
+
+    // real-time order, checked with a sweep over push intervals
+    struct Element
+    {
+        const StressOperation *push;
+        const StressOperation *pop;
+    };
+    std::vector<Element> elements;
+    for (const auto &log : history.pushes)
+        for (const StressOperation &op : log)
+            if (const StressOperation *pop = popped_by[index(op.value)])
+                elements.push_back({&op, pop});
+
+    std::vector<Element> by_push_end = elements;
+    std::sort(elements.begin(), elements.end(), [](const Element &a, const Element &b)
+              { return a.push->begin < b.push->begin; });
+    std::sort(by_push_end.begin(), by_push_end.end(), [](const Element &a, const Element &b)
+              { return a.push->end < b.push->end; });
+
+    std::size_t before = 0;
+    std::int64_t latest_pop_begin = INT64_MIN;
+    for (const Element &b : elements)
+    {
+        while (before < by_push_end.size() && by_push_end[before].push->end < b.push->begin)
+            latest_pop_begin = std::max(latest_pop_begin, by_push_end[before++].pop->begin);
+
+        if (latest_pop_begin > b.pop->end)
+            fail("element overtook an element pushed strictly before it");
+    }
+
+    std::size_t accounted = report.popped + history.remaining.size();
+    if (accounted > report.pushed)
+        fail("more elements came out than went in");
+    else
+        report.lost = report.pushed - accounted;
+
+    if (expected_lost >= 0 && report.lost != static_cast<std::size_t>(expected_lost))
+        fail("lost elements do not match the overwrite count");
+
+    return report;
+}
+
+#endif
@@ -1,10 +1,14 @@
 #include "queue.h"
+#include "sim_scheduler.h"
 #include <catch2/catch_test_macros.hpp>
 
 #include <vector>
 #include <iostream>
 #include <chrono>
 #include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
 
 using namespace std::chrono;
 
@@ -99,11 +103,141 @@ TEST_CASE("Pop from Queue (using pop method): without timeout")
     REQUIRE(obtained_data == std::vector<int>{2, 6});
 }
 
-template <typename T>
-void read(Queue<T> &queue, std::vector<T> &elements)
+/**
+ * @brief Element type that counts live objects and detects bad destructions.
+ */
+struct Tracked
+{
+    static int live;
+    static int errors;
+
+    explicit Tracked(int v = 0) : value(v), alive(true) { live++; }
+    Tracked(const Tracked &src) : value(src.value), alive(true) { live++; }
+    Tracked &operator=(const Tracked &src)
+    {
+        if (!alive)
+            errors++;
+        value = src.value;
+        return *this;
+    }
+    ~Tracked()
+    {
+        // destroying storage that holds no live object
+        if (!alive)
+            errors++;
+        alive = false;
+        live--;
+    }
+
+    int value;
+    bool alive;
+};
+
+int Tracked::live = 0;
+int Tracked::errors = 0;
+
+TEST_CASE("Pop destroys exactly the popped element")
+{
+    Tracked::live = 0;
+    Tracked::errors = 0;
+    {
+        Queue<Tracked> queue(3);
+        for (int element : {1, 2, 3, 4})
+            queue.push(Tracked(element));
+
+        REQUIRE(Tracked::live == 3);
+        REQUIRE(queue.pop().value == 2);
+        REQUIRE(Tracked::live == 2);
+        REQUIRE(queue.popWithTimeout(10).value == 3);
+        REQUIRE(Tracked::live == 1);
+
+        queue.push(Tracked(5));
+        queue.push(Tracked(6));
+        REQUIRE(queue.data()->value == 4);
+
+        Queue<Tracked> copy(queue);
+        REQUIRE(Tracked::live == 6);
+    }
+    REQUIRE(Tracked::live == 0);
+    REQUIRE(Tracked::errors == 0);
+}
+
+TEST_CASE("Push moves rvalue elements into the queue")
+{
+    Queue<std::unique_ptr<int>> queue(2);
+    queue.push(std::make_unique<int>(1));
+    queue.push(std::make_unique<int>(2));
+    queue.push(std::make_unique<int>(3)); // overwrites 1 by move assignment
+
+    REQUIRE(*queue.pop() == 2);
+    REQUIRE(*queue.popWithTimeout(10) == 3);
+    REQUIRE(queue.count() == 0);
+}
+
+TEST_CASE("tryPop returns the oldest element without waiting")
+{
+    Queue<int> queue(2);
+    int element = -1;
+    REQUIRE_FALSE(queue.tryPop(element));
+    REQUIRE(element == -1);
+
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    REQUIRE(queue.tryPop(element));
+    REQUIRE(element == 2);
+    REQUIRE(queue.count() == 1);
+}
+
+TEST_CASE("data() linearizes under the lock while other threads push and pop")
+{
+    // std::string is not trivially copyable: rotation moves the elements
+    Queue<std::string> queue(4);
+    std::atomic<bool> done{false};
+
+    std::thread churn([&queue, &done]()
+                      {
+                      std::string element;
+                      for (int i = 0; i < 20000; i++)
+                      {
+                          queue.push(std::string(32, static_cast<char>('a' + i % 26)));
+                          if (i % 3 == 0)
+                              queue.tryPop(element);
+                      }
+                      done = true; });
+
+    while (!done)
+        queue.data();
+    churn.join();
+
+    const std::string *elements = queue.data();
+    for (int i = 0; i < queue.count(); i++)
+        REQUIRE(elements[i].size() == 32);
+}
+
+TEST_CASE("data() puts a wrapped, partly filled ring in order through a const reference")
+{
+    Queue<std::string> queue(5);
+    for (int i = 0; i < 7; i++)
+        queue.push(std::to_string(i)); // 5 6 | 2 3 4
+    queue.pop();                       // 5 6 | _ 3 4
+
+    const Queue<std::string> &view = queue;
+    const std::string *elements = view.data();
+    REQUIRE(std::vector<std::string>(elements, elements + view.count()) ==
+            std::vector<std::string>{"3", "4", "5", "6"});
+
+    queue.push("7");
+    REQUIRE(queue.pop() == "3");
+    REQUIRE(std::vector<std::string>(view.data(), view.data() + view.count()) ==
+            std::vector<std::string>{"4", "5", "6", "7"});
+}
+
+template <typename T, typename Traits>
+void read(Queue<T, Traits> &queue, std::vector<T> &elements)
 {
     elements.push_back(queue.pop()); // pops 1
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+    SimScheduler::sleepFor(seconds(2));
     elements.push_back(queue.pop()); // pops 3
     elements.push_back(queue.pop()); // pops 4
     elements.push_back(queue.pop()); // blocks
@@ -112,44 +246,98 @@ void read(Queue<T> &queue, std::vector<T> &elements)
 
 TEST_CASE("Write and Read from Queue, concurrently")
 {
-    Queue<int> queue(2);
-    std::vector<int> elements;
+    // the outcome must not depend on the interleaving
+    for (std::uint64_t seed = 0; seed < 200; seed++)
+    {
+        SimScheduler scheduler(seed);
+        Queue<int, SimQueueTraits> queue(2);
+        std::vector<int> elements;
 
-    std::thread reader(read<int>, std::ref(queue), std::ref(elements));
+        scheduler.spawn([&queue, &elements]()
+                        { read(queue, elements); });
 
-    std::thread writer([&queue]()
-                       {
+        scheduler.spawn([&queue]()
+                        {
                         queue.push(1);
-                        std::this_thread::sleep_for(std::chrono::seconds(1));
+                        SimScheduler::sleepFor(seconds(1));
                         queue.push(2);
                         queue.push(3);
                         queue.push(4);
-                        std::this_thread::sleep_for(std::chrono::seconds(5));
-                        queue.push(5);
-                        });
-    reader.join();
-    writer.join();
-
-    REQUIRE(elements == std::vector<int>{1, 3, 4, 5});
-    REQUIRE(queue.count() == 0); 
-}
+                        SimScheduler::sleepFor(seconds(5));
+                        queue.push(5); });
+        scheduler.run();
 
-void thisThrows()
-{
-    Queue<int> queue(2);
-    queue.popWithTimeout(100);
-    std::this_thread::sleep_for(std::chrono::seconds(2));
+        REQUIRE(elements == std::vector<int>{1, 3, 4, 5});
+        REQUIRE(queue.count() == 0);
+        REQUIRE(SimClock::now() == SimClock::time_point(seconds(6)));
+    }
 }
 
-TEST_CASE("popWithTimeout throws exception")
+TEST_CASE("Concurrent producers keep their order in every interleaving")
 {
-    try
+    for (std::uint64_t seed = 0; seed < 2000; seed++)
     {
-        thisThrows();
-        CHECK(false);
+        SimScheduler scheduler(seed);
+        Queue<int, SimQueueTraits> queue(8);
+        std::vector<int> elements;
+
+        for (int producer : {0, 100})
+            scheduler.spawn([&queue, producer]()
+                            {
+                            for (int i = 0; i < 4; i++)
+                                queue.push(producer + i); });
+
+        scheduler.spawn([&queue, &elements]()
+                        {
+                        for (int i = 0; i < 8; i++)
+                            elements.push_back(queue.pop()); });
+        scheduler.run();
+
+        std::vector<int> first, second;
+        for (int element : elements)
+            (element < 100 ? first : second).push_back(element);
+
+        REQUIRE(first == std::vector<int>{0, 1, 2, 3});
+        REQUIRE(second == std::vector<int>{100, 101, 102, 103});
     }
-    catch (const std::exception &e)
-    {
-        CHECK(true);
-    }
-}
\ No newline at end of file
+}
+
+TEST_CASE("popWithTimeout waits exactly for the timeout")
+{
+    SimScheduler scheduler;
+    Queue<int, SimQueueTraits> queue(2);
+    bool thrown = false;
+
+    scheduler.spawn([&queue, &thrown]()
+                    {
+                    try
+                    {
+                        queue.popWithTimeout(100);
+                    }
+                    catch (const std::system_error &e)
+                    {
+                        thrown = e.code() == std::errc::operation_would_block;
+                    } });
+    scheduler.run();
+
+    REQUIRE(thrown);
+    REQUIRE(SimClock::now() == SimClock::time_point(milliseconds(100)));
+}
+
+TEST_CASE("popWithTimeout returns an element pushed before the timeout")
+{
+    SimScheduler scheduler;
+    Queue<int, SimQueueTraits> queue(2);
+    int popped = 0;
+
+    scheduler.spawn([&queue, &popped]()
+                    { popped = queue.popWithTimeout(100); });
+    scheduler.spawn([&queue]()
+                    {
+                    SimScheduler::sleepFor(milliseconds(99));
+                    queue.push(7); });
+    scheduler.run();
+
+    REQUIRE(popped == 7);
+    REQUIRE(SimClock::now() == SimClock::time_point(milliseconds(99)));
+}
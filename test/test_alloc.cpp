@@ -0,0 +1,377 @@
+#include "alloc_counter.h"
+#include "byte_ring.h"
+#include "compressed_queue.h"
+#include "decimator.h"
+#include "delay_queue.h"
+#include "histogram.h"
+#include "message_queue.h"
+#include "object_pool.h"
+#include "queue.h"
+#include "realtime.h"
+#include "reorder_buffer.h"
+#include "serialization.h"
+#include "time_series_queue.h"
+#include "window_aggregate.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Built into its own executable, alloc_tests, because alloc_counter.cpp
+ * replaces the global operator new. Assertions are made outside the measured
+ * scopes so that Catch2 allocations are not counted.
+ */
+
+namespace
+{
+    /**
+     * @brief No tracing, residency tracking or recording, whatever the
+     * build options select by default.
+     */
+    struct PlainTraits : DefaultQueueTraits
+    {
+        using tracer_type = NullTracer;
+        static constexpr bool track_residency = false;
+
+        template <typename T>
+        using observer_type = NullObserver<T>;
+    };
+
+    struct AggregateTraits : PlainTraits
+    {
+        template <typename T>
+        using observer_type = WindowAggregate<T>;
+    };
+
+    struct ResidencyTraits : PlainTraits
+    {
+        static constexpr bool track_residency = true;
+    };
+
+    template <typename QueueT>
+    AllocStats churn(QueueT &queue, int rounds)
+    {
+        AllocScope scope;
+        for (int i = 0; i < rounds; i++)
+        {
+            queue.push(i);
+            queue.push(i + 1);
+            queue.pop();
+            queue.popWithTimeout(10);
+        }
+        // fill beyond capacity to overwrite
+        for (int i = 0; i < 3 * rounds; i++)
+            queue.push(i);
+        return scope.stats();
+    }
+}
+
+TEST_CASE("Alloc: counter sees operator new and delete")
+{
+    // volatile keeps the compiler from eliding the new/delete pairs
+    int *volatile single = nullptr;
+    char *volatile array = nullptr;
+
+    AllocScope scope;
+    single = new int(1);
+    array = new char[100];
+    delete single;
+    delete[] array;
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 2);
+    REQUIRE(stats.deallocations == 2);
+    REQUIRE(stats.bytes == sizeof(int) + 100);
+    REQUIRE(stats.usable_bytes >= stats.bytes);
+}
+
+TEST_CASE("Alloc: queue construction allocates only the ring")
+{
+    AllocScope scope;
+    {
+        Queue<int, PlainTraits> queue(1000);
+        (void)queue;
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 1);
+    REQUIRE(stats.bytes == 1000 * sizeof(int));
+    REQUIRE(stats.deallocations == 1);
+}
+
+TEST_CASE("Alloc: queue push, pop and overwrite do not allocate")
+{
+    Queue<int, PlainTraits> plain(16);
+    Queue<int, AggregateTraits> aggregate(16);
+    Queue<int, ResidencyTraits> residency(16);
+
+    AllocStats plain_stats = churn(plain, 1000);
+    AllocStats aggregate_stats = churn(aggregate, 1000);
+    AllocStats residency_stats = churn(residency, 1000);
+
+    REQUIRE(plain_stats.allocations == 0);
+    REQUIRE(aggregate_stats.allocations == 0);
+    REQUIRE(residency_stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: time series queue steady state does not allocate")
+{
+    using Series = TimeSeriesQueue<int>;
+    Series queue(64);
+    queue.setWindow(std::chrono::microseconds(10));
+
+    AllocScope scope;
+    Series::time_point t0 = Series::clock_type::now();
+    for (int i = 0; i < 10000; i++)
+    {
+        queue.push(t0 + std::chrono::microseconds(i), i);
+        if (i % 3 == 0)
+            queue.pop();
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: decimators do not allocate per element")
+{
+    Queue<double, PlainTraits> queue(64);
+    Decimator<Queue<double, PlainTraits>, KeepEveryNth<double>> every(queue, 4);
+    Decimator<Queue<double, PlainTraits>, BucketMean<double>> mean(queue, 8);
+    Decimator<Queue<double, PlainTraits>, BucketMinMax<double>> minmax(queue, 8);
+
+    AllocScope scope;
+    for (int i = 0; i < 10000; i++)
+    {
+        every.push(i);
+        mean.push(i);
+        minmax.push(i);
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: serialize to a file does not allocate")
+{
+    Queue<int, PlainTraits> queue(256);
+    for (int i = 0; i < 300; i++)
+        queue.push(i);
+
+    std::FILE *file = std::fopen("/dev/null", "wb");
+    REQUIRE(file != nullptr);
+    FdWriter writer(fileno(file));
+
+    AllocScope scope;
+    for (int i = 0; i < 100; i++)
+        queue.serialize(writer);
+    AllocStats stats = scope.stats();
+    std::fclose(file);
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: deserialize does not allocate")
+{
+    Queue<int, PlainTraits> queue(256);
+    for (int i = 0; i < 300; i++)
+        queue.push(i);
+
+    std::vector<std::uint8_t> buffer;
+    BufferWriter writer(buffer);
+    queue.serialize(writer);
+
+    Queue<int, PlainTraits> restored(256);
+    AllocScope scope;
+    for (int i = 0; i < 100; i++)
+    {
+        BufferReader reader(buffer.data(), buffer.size());
+        restored.deserialize(reader);
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+    REQUIRE(restored.count() == 256);
+    REQUIRE(restored.pop() == 44);
+}
+
+TEST_CASE("Alloc: data() rotates in place")
+{
+    // short strings fit the small-string buffer: moving them does not allocate
+    Queue<std::string, PlainTraits> queue(8);
+    for (int i = 0; i < 5; i++)
+        queue.push("x");
+
+    AllocScope scope;
+    for (int i = 0; i < 1000; i++)
+    {
+        queue.push("y");
+        queue.pop();
+        queue.data();
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: histogram record does not allocate")
+{
+    LatencyHistogram histogram;
+
+    AllocScope scope;
+    for (std::uint64_t i = 0; i < 100000; i++)
+        histogram.record(i * 37);
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: compressed queue allocates at most once per sealed block")
+{
+    CompressedQueue<std::uint64_t> queue(1024);
+    const int kElements = 100 * CompressedQueue<std::uint64_t>::kBlockSize;
+
+    AllocScope scope;
+    for (int i = 0; i < kElements; i++)
+    {
+        queue.push(static_cast<std::uint64_t>(i));
+        if (i % 2 == 0)
+            queue.pop();
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations <= static_cast<std::uint64_t>(kElements / CompressedQueue<std::uint64_t>::kBlockSize));
+}
+
+TEST_CASE("Alloc: object pool handles through a queue do not allocate")
+{
+    ObjectPool<std::array<std::uint8_t, 4096>> pool(4);
+    Queue<PoolHandle, PlainTraits> queue(4);
+
+    AllocScope scope;
+    for (int i = 0; i < 10000; i++)
+    {
+        PoolHandle handle = pool.acquire();
+        pool[handle][0] = static_cast<std::uint8_t>(i);
+        queue.push(handle);
+        pool.release(queue.pop());
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: byte ring records do not allocate")
+{
+    ByteRing ring(4096);
+    char line[200] = {};
+
+    AllocScope scope;
+    for (int i = 0; i < 10000; i++)
+    {
+        ring.tryPush(line, static_cast<std::size_t>(i % 200));
+        ring.peek();
+        ring.consume();
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: message queue push and visit do not allocate")
+{
+    struct Small
+    {
+        int value;
+    };
+    struct Large
+    {
+        double values[16];
+    };
+    BasicMessageQueue<PlainTraits, Small, Large> queue(8);
+
+    AllocScope scope;
+    long long sum = 0;
+    for (int i = 0; i < 10000; i++)
+    {
+        if (i % 2 == 0)
+            queue.push(Small{i});
+        else
+            queue.push(Large{});
+        queue.pop(Overloaded{[&sum](const Small &m)
+                             { sum += m.value; },
+                             [&sum](const Large &m)
+                             { sum += static_cast<long long>(m.values[0]); }});
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(sum == 4999LL * 5000); // 0 + 2 + ... + 9998
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: reorder buffer push and release do not allocate")
+{
+    ReorderBuffer<int> buffer(16);
+    int released[16];
+
+    AllocScope scope;
+    for (std::uint64_t base = 0; base < 10000; base += 4)
+    {
+        for (std::uint64_t i : {3, 1, 0, 2})
+            buffer.push(base + i, static_cast<int>(base + i));
+        buffer.popRun(released);
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(stats.allocations == 0);
+    REQUIRE(buffer.next() == 10000);
+}
+
+TEST_CASE("Alloc: real-time queue operations do not allocate")
+{
+    Queue<int, RealTimeQueueTraits> queue(8);
+    int element = 0;
+    long long sum = 0;
+
+    AllocScope scope;
+    for (int i = 0; i < 10000; i++)
+    {
+        queue.push(i);
+        queue.push(i);
+        sum += queue.pop();
+        if (queue.tryPop(element))
+            sum += element;
+        if (!queue.tryPopFor(element, 0))
+            sum += 1;
+    }
+    AllocStats stats = scope.stats();
+
+    REQUIRE(sum == 2 * (9999LL * 10000 / 2) + 10000);
+    REQUIRE(stats.allocations == 0);
+}
+
+TEST_CASE("Alloc: delay queue scheduling and release do not allocate")
+{
+    DelayQueue<int> queue(64, std::chrono::microseconds(1));
+    long long sum = 0;
+
+    AllocScope scope;
+    for (int i = 0; i < 10000; i++)
+    {
+        // up to 500 ticks ahead, so that elements cascade between levels
+        queue.push(i, std::chrono::steady_clock::now() + std::chrono::microseconds(i % 500));
+        if (queue.count() == queue.size())
+            while (queue.count() != 0)
+                sum += queue.pop();
+    }
+    while (queue.count() != 0)
+        sum += queue.pop();
+    AllocStats stats = scope.stats();
+
+    REQUIRE(sum == 9999LL * 10000 / 2);
+    REQUIRE(stats.allocations == 0);
+}
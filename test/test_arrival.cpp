@@ -0,0 +1,107 @@
+#include "arrival.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    std::vector<std::uint64_t> take(ArrivalProcess &process, int n)
+    {
+        std::vector<std::uint64_t> times;
+        for (int i = 0; i < n; i++)
+            times.push_back(process.nextArrival());
+        return times;
+    }
+}
+
+TEST_CASE("Arrivals: the same seed gives the same traffic")
+{
+    auto first = makeArrivals("poisson:1000000", 42, 0, 2);
+    auto again = makeArrivals("poisson:1000000", 42, 0, 2);
+    auto other = makeArrivals("poisson:1000000", 42, 1, 2);
+
+    std::vector<std::uint64_t> times = take(*first, 1000);
+    REQUIRE(times == take(*again, 1000));
+    REQUIRE(times != take(*other, 1000));
+
+    // 500k per second per producer: the 1000th arrival comes after about 2 ms
+    REQUIRE(times.back() > 1800000);
+    REQUIRE(times.back() < 2200000);
+    for (std::size_t i = 1; i < times.size(); i++)
+        REQUIRE(times[i - 1] <= times[i]);
+}
+
+TEST_CASE("Arrivals: constant rate interleaves the producers")
+{
+    auto first = makeArrivals("constant:1000", 1, 0, 2);
+    auto second = makeArrivals("constant:1000", 1, 1, 2);
+    REQUIRE(take(*first, 3) == std::vector<std::uint64_t>{0, 2000000, 4000000});
+    REQUIRE(take(*second, 2) == std::vector<std::uint64_t>{1000000, 3000000});
+}
+
+TEST_CASE("Arrivals: on/off bursts stay inside the on periods")
+{
+    // 10 ms bursts every 100 ms
+    auto bursts = makeArrivals("onoff:1000000:10:90", 7, 0, 1);
+    std::vector<std::uint64_t> times = take(*bursts, 25000);
+    for (std::uint64_t time : times)
+        REQUIRE(time % 100000000 < 10000000);
+    // about 10000 arrivals per burst, the last one falls into the third burst
+    REQUIRE(times.back() > 200000000);
+    REQUIRE(times.back() < 210000000);
+}
+
+TEST_CASE("Arrivals: diurnal load peaks and troughs")
+{
+    // 1 s period, the first half above the mean, the second half below
+    auto diurnal = makeArrivals("diurnal:100000:0.8:1000", 3, 0, 1);
+    int high = 0;
+    int low = 0;
+    for (std::uint64_t time = diurnal->nextArrival(); time < 1000000000; time = diurnal->nextArrival())
+        (time < 500000000 ? high : low)++;
+    REQUIRE(high > 3 * low);
+}
+
+TEST_CASE("Arrivals: traces are split round-robin and repeat")
+{
+    TraceArrivals first({100, 110, 130, 160}, 0, 2);
+    TraceArrivals second({100, 110, 130, 160}, 1, 2);
+    // shifted to zero, repeating every 60 + 20 ns
+    REQUIRE(take(first, 4) == std::vector<std::uint64_t>{0, 30, 80, 110});
+    REQUIRE(take(second, 3) == std::vector<std::uint64_t>{10, 60, 90});
+    REQUIRE_THROWS_AS(TraceArrivals({1}, 1, 2), std::invalid_argument);
+    // a single arrival or a single instant has no rate to replay
+    REQUIRE_THROWS_AS(TraceArrivals({1}, 0, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(TraceArrivals({5, 5, 5}, 0, 1), std::invalid_argument);
+}
+
+TEST_CASE("Service times: heavy tail with the requested mean")
+{
+    auto service = makeServiceTime("pareto:1000:1.5", 5, 0);
+    double sum = 0;
+    std::uint64_t max = 0;
+    const int n = 200000;
+    for (int i = 0; i < n; i++)
+    {
+        std::uint64_t time = service->next();
+        REQUIRE(time >= 333);
+        sum += static_cast<double>(time);
+        max = time > max ? time : max;
+    }
+    // the sample mean of a 1.5 tail converges slowly, only check it roughly
+    REQUIRE(sum / n > 700);
+    REQUIRE(sum / n < 1500);
+    REQUIRE(max > 100000);
+
+    REQUIRE(makeServiceTime("constant:250", 5, 0)->next() == 250);
+}
+
+TEST_CASE("Arrivals: malformed specifications are rejected")
+{
+    REQUIRE_THROWS_AS(makeArrivals("poisson", 1, 0, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(makeArrivals("poisson:-5", 1, 0, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(makeArrivals("onoff:100:5", 1, 0, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(makeArrivals("sawtooth:100", 1, 0, 1), std::invalid_argument);
+    REQUIRE_THROWS_AS(makeServiceTime("pareto:1000:1", 1, 0), std::invalid_argument);
+}
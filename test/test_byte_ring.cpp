@@ -0,0 +1,135 @@
+#include "byte_ring.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+    std::string popString(ByteRing &ring)
+    {
+        ByteRecord record = ring.peek();
+        if (!record)
+            return "<empty>";
+        std::string value(reinterpret_cast<const char *>(record.data), record.size);
+        ring.consume();
+        return value;
+    }
+
+    bool pushString(ByteRing &ring, const std::string &value) { return ring.tryPush(value.data(), value.size()); }
+}
+
+TEST_CASE("Byte ring: records come out in order with their sizes")
+{
+    ByteRing ring(256);
+    REQUIRE(ring.capacity() == 256);
+    REQUIRE_FALSE(ring.peek());
+
+    REQUIRE(pushString(ring, "a"));
+    REQUIRE(pushString(ring, ""));
+    REQUIRE(pushString(ring, "hello, world"));
+    REQUIRE(ring.used() == ByteRing::recordSize(1) + ByteRing::recordSize(0) + ByteRing::recordSize(12));
+
+    REQUIRE(popString(ring) == "a");
+    REQUIRE(popString(ring) == "");
+    REQUIRE(popString(ring) == "hello, world");
+    REQUIRE(popString(ring) == "<empty>");
+    REQUIRE(ring.used() == 0);
+}
+
+TEST_CASE("Byte ring: reserve in place, commit fewer bytes")
+{
+    ByteRing ring(128);
+    std::uint8_t *out = ring.reserve(40);
+    REQUIRE(out != nullptr);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(out) % ByteRing::kAlign == 0);
+
+    int written = std::snprintf(reinterpret_cast<char *>(out), 40, "%d items", 17);
+    REQUIRE_FALSE(ring.peek()); // not committed yet
+    ring.commit(static_cast<std::size_t>(written));
+
+    REQUIRE(popString(ring) == "17 items");
+}
+
+TEST_CASE("Byte ring: full ring refuses records")
+{
+    ByteRing ring(64);
+    std::string record(8, 'x'); // 16 bytes with its header
+
+    for (int i = 0; i < 4; i++)
+        REQUIRE(pushString(ring, record));
+    REQUIRE_FALSE(pushString(ring, record));
+    REQUIRE(ring.reserve(0) == nullptr);
+
+    popString(ring);
+    REQUIRE(pushString(ring, record));
+
+    REQUIRE_THROWS_AS(ring.reserve(ring.maxRecordSize() + 1), std::length_error);
+    REQUIRE_THROWS_AS(ByteRing(16), std::invalid_argument);
+}
+
+TEST_CASE("Byte ring: a record that does not fit before the end wraps")
+{
+    ByteRing ring(64);
+    REQUIRE(pushString(ring, std::string(24, 'a'))); // bytes 0-31
+    REQUIRE(pushString(ring, std::string(8, 'b')));  // bytes 32-47
+    REQUIRE(popString(ring) == std::string(24, 'a'));
+
+    // 24 bytes needed, 16 left before the end: skip to the start
+    REQUIRE(pushString(ring, std::string(16, 'c')));
+    REQUIRE(ring.used() == 16 + 16 + 24);
+    REQUIRE(popString(ring) == std::string(8, 'b'));
+    REQUIRE(popString(ring) == std::string(16, 'c'));
+    REQUIRE(ring.used() == 0);
+
+    // the largest record fits in an empty ring wherever it starts
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(pushString(ring, std::string(static_cast<std::size_t>(i), 'd')));
+        popString(ring);
+        REQUIRE(pushString(ring, std::string(ring.maxRecordSize(), 'e')));
+        REQUIRE(popString(ring) == std::string(ring.maxRecordSize(), 'e'));
+    }
+}
+
+TEST_CASE("Byte ring: producer and consumer threads")
+{
+    ByteRing ring(1024);
+    const int kRecords = 100000;
+
+    std::thread producer([&ring]()
+                         {
+                         for (int i = 0; i < kRecords; i++)
+                         {
+                             // sizes 5 to 101 bytes: i, then its low byte repeated
+                             std::size_t size = 5 + static_cast<std::size_t>(i % 97);
+                             std::uint8_t *out;
+                             while ((out = ring.reserve(size)) == nullptr)
+                                 std::this_thread::yield();
+                             std::memset(out, i & 0xff, size);
+                             std::memcpy(out, &i, sizeof(i));
+                             ring.commit(size);
+                         } });
+
+    int bad = 0;
+    for (int i = 0; i < kRecords; i++)
+    {
+        ByteRecord record;
+        while (!(record = ring.peek()))
+            std::this_thread::yield();
+
+        int value;
+        std::memcpy(&value, record.data, sizeof(value));
+        if (value != i || record.size != 5 + static_cast<std::size_t>(i % 97) ||
+            record.data[record.size - 1] != static_cast<std::uint8_t>(i & 0xff))
+            bad++;
+        ring.consume();
+    }
+    producer.join();
+
+    REQUIRE(bad == 0);
+    REQUIRE(ring.used() == 0);
+}
@@ -0,0 +1,61 @@
+#include "arrival.h"
+#include "compare_stats.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    std::vector<double> noisy(double center, int n, std::uint64_t seed)
+    {
+        WorkloadRng rng(seed);
+        std::vector<double> samples;
+        for (int i = 0; i < n; i++)
+            samples.push_back(center * (0.97 + 0.06 * rng.uniform()));
+        return samples;
+    }
+}
+
+TEST_CASE("Compare: median of odd and even samples")
+{
+    REQUIRE(median({3, 1, 2}) == 2);
+    REQUIRE(median({4, 1, 3, 2}) == 2.5);
+    REQUIRE(median({}) == 0);
+}
+
+TEST_CASE("Compare: Mann-Whitney separates shifted samples")
+{
+    std::vector<double> base = noisy(100, 20, 1);
+    std::vector<double> same = noisy(100, 20, 2);
+    std::vector<double> slower = noisy(110, 20, 3);
+
+    REQUIRE(mannWhitneyU(base, same).p_value > 0.05);
+    REQUIRE(mannWhitneyU(base, slower).p_value < 0.001);
+
+    // every base value is below every slower one: U is 0
+    REQUIRE(mannWhitneyU(base, slower).u == 0);
+    REQUIRE(mannWhitneyU({5, 5, 5}, {5, 5, 5}).p_value == 1.0);
+    REQUIRE_THROWS_AS(mannWhitneyU({}, {1}), std::invalid_argument);
+}
+
+TEST_CASE("Compare: bootstrap interval covers the change of the median")
+{
+    std::vector<double> base = noisy(100, 30, 4);
+    std::vector<double> slower = noisy(110, 30, 5);
+
+    Interval interval = bootstrapChange(base, slower);
+    REQUIRE(interval.low > 0.05);
+    REQUIRE(interval.high < 0.15);
+    REQUIRE(interval.low <= interval.high);
+
+    Interval again = bootstrapChange(base, slower);
+    REQUIRE(again.low == interval.low);
+    REQUIRE(again.high == interval.high);
+
+    Interval none = bootstrapChange(base, noisy(100, 30, 6));
+    REQUIRE(none.low < 0);
+    REQUIRE(none.high > 0);
+
+    REQUIRE_THROWS_AS(bootstrapChange({0, 0}, {1}), std::invalid_argument);
+}
@@ -0,0 +1,123 @@
+#include "compressed_queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    template <typename T>
+    void roundTrip(const std::vector<T> &values, int capacity)
+    {
+        CompressedQueue<T> queue(capacity);
+        for (T value : values)
+            queue.push(value);
+
+        // only the newest `capacity` elements survive
+        std::size_t first = values.size() > static_cast<std::size_t>(capacity) ? values.size() - capacity : 0;
+        REQUIRE(queue.count() == static_cast<int>(values.size() - first));
+        for (std::size_t i = first; i < values.size(); i++)
+        {
+            T popped = queue.pop();
+            // compare bit patterns so that NaN and -0.0 are checked exactly
+            REQUIRE(std::memcmp(&popped, &values[i], sizeof(T)) == 0);
+        }
+        REQUIRE(queue.count() == 0);
+    }
+}
+
+TEST_CASE("Compressed queue round-trips integers")
+{
+    std::mt19937_64 random(1);
+    std::vector<std::int64_t> values;
+    for (int i = 0; i < 1000; i++)
+        values.push_back(static_cast<std::int64_t>(random()));
+    values.push_back(std::numeric_limits<std::int64_t>::min());
+    values.push_back(std::numeric_limits<std::int64_t>::max());
+    values.push_back(0);
+
+    roundTrip(values, 2000);
+    roundTrip(values, 300);
+    roundTrip(values, 5);
+    roundTrip(std::vector<std::uint8_t>{255, 0, 1, 254}, 3);
+    roundTrip(std::vector<int>(500, -7), 1000);
+}
+
+TEST_CASE("Compressed queue round-trips floating point")
+{
+    std::mt19937 random(2);
+    std::vector<double> doubles;
+    std::vector<float> floats;
+    for (int i = 0; i < 1000; i++)
+    {
+        doubles.push_back(std::ldexp(static_cast<double>(random()), static_cast<int>(random() % 100) - 50));
+        floats.push_back(static_cast<float>(doubles.back()));
+    }
+    for (double special : {0.0, -0.0, std::numeric_limits<double>::infinity(),
+                           std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::denorm_min()})
+    {
+        doubles.push_back(special);
+        floats.push_back(static_cast<float>(special));
+    }
+
+    roundTrip(doubles, 2000);
+    roundTrip(doubles, 129);
+    roundTrip(floats, 2000);
+    roundTrip(floats, 7);
+}
+
+TEST_CASE("Compressed queue interleaves push and pop across blocks")
+{
+    CompressedQueue<int> queue(1000);
+    int next_push = 0, next_pop = 0;
+    std::mt19937 random(3);
+    for (int step = 0; step < 20000; step++)
+    {
+        if (random() % 2 == 0 || queue.count() == 0)
+            queue.push(next_push++ * 3);
+        else
+            REQUIRE(queue.pop() == next_pop++ * 3);
+    }
+    while (queue.count() != 0)
+        REQUIRE(queue.pop() == next_pop++ * 3);
+    REQUIRE(next_pop == next_push);
+}
+
+TEST_CASE("Compressed queue shrinks sensor-like streams")
+{
+    const int n = 100000;
+    std::mt19937 random(4);
+
+    CompressedQueue<int> integers(n);
+    int reading = 20000;
+    for (int i = 0; i < n; i++)
+    {
+        reading += static_cast<int>(random() % 7) - 3;
+        integers.push(reading);
+    }
+    REQUIRE(integers.memoryUsage() * 4 < n * sizeof(int));
+
+    CompressedQueue<double> temperatures(n);
+    for (int i = 0; i < n; i++)
+        temperatures.push(21.5 + (i / 1000) * 0.25);
+    REQUIRE(temperatures.memoryUsage() * 10 < n * sizeof(double));
+}
+
+TEST_CASE("Compressed queue pop with timeout")
+{
+    CompressedQueue<int> queue(10);
+    REQUIRE_THROWS_AS(queue.popWithTimeout(10), std::system_error);
+
+    std::thread writer([&queue]()
+                       {
+                       std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                       queue.push(42); });
+    REQUIRE(queue.pop() == 42);
+    writer.join();
+}
@@ -0,0 +1,219 @@
+#include "condition.h"
+#include "queue.h"
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    template <typename Condition>
+    struct ConditionTraits : DefaultQueueTraits
+    {
+        using condition_type = Condition;
+    };
+
+    /**
+     * @brief AdaptiveCondition with wake coalescing enabled.
+     */
+    struct CoalescingCondition : AdaptiveCondition
+    {
+        CoalescingCondition()
+            : AdaptiveCondition(AdaptiveLimits{std::chrono::microseconds(20), 8, std::chrono::milliseconds(1)})
+        {
+        }
+    };
+}
+
+TEMPLATE_TEST_CASE("Conditions: producers hand every element to consumers", "", SpinCondition, FutexCondition,
+                   SpinThenParkCondition, EventfdCondition, LifoCondition, AdaptiveCondition,
+                   CoalescingCondition)
+{
+    Queue<int, ConditionTraits<TestType>> queue(8);
+    const int per_producer = 500;
+    std::vector<long long> sums(2);
+
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 2; c++)
+        consumers.emplace_back([&queue, &sums, c]()
+                               {
+                               for (int i = 0; i < per_producer; i++)
+                                   sums[c] += queue.pop(); });
+
+    std::thread producer([&queue]()
+                         {
+                         for (int i = 1; i <= 2 * per_producer; i++)
+                         {
+                             // never overwrite, so that nothing is lost
+                             while (queue.count() == queue.size())
+                                 std::this_thread::yield();
+                             queue.push(i);
+                         } });
+
+    producer.join();
+    for (auto &consumer : consumers)
+        consumer.join();
+
+    long long n = 2 * per_producer;
+    REQUIRE(sums[0] + sums[1] == n * (n + 1) / 2);
+}
+
+TEMPLATE_TEST_CASE("Conditions: timed waits expire", "", SpinCondition, FutexCondition, SpinThenParkCondition,
+                   EventfdCondition, LifoCondition, AdaptiveCondition, CoalescingCondition)
+{
+    Queue<int, ConditionTraits<TestType>> queue(2);
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE_THROWS_AS(queue.popWithTimeout(20), std::system_error);
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+
+    std::thread writer([&queue]()
+                       {
+                       std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                       queue.push(4); });
+    REQUIRE(queue.popWithTimeout(5000) == 4);
+    writer.join();
+}
+
+TEST_CASE("Conditions: LifoCondition wakes the most recent waiter first")
+{
+    std::mutex mtx;
+    LifoCondition cv;
+    int parked = 0;
+    std::vector<int> order;
+
+    std::vector<std::thread> waiters;
+    for (int id = 1; id <= 3; id++)
+    {
+        waiters.emplace_back([&, id]()
+                             {
+                             std::unique_lock<std::mutex> lck(mtx);
+                             parked++;
+                             cv.wait(lck);
+                             order.push_back(id); });
+
+        // the waiter holds mtx until it is on the stack
+        while (true)
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (parked == id)
+                break;
+        }
+    }
+
+    for (std::size_t woken = 1; woken <= 3; woken++)
+    {
+        cv.notify_one();
+        while (true)
+        {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (order.size() == woken)
+                break;
+        }
+    }
+    for (auto &waiter : waiters)
+        waiter.join();
+
+    REQUIRE(order == std::vector<int>{3, 2, 1});
+}
+
+TEST_CASE("Conditions: LifoCondition skips waiters that timed out")
+{
+    std::mutex mtx;
+    LifoCondition cv;
+    bool parked = false;
+    bool woken = false;
+
+    std::thread sleeper([&]()
+                        {
+                        std::unique_lock<std::mutex> lck(mtx);
+                        parked = true;
+                        cv.wait(lck);
+                        woken = true; });
+    while (true)
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (parked)
+            break;
+    }
+
+    // parks above the sleeper, then leaves the stack on timeout
+    {
+        std::unique_lock<std::mutex> lck(mtx);
+        REQUIRE(cv.wait_until(lck, std::chrono::steady_clock::now() + std::chrono::milliseconds(10)) ==
+                std::cv_status::timeout);
+    }
+
+    cv.notify_one();
+    sleeper.join();
+    REQUIRE(woken);
+}
+
+TEST_CASE("Conditions: AdaptiveCondition stops spinning when waits are long")
+{
+    Queue<int, ConditionTraits<AdaptiveCondition>> queue(4);
+    REQUIRE(queue.condition().stats().spin_budget == AdaptiveLimits().max_spin);
+
+    for (int i = 0; i < 5; i++)
+    {
+        std::thread writer([&queue, i]()
+                           {
+                           std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                           queue.push(i); });
+        REQUIRE(queue.pop() == i);
+        writer.join();
+    }
+
+    AdaptiveStats stats = queue.condition().stats();
+    REQUIRE(stats.waits == 5);
+    REQUIRE(stats.parks >= 1);
+    REQUIRE(stats.wait_time >= std::chrono::milliseconds(1));
+    REQUIRE(stats.spin_budget == std::chrono::nanoseconds::zero());
+}
+
+TEST_CASE("Conditions: AdaptiveCondition keeps the spin budget within the limit")
+{
+    AdaptiveCondition cv(AdaptiveLimits{std::chrono::microseconds(100), 1, std::chrono::microseconds(50)});
+    REQUIRE(cv.stats().spin_budget == std::chrono::microseconds(100));
+
+    cv.setLimits(AdaptiveLimits{std::chrono::microseconds(10), 0, std::chrono::microseconds(50)});
+    REQUIRE(cv.stats().spin_budget == std::chrono::microseconds(10));
+    REQUIRE(cv.limits().max_batch == 1);
+}
+
+TEST_CASE("Conditions: AdaptiveCondition coalesces frequent notifications within max_delay")
+{
+    std::mutex mtx;
+    AdaptiveCondition cv(AdaptiveLimits{std::chrono::nanoseconds::zero(), 8, std::chrono::milliseconds(200)});
+
+    // a burst of notifications establishes a short arrival interval
+    for (int i = 0; i < 100; i++)
+        cv.notify_one();
+
+    bool ready = false;
+    std::thread waiter([&]()
+                       {
+                       std::unique_lock<std::mutex> lck(mtx);
+                       cv.wait(lck, [&ready]()
+                               { return ready; }); });
+    while (cv.stats().parked == 0)
+        std::this_thread::yield();
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        ready = true;
+        cv.notify_one();
+    }
+    waiter.join();
+
+    // the wake was deferred, the waiter found the notification on its own
+    AdaptiveStats stats = cv.stats();
+    REQUIRE(stats.batch > 1);
+    REQUIRE(stats.coalesced == 1);
+    REQUIRE(stats.wakes == 0);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
@@ -0,0 +1,83 @@
+#include "decimator.h"
+#include "queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    template <typename T>
+    std::vector<T> drain(Queue<T> &queue)
+    {
+        std::vector<T> elements;
+        while (queue.count() != 0)
+            elements.push_back(queue.pop());
+        return elements;
+    }
+}
+
+TEST_CASE("Decimator keeps every nth element")
+{
+    Queue<int> queue(100);
+    Decimator<Queue<int>, KeepEveryNth<int>> decimator(queue, 3);
+    for (int i = 0; i < 10; i++)
+        decimator.push(i);
+
+    REQUIRE(drain(queue) == std::vector<int>{0, 3, 6, 9});
+}
+
+TEST_CASE("Decimator averages buckets")
+{
+    Queue<double> queue(100);
+    Decimator<Queue<double>, BucketMean<double>> decimator(queue, 4);
+    for (int i = 0; i < 10; i++)
+        decimator.push(i);
+
+    REQUIRE(drain(queue) == std::vector<double>{1.5, 5.5});
+    decimator.flush();
+    REQUIRE(drain(queue) == std::vector<double>{8.5});
+}
+
+TEST_CASE("Decimator keeps bucket extremes in time order")
+{
+    Queue<int> queue(100);
+    Decimator<Queue<int>, BucketMinMax<int>> decimator(queue, 4);
+    for (int element : {5, 9, 1, 5, /**/ 3, 2, 7, 4, /**/ 6, 6, 6, 6})
+        decimator.push(element);
+
+    REQUIRE(drain(queue) == std::vector<int>{9, 1, 2, 7, 6});
+}
+
+TEST_CASE("LTTB keeps spikes and the end points")
+{
+    Queue<int> queue(1000);
+    Decimator<Queue<int>, Lttb<int>> decimator(queue, 10);
+
+    std::vector<int> signal(1000, 0);
+    signal[437] = 100;
+    signal[700] = -50;
+    signal.back() = 1;
+    for (int element : signal)
+        decimator.push(element);
+    decimator.flush();
+
+    std::vector<int> kept = drain(queue);
+    REQUIRE(kept.size() >= 99);
+    REQUIRE(kept.size() <= 102);
+    REQUIRE(std::count(kept.begin(), kept.end(), 100) == 1);
+    REQUIRE(std::count(kept.begin(), kept.end(), -50) == 1);
+    REQUIRE(kept.back() == 1);
+}
+
+TEST_CASE("Decimator policies reject empty buckets")
+{
+    REQUIRE_THROWS_AS(KeepEveryNth<int>(0), std::invalid_argument);
+    REQUIRE_THROWS_AS(BucketMean<int>(0), std::invalid_argument);
+    REQUIRE_THROWS_AS(BucketMinMax<int>(-1), std::invalid_argument);
+    REQUIRE_THROWS_AS(Lttb<int>(0), std::invalid_argument);
+
+    Queue<int> queue(4);
+    REQUIRE_THROWS_AS((Decimator<Queue<int>, Lttb<int>>(queue, 0)), std::invalid_argument);
+}
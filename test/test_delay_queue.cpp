@@ -0,0 +1,145 @@
+#include "delay_queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    struct Scheduled
+    {
+        int id;
+        clock_type::time_point ready_at;
+    };
+}
+
+TEST_CASE("Delay queue: pop waits until the element is due")
+{
+    DelayQueue<int> queue(4);
+    auto start = clock_type::now();
+    queue.push(7, start + std::chrono::milliseconds(30));
+
+    REQUIRE(queue.count() == 1);
+    REQUIRE(queue.pop() == 7);
+    REQUIRE(clock_type::now() - start >= std::chrono::milliseconds(30));
+    REQUIRE(queue.count() == 0);
+}
+
+TEST_CASE("Delay queue: elements come out in due order, never early")
+{
+    // a 10 us tick spreads 60 ms over three levels of the wheel
+    DelayQueue<Scheduled> queue(256, std::chrono::microseconds(10));
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> delay_us(0, 60000);
+
+    auto start = clock_type::now();
+    for (int i = 0; i < 200; i++)
+    {
+        auto ready_at = start + std::chrono::microseconds(delay_us(rng));
+        queue.push(Scheduled{i, ready_at}, ready_at);
+    }
+
+    clock_type::time_point previous = start;
+    for (int i = 0; i < 200; i++)
+    {
+        Scheduled element = queue.pop();
+        REQUIRE(clock_type::now() >= element.ready_at);
+        // elements of the same tick may come out in any order
+        REQUIRE(element.ready_at + queue.tick() >= previous);
+        previous = element.ready_at;
+    }
+}
+
+TEST_CASE("Delay queue: an earlier element wakes a sleeping consumer")
+{
+    DelayQueue<int> queue(4);
+    auto start = clock_type::now();
+    queue.push(1, start + std::chrono::seconds(10));
+
+    std::thread producer([&queue]()
+                         {
+                         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                         queue.push(2, clock_type::now() + std::chrono::milliseconds(10)); });
+
+    REQUIRE(queue.pop() == 2);
+    REQUIRE(clock_type::now() - start < std::chrono::seconds(5));
+    producer.join();
+    REQUIRE(queue.count() == 1);
+}
+
+TEST_CASE("Delay queue: a consumer that leaves hands the timed wait to another")
+{
+    DelayQueue<int> queue(4);
+    std::vector<int> popped(2);
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 2; c++)
+        consumers.emplace_back([&queue, &popped, c]()
+                               { popped[c] = queue.popWithTimeout(5000); });
+    // both consumers wait without a deadline
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // one consumer takes the timed wait for the first element; the second
+    // element is later, so its push wakes nobody
+    auto start = clock_type::now();
+    queue.push(1, start + std::chrono::milliseconds(20));
+    queue.push(2, start + std::chrono::milliseconds(60));
+
+    for (auto &consumer : consumers)
+        consumer.join();
+    REQUIRE(popped[0] + popped[1] == 3);
+    REQUIRE(clock_type::now() - start < std::chrono::seconds(2));
+}
+
+TEST_CASE("Delay queue: tryPop and popWithTimeout return due elements only")
+{
+    DelayQueue<int> queue(4);
+    int element = 0;
+    queue.push(1, clock_type::now() + std::chrono::seconds(10));
+    REQUIRE_FALSE(queue.tryPop(element));
+    REQUIRE_THROWS_AS(queue.popWithTimeout(20), std::system_error);
+
+    // a time in the past is due at once
+    queue.push(2, clock_type::now() - std::chrono::seconds(1));
+    REQUIRE(queue.tryPop(element));
+    REQUIRE(element == 2);
+    queue.push(3, clock_type::now() + std::chrono::milliseconds(10));
+    REQUIRE(queue.popWithTimeout(5000) == 3);
+}
+
+TEST_CASE("Delay queue: elements beyond the wheel's range wait in the overflow list")
+{
+    // 2^24 ticks of 1 ns are about 17 ms
+    DelayQueue<int> queue(4, std::chrono::nanoseconds(1));
+    auto start = clock_type::now();
+    queue.push(2, start + std::chrono::milliseconds(60));
+    queue.push(1, start + std::chrono::milliseconds(5));
+
+    REQUIRE(queue.pop() == 1);
+    REQUIRE(queue.pop() == 2);
+    REQUIRE(clock_type::now() - start >= std::chrono::milliseconds(60));
+}
+
+TEST_CASE("Delay queue: push waits while the queue is full")
+{
+    DelayQueue<int> queue(1);
+    queue.push(1, clock_type::now());
+
+    std::thread producer([&queue]()
+                         { queue.push(2, clock_type::now()); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(queue.count() == 1);
+
+    REQUIRE(queue.pop() == 1);
+    producer.join();
+    REQUIRE(queue.pop() == 2);
+}
+
+TEST_CASE("Delay queue: rejects a tick that is not positive")
+{
+    REQUIRE_THROWS_AS(DelayQueue<int>(4, std::chrono::nanoseconds(0)), std::invalid_argument);
+}
@@ -0,0 +1,151 @@
+#include "merge_reader.h"
+#include "queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Reading
+    {
+        std::uint64_t timestamp;
+        int sensor;
+    };
+
+    struct ByTimestamp
+    {
+        std::uint64_t operator()(const Reading &r) const { return r.timestamp; }
+    };
+
+    using Reader = MergeReader<Queue<Reading>, ByTimestamp>;
+
+    std::vector<std::uint64_t> stamps(const std::vector<Reading> &readings)
+    {
+        std::vector<std::uint64_t> out;
+        for (const Reading &r : readings)
+            out.push_back(r.timestamp);
+        return out;
+    }
+}
+
+TEST_CASE("Merge reader: interleaves inputs in timestamp order")
+{
+    Queue<Reading> a(8), b(8), c(8);
+    for (std::uint64_t t : {1, 4, 7})
+        a.push({t, 0});
+    for (std::uint64_t t : {2, 5, 8})
+        b.push({t, 1});
+    for (std::uint64_t t : {3, 6, 9})
+        c.push({t, 2});
+    a.push({10, 0});
+
+    Reader reader({&a, &b, &c});
+    std::vector<Reading> out;
+    REQUIRE(reader.poll(std::back_inserter(out)) == 8);
+
+    // 9 waits for b to advance past 8
+    REQUIRE(stamps(out) == std::vector<std::uint64_t>{1, 2, 3, 4, 5, 6, 7, 8});
+    REQUIRE(reader.poll(std::back_inserter(out)) == 0);
+
+    reader.advance(1, 9);
+    REQUIRE(reader.poll(std::back_inserter(out)) == 1);
+    REQUIRE(out.back().timestamp == 9);
+
+    reader.close(1);
+    reader.close(2);
+    REQUIRE(reader.poll(std::back_inserter(out)) == 1);
+    REQUIRE(out.back().timestamp == 10);
+    REQUIRE_FALSE(reader.done());
+    reader.close(0);
+    REQUIRE(reader.done());
+}
+
+TEST_CASE("Merge reader: an input that never delivered holds everything back")
+{
+    Queue<Reading> a(8), b(8);
+    a.push({5, 0});
+    a.push({6, 0});
+
+    Reader reader({&a, &b});
+    std::vector<Reading> out;
+    REQUIRE(reader.poll(std::back_inserter(out)) == 0);
+
+    b.push({5, 1});
+    REQUIRE(reader.poll(std::back_inserter(out)) == 2);
+    // equal timestamps go to the lower input first
+    REQUIRE(out[0].sensor == 0);
+    REQUIRE(out[1].sensor == 1);
+    REQUIRE(out[1].timestamp == 5);
+}
+
+TEST_CASE("Merge reader: emitting an element keeps a later watermark")
+{
+    Queue<Reading> a(8), b(8);
+    a.push({50, 0});
+    b.push({80, 1});
+
+    Reader reader({&a, &b});
+    reader.advance(0, 100);
+
+    // a declared 100, so b's 80 need not wait once a's 50 is out
+    std::vector<Reading> out;
+    REQUIRE(reader.poll(std::back_inserter(out)) == 2);
+    REQUIRE(stamps(out) == std::vector<std::uint64_t>{50, 80});
+}
+
+TEST_CASE("Merge reader: batches are limited to the requested size")
+{
+    Queue<Reading> a(16);
+    for (std::uint64_t t = 0; t < 10; t++)
+        a.push({t, 0});
+    Reader reader({&a});
+    reader.close(0);
+
+    std::vector<Reading> out;
+    REQUIRE(reader.poll(std::back_inserter(out), 4) == 4);
+    REQUIRE(reader.poll(std::back_inserter(out), 4) == 4);
+    REQUIRE(reader.poll(std::back_inserter(out), 4) == 2);
+    REQUIRE(stamps(out) == std::vector<std::uint64_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+}
+
+TEST_CASE("Merge reader: concurrent producers give one ordered stream")
+{
+    const int kSensors = 4;
+    const int kReadings = 2000;
+    std::vector<Queue<Reading>> queues;
+    queues.reserve(kSensors);
+    std::vector<Queue<Reading> *> inputs;
+    for (int s = 0; s < kSensors; s++)
+    {
+        queues.emplace_back(kReadings);
+        inputs.push_back(&queues.back());
+    }
+
+    std::vector<std::thread> producers;
+    for (int s = 0; s < kSensors; s++)
+        producers.emplace_back([&queues, s]()
+                               {
+                               // sensors tick with different periods
+                               for (int i = 0; i < kReadings; i++)
+                                   queues[s].push({static_cast<std::uint64_t>(i) * (s + 2), s}); });
+
+    Reader reader(inputs);
+    std::vector<Reading> out;
+    while (out.size() < static_cast<std::size_t>(kSensors * kReadings) / 2)
+        reader.poll(std::back_inserter(out), 64);
+
+    for (auto &producer : producers)
+        producer.join();
+    for (int s = 0; s < kSensors; s++)
+        reader.close(s);
+    while (!reader.done())
+        reader.poll(std::back_inserter(out), 64);
+
+    REQUIRE(out.size() == static_cast<std::size_t>(kSensors * kReadings));
+    REQUIRE(std::is_sorted(out.begin(), out.end(), [](const Reading &x, const Reading &y)
+                           { return x.timestamp < y.timestamp; }));
+}
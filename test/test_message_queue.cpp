@@ -0,0 +1,109 @@
+#include "message_queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+    struct Start
+    {
+        int id;
+    };
+
+    struct Stop
+    {
+        int id;
+        bool emergency;
+    };
+
+    struct Setpoint
+    {
+        std::array<double, 4> values;
+    };
+
+    using ControlQueue = MessageQueue<Start, Stop, Setpoint>;
+}
+
+TEST_CASE("Message queue: messages keep their type and order")
+{
+    ControlQueue queue(8);
+    queue.push(Start{1});
+    queue.push(Setpoint{{1.0, 2.0, 3.0, 4.0}});
+    const Stop stop{1, true};
+    queue.push(stop);
+    REQUIRE(queue.count() == 3);
+
+    std::string seen;
+    auto handler = Overloaded{[&seen](const Start &m)
+                              { seen += "start" + std::to_string(m.id) + " "; },
+                              [&seen](const Stop &m)
+                              { seen += m.emergency ? "estop " : "stop "; },
+                              [&seen](const Setpoint &m)
+                              { seen += "setpoint" + std::to_string(static_cast<int>(m.values[3])) + " "; }};
+    for (int i = 0; i < 3; i++)
+        queue.pop(handler);
+
+    REQUIRE(seen == "start1 setpoint4 estop ");
+    REQUIRE(queue.count() == 0);
+}
+
+TEST_CASE("Message queue: visitors return values and slots hold the largest type")
+{
+    ControlQueue queue(4);
+    STATIC_REQUIRE(sizeof(ControlQueue::message_type) >= sizeof(Setpoint));
+
+    queue.push(Stop{7, false});
+    int id = queue.popWithTimeout(10, Overloaded{[](const Start &m)
+                                                 { return m.id; },
+                                                 [](const Stop &m)
+                                                 { return -m.id; },
+                                                 [](const Setpoint &)
+                                                 { return 0; }});
+    REQUIRE(id == -7);
+
+    REQUIRE_THROWS_AS(queue.popWithTimeout(10, [](const auto &) {}), std::system_error);
+
+    queue.push(Start{3});
+    ControlQueue::message_type raw = queue.pop();
+    REQUIRE(std::get<Start>(raw).id == 3);
+}
+
+TEST_CASE("Message queue: producer and consumer threads")
+{
+    ControlQueue queue(16);
+    const int kMessages = 3000;
+    long long starts = 0;
+    long long stops = 0;
+    int setpoints = 0;
+
+    std::thread consumer([&]()
+                         {
+                         for (int i = 0; i < kMessages; i++)
+                             queue.pop(Overloaded{[&](const Start &m)
+                                                  { starts += m.id; },
+                                                  [&](const Stop &m)
+                                                  { stops += m.id; },
+                                                  [&](const Setpoint &)
+                                                  { setpoints++; }}); });
+
+    for (int i = 0; i < kMessages; i++)
+    {
+        // never overwrite, so that nothing is lost
+        while (queue.count() == queue.size())
+            std::this_thread::yield();
+        if (i % 3 == 0)
+            queue.push(Start{i});
+        else if (i % 3 == 1)
+            queue.push(Stop{i, false});
+        else
+            queue.push(Setpoint{});
+    }
+    consumer.join();
+
+    REQUIRE(setpoints == kMessages / 3);
+    REQUIRE(starts == 3 * (kMessages / 3) * (kMessages / 3 - 1) / 2);
+    REQUIRE(stops == starts + kMessages / 3);
+}
@@ -0,0 +1,117 @@
+#include "object_pool.h"
+#include "queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Frame
+    {
+        explicit Frame(int fill) { pixels.fill(fill); }
+
+        std::uint64_t sequence = 0;
+        std::array<int, 256> pixels;
+    };
+}
+
+TEST_CASE("Object pool: acquire until empty, release and reuse")
+{
+    ObjectPool<Frame> pool(3, 7);
+    REQUIRE(pool.size() == 3);
+
+    std::set<std::uint32_t> taken;
+    for (int i = 0; i < 3; i++)
+    {
+        PoolHandle handle = pool.acquire();
+        REQUIRE(pool[handle].pixels[0] == 7);
+        taken.insert(handle.index);
+    }
+    REQUIRE(taken.size() == 3);
+
+    PoolHandle none;
+    REQUIRE_FALSE(pool.tryAcquire(none));
+    REQUIRE_THROWS_AS(pool.acquireWithTimeout(10), std::system_error);
+
+    // objects keep their contents across release and acquire
+    pool[PoolHandle{1}].sequence = 42;
+    pool.release(PoolHandle{1});
+    PoolHandle again = pool.acquireWithTimeout(10);
+    REQUIRE(again.index == 1);
+    REQUIRE(pool[again].sequence == 42);
+}
+
+TEST_CASE("Object pool: release wakes a blocked acquire")
+{
+    ObjectPool<int> pool(1);
+    PoolHandle first = pool.acquire();
+
+    std::thread releaser([&pool, first]()
+                         {
+                         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                         pool.release(first); });
+
+    auto start = std::chrono::steady_clock::now();
+    PoolHandle second = pool.acquire();
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(15));
+    REQUIRE(second.index == first.index);
+    releaser.join();
+}
+
+TEST_CASE("Object pool: handles recycled through a queue")
+{
+    const int kPool = 8;
+    const int kPerProducer = 5000;
+    ObjectPool<Frame> pool(kPool, 0);
+    Queue<PoolHandle> queue(kPool); // never overwrites: at most kPool handles exist
+
+    std::atomic<std::uint64_t> checksum{0};
+    std::atomic<int> corrupt{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; p++)
+        threads.emplace_back([&pool, &queue, p]()
+                             {
+                             for (int i = 0; i < kPerProducer; i++)
+                             {
+                                 PoolHandle handle = pool.acquire();
+                                 Frame &frame = pool[handle];
+                                 frame.sequence = static_cast<std::uint64_t>(p * kPerProducer + i);
+                                 frame.pixels.fill(static_cast<int>(frame.sequence));
+                                 queue.push(handle);
+                             } });
+    for (int c = 0; c < 2; c++)
+        threads.emplace_back([&pool, &queue, &checksum, &corrupt]()
+                             {
+                             for (int i = 0; i < kPerProducer; i++)
+                             {
+                                 PoolHandle handle = queue.pop();
+                                 const Frame &frame = pool[handle];
+                                 // a frame owned by two threads at once would be torn
+                                 if (frame.pixels.front() != frame.pixels.back() ||
+                                     frame.pixels.front() != static_cast<int>(frame.sequence))
+                                     corrupt++;
+                                 checksum += frame.sequence;
+                                 pool.release(handle);
+                             } });
+
+    for (auto &thread : threads)
+        thread.join();
+
+    std::uint64_t n = 2 * kPerProducer;
+    REQUIRE(corrupt == 0);
+    REQUIRE(checksum == n * (n - 1) / 2);
+
+    // every object came back
+    PoolHandle handle;
+    int available = 0;
+    while (pool.tryAcquire(handle))
+        available++;
+    REQUIRE(available == kPool);
+}
@@ -0,0 +1,49 @@
+#include "perf_counters.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <thread>
+
+TEST_CASE("Perf counters: unavailable events degrade instead of failing")
+{
+    PerfCounters counters;
+    // the reason is reported whenever an event is missing
+    for (int i = 0; i < PerfSample::kEvents; i++)
+        if (!counters.available(static_cast<PerfEvent>(i)))
+            REQUIRE(!counters.error().empty());
+
+    counters.start();
+    volatile std::uint64_t sink = 0;
+    for (int i = 0; i < 1000000; i++)
+        sink = sink + i;
+    std::this_thread::yield();
+    PerfSample sample = counters.stop();
+
+    // an available counter may still be invalid when it was multiplexed
+    // out for the whole measurement
+    for (int i = 0; i < PerfSample::kEvents; i++)
+        if (sample.valid[i])
+            REQUIRE(counters.available(static_cast<PerfEvent>(i)));
+    if (sample.has(PerfEvent::Instructions))
+        REQUIRE(sample[PerfEvent::Instructions] > 1000000);
+    REQUIRE(std::string(PerfCounters::name(PerfEvent::LlcMisses)) == "llc_misses");
+}
+
+TEST_CASE("Perf counters: samples of several threads are summed")
+{
+    PerfSample first{};
+    first.valid[0] = true;
+    first.value[0] = 10;
+    first.valid[1] = true;
+    first.value[1] = 5;
+
+    PerfSample second{};
+    second.valid[0] = true;
+    second.value[0] = 7;
+
+    first.add(second);
+    REQUIRE(first.has(PerfEvent::Cycles));
+    REQUIRE(first[PerfEvent::Cycles] == 17);
+    // missing in one thread means the total is unknown
+    REQUIRE(!first.has(PerfEvent::Instructions));
+}
@@ -0,0 +1,85 @@
+#include "queue.h"
+#include "realtime.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+TEST_CASE("Realtime: queue hands every element across threads")
+{
+    Queue<int, RealTimeQueueTraits> queue(4);
+    const int n = 2000;
+    long long sum = 0;
+
+    std::thread consumer([&queue, &sum]()
+                         {
+                         for (int i = 0; i < n; i++)
+                             sum += queue.pop(); });
+
+    for (int i = 1; i <= n; i++)
+    {
+        // never overwrite, so that nothing is lost
+        while (queue.count() == queue.size())
+            std::this_thread::yield();
+        queue.push(i);
+    }
+    consumer.join();
+
+    REQUIRE(sum == static_cast<long long>(n) * (n + 1) / 2);
+}
+
+TEST_CASE("Realtime: tryPopFor reports a timeout without throwing")
+{
+    Queue<int, RealTimeQueueTraits> queue(4);
+    int element = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE_FALSE(queue.tryPopFor(element, 20));
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+    REQUIRE_FALSE(queue.tryPopFor(element, 0));
+
+    queue.push(7);
+    REQUIRE(queue.tryPopFor(element, 0));
+    REQUIRE(element == 7);
+}
+
+TEST_CASE("Realtime: tryPopFor wakes up when an element arrives")
+{
+    Queue<int, RealTimeQueueTraits> queue(4);
+    std::thread producer([&queue]()
+                         {
+                         std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                         queue.push(42); });
+
+    int element = 0;
+    REQUIRE(queue.tryPopFor(element, 5000));
+    REQUIRE(element == 42);
+    producer.join();
+}
+
+TEST_CASE("Realtime: PiCondition timed wait honours deadlines on other clocks")
+{
+    PiMutex mtx;
+    PiCondition cv;
+    std::unique_lock<PiMutex> lck(mtx);
+
+    auto start = std::chrono::system_clock::now();
+    REQUIRE(cv.wait_until(lck, start + std::chrono::milliseconds(10)) == std::cv_status::timeout);
+    REQUIRE(std::chrono::system_clock::now() - start >= std::chrono::milliseconds(10));
+
+    // deadline already passed
+    REQUIRE(cv.wait_until(lck, std::chrono::steady_clock::now() - std::chrono::seconds(1)) ==
+            std::cv_status::timeout);
+
+    bool ready = false;
+    std::thread notifier([&]()
+                         {
+                         std::lock_guard<PiMutex> guard(mtx);
+                         ready = true;
+                         cv.notify_one(); });
+    REQUIRE(cv.wait_until(lck, std::chrono::steady_clock::now() + std::chrono::seconds(5), [&ready]()
+                          { return ready; }));
+    lck.unlock();
+    notifier.join();
+}
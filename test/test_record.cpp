@@ -0,0 +1,102 @@
+#include "queue.h"
+#include "record.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct RecordedTraits : DefaultQueueTraits
+    {
+        template <typename T>
+        using observer_type = RecordingObserver<T>;
+    };
+
+    std::string logPath(const char *name)
+    {
+        return std::string("/tmp/queue_record_") + name + ".bin";
+    }
+}
+
+TEST_CASE("Record: operations of a queue are written to the log")
+{
+    std::string path = logPath("basic");
+    Queue<int, RecordedTraits> queue(2);
+
+    OpRecorder::start(path, true);
+    std::thread producer([&queue]()
+                         {
+                         for (int i = 1; i <= 3; i++)
+                             queue.push(i); });
+    producer.join();
+    REQUIRE(queue.pop() == 2);
+    OpRecorder::stop();
+
+    std::vector<OpRecord> records = OpRecorder::readLog(path);
+    std::remove(path.c_str());
+
+    REQUIRE(records.size() == 4);
+    REQUIRE(records[0].op == RecordOp::Push);
+    REQUIRE(records[1].op == RecordOp::Push);
+    REQUIRE(records[2].op == RecordOp::Overwrite);
+    REQUIRE(records[3].op == RecordOp::Pop);
+
+    REQUIRE(records[1].depth == 2);
+    REQUIRE(records[2].depth == 2);
+    REQUIRE(records[3].depth == 1);
+
+    REQUIRE(records[2].payload_size == sizeof(int));
+    REQUIRE(static_cast<int>(records[2].payload) == 3);
+    REQUIRE(static_cast<int>(records[3].payload) == 2);
+
+    // one queue, pushes and the pop come from different threads
+    for (const OpRecord &record : records)
+        REQUIRE(record.queue == 0);
+    REQUIRE(records[0].thread != records[3].thread);
+    for (std::size_t i = 1; i < records.size(); i++)
+        REQUIRE(records[i - 1].timestamp <= records[i].timestamp);
+}
+
+TEST_CASE("Record: nothing is captured outside a capture and without payload")
+{
+    std::string path = logPath("idle");
+    Queue<int, RecordedTraits> first(4);
+    Queue<int, RecordedTraits> second(4);
+    first.push(1); // not recorded
+
+    OpRecorder::start(path);
+    second.push(7);
+    first.push(2);
+    OpRecorder::stop();
+    first.push(3); // not recorded
+
+    std::vector<OpRecord> records = OpRecorder::readLog(path);
+    std::remove(path.c_str());
+
+    REQUIRE(records.size() == 2);
+    REQUIRE(records[0].queue == 0);
+    REQUIRE(records[1].queue == 1);
+    REQUIRE(records[1].depth == 2);
+    REQUIRE(records[0].payload_size == 0);
+    REQUIRE(records[0].payload == 0);
+}
+
+TEST_CASE("Record: invalid logs and double starts are rejected")
+{
+    std::string path = logPath("invalid");
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    std::fputs("not a log at all", file);
+    std::fclose(file);
+    REQUIRE_THROWS_AS(OpRecorder::readLog(path), std::invalid_argument);
+
+    OpRecorder::start(path);
+    REQUIRE_THROWS_AS(OpRecorder::start(path), std::logic_error);
+    OpRecorder::stop();
+    REQUIRE(OpRecorder::readLog(path).empty());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,112 @@
+#include "reorder_buffer.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+TEST_CASE("Reorder buffer: releases contiguous runs in sequence order")
+{
+    ReorderBuffer<int> buffer(8);
+    std::vector<int> out;
+
+    REQUIRE(buffer.push(2, 20));
+    REQUIRE(buffer.push(1, 10));
+    REQUIRE_THROWS_AS(buffer.popRunWithTimeout(10, std::back_inserter(out)), std::system_error);
+
+    REQUIRE(buffer.push(0, 0));
+    REQUIRE(buffer.push(4, 40));
+    REQUIRE(buffer.popRun(std::back_inserter(out)) == 3);
+    REQUIRE(out == std::vector<int>{0, 10, 20});
+    REQUIRE(buffer.next() == 3);
+    REQUIRE(buffer.count() == 1);
+
+    // released and duplicate sequence numbers are dropped
+    REQUIRE_FALSE(buffer.push(1, 11));
+    REQUIRE_FALSE(buffer.push(4, 41));
+
+    REQUIRE(buffer.push(3, 30));
+    REQUIRE(buffer.popRun(std::back_inserter(out), 1) == 1);
+    REQUIRE(buffer.popRun(std::back_inserter(out), 1) == 1);
+    REQUIRE(out == std::vector<int>{0, 10, 20, 30, 40});
+    REQUIRE(buffer.skipped() == 0);
+}
+
+TEST_CASE("Reorder buffer: a gap times out and the late element is dropped")
+{
+    ReorderBuffer<int> buffer(8, 100);
+    buffer.setGapTimeout(milliseconds(20));
+    std::vector<int> out;
+
+    buffer.push(101, 1);
+    buffer.push(102, 2);
+    auto start = steady_clock::now();
+    REQUIRE(buffer.popRun(std::back_inserter(out)) == 2);
+    REQUIRE(steady_clock::now() - start >= milliseconds(15));
+    REQUIRE(out == std::vector<int>{1, 2});
+    REQUIRE(buffer.skipped() == 1);
+    REQUIRE(buffer.next() == 103);
+
+    REQUIRE_FALSE(buffer.push(100, 0));
+
+    // a timed pop shorter than the gap timeout still expires
+    buffer.setGapTimeout(seconds(10));
+    buffer.push(105, 5);
+    REQUIRE_THROWS_AS(buffer.popRunWithTimeout(10, std::back_inserter(out)), std::system_error);
+}
+
+TEST_CASE("Reorder buffer: a push a full ring ahead waits for the consumer")
+{
+    ReorderBuffer<int> buffer(4);
+    for (int i = 1; i < 4; i++)
+        buffer.push(static_cast<std::uint64_t>(i), i);
+
+    std::thread late([&buffer]()
+                     { buffer.push(5, 5); });
+    std::this_thread::sleep_for(milliseconds(10));
+    REQUIRE(buffer.count() == 3);
+
+    std::vector<int> out;
+    buffer.push(0, 0);
+    REQUIRE(buffer.popRun(std::back_inserter(out)) == 4);
+    late.join();
+    REQUIRE(buffer.count() == 1);
+}
+
+TEST_CASE("Reorder buffer: workers completing out of order")
+{
+    const int kItems = 20000;
+    const int kWorkers = 4;
+    ReorderBuffer<int> buffer(64);
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < kWorkers; w++)
+        workers.emplace_back([&buffer, w]()
+                             {
+                             // each worker owns every kWorkers-th item and shuffles small blocks
+                             std::mt19937 rng(static_cast<unsigned>(w));
+                             std::vector<int> items;
+                             for (int i = w; i < kItems; i += kWorkers)
+                                 items.push_back(i);
+                             for (std::size_t b = 0; b < items.size(); b += 4)
+                                 std::shuffle(items.begin() + b, items.begin() + std::min(items.size(), b + 4), rng);
+                             for (int item : items)
+                                 buffer.push(static_cast<std::uint64_t>(item), item); });
+
+    std::vector<int> out;
+    while (out.size() < static_cast<std::size_t>(kItems))
+        buffer.popRun(std::back_inserter(out), 32);
+    for (auto &worker : workers)
+        worker.join();
+
+    std::vector<int> expected(kItems);
+    std::iota(expected.begin(), expected.end(), 0);
+    REQUIRE(out == expected);
+}
@@ -0,0 +1,109 @@
+#include "queue.h"
+#include "histogram.h"
+#include "tsc_clock.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <vector>
+
+struct ResidencyTraits : DefaultQueueTraits
+{
+    static constexpr bool track_residency = true;
+};
+
+struct TscResidencyTraits : ResidencyTraits
+{
+    using clock_type = TscClock;
+};
+
+TEST_CASE("Histogram buckets and percentiles")
+{
+    LatencyHistogram histogram;
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.percentile(0.5) == 0);
+
+    // every value falls inside the bounds of its own bucket
+    for (std::uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 31ull, 32ull, 1000ull, 123456789ull})
+    {
+        int bucket = LatencyHistogram::bucketOf(value);
+        CHECK(value <= LatencyHistogram::upperBound(bucket));
+        if (bucket > 0)
+            CHECK(value > LatencyHistogram::upperBound(bucket - 1));
+    }
+    CHECK(LatencyHistogram::bucketOf(~0ull) == LatencyHistogram::kBuckets - 1);
+
+    for (std::uint64_t value = 1; value <= 1000; value++)
+        histogram.record(value);
+
+    REQUIRE(histogram.count() == 1000);
+    CHECK(histogram.max() == 1000);
+    CHECK(histogram.mean() == 500.5);
+    // relative error is bounded by the sub-bucket width
+    CHECK(histogram.percentile(0.5) >= 500);
+    CHECK(histogram.percentile(0.5) <= 532);
+    CHECK(histogram.percentile(1.0) == 1000);
+
+    LatencyHistogram other;
+    other.record(5000);
+    histogram.merge(other);
+    CHECK(histogram.count() == 1001);
+    CHECK(histogram.max() == 5000);
+    CHECK(histogram.percentile(1.0) == 5000);
+
+    histogram.reset();
+    CHECK(histogram.count() == 0);
+}
+
+TEST_CASE("Residency of popped and overwritten elements is recorded separately")
+{
+    Queue<int, ResidencyTraits> queue(2);
+    queue.push(1);
+    queue.push(2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    queue.push(3); // overwrites 1
+
+    REQUIRE(queue.overwrittenResidency().count() == 1);
+    CHECK(queue.overwrittenResidency().max() >= 5000000);
+
+    REQUIRE(queue.pop() == 2);
+    REQUIRE(queue.pop() == 3);
+    REQUIRE(queue.residency().count() == 2);
+    CHECK(queue.residency().max() >= 5000000);
+}
+
+TEST_CASE("Residency stamps follow the elements when storage is linearized")
+{
+    Queue<int, ResidencyTraits> queue(3);
+    for (int element : {1, 2, 3, 4})
+        queue.push(element);
+
+    std::vector<int> obtained_data{};
+    for (int i = 0; i < queue.count(); i++)
+        obtained_data.push_back(*(queue.data() + i));
+    REQUIRE(obtained_data == std::vector<int>{2, 3, 4});
+
+    queue.push(5);
+    REQUIRE(queue.pop() == 3);
+    REQUIRE(queue.residency().count() == 1);
+    REQUIRE(queue.overwrittenResidency().count() == 2);
+}
+
+TEST_CASE("TSC clock tracks steady_clock")
+{
+    using namespace std::chrono;
+    auto tsc_start = TscClock::now();
+    auto steady_start = steady_clock::now();
+    std::this_thread::sleep_for(milliseconds(10));
+    auto tsc_elapsed = TscClock::now() - tsc_start;
+    auto steady_elapsed = steady_clock::now() - steady_start;
+
+    CHECK(tsc_elapsed.count() > 0);
+    auto difference = duration_cast<microseconds>(tsc_elapsed - steady_elapsed).count();
+    CHECK(difference < 500);
+    CHECK(difference > -500);
+
+    Queue<int, TscResidencyTraits> queue(1);
+    queue.push(1);
+    queue.pop();
+    CHECK(queue.residency().count() == 1);
+}
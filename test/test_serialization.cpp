@@ -0,0 +1,130 @@
+#include "queue.h"
+#include "serialization.h"
+#include "window_aggregate.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    struct SnapshotTraits : DefaultQueueTraits
+    {
+        template <typename T>
+        using observer_type = WindowAggregate<T>;
+    };
+
+    template <typename QueueT>
+    std::vector<int> contents(QueueT &queue)
+    {
+        std::vector<int> data;
+        for (int i = 0; i < queue.count(); i++)
+            data.push_back(*(queue.data() + i));
+        return data;
+    }
+}
+
+TEST_CASE("Serialization: wrapped queue to memory and back")
+{
+    Queue<int> queue(4);
+    for (int element : {1, 2, 3, 4, 5, 6})
+        queue.push(element); // the ring now wraps: 3 4 | 5 6
+
+    std::vector<std::uint8_t> buffer;
+    BufferWriter writer(buffer);
+    queue.serialize(writer);
+    REQUIRE(buffer.size() == sizeof(QueueSnapshotHeader) + 4 * sizeof(int));
+
+    Queue<int, SnapshotTraits> restored(8);
+    restored.push(99);
+    BufferReader reader(buffer.data(), buffer.size());
+    restored.deserialize(reader);
+
+    REQUIRE(contents(restored) == std::vector<int>{3, 4, 5, 6});
+    REQUIRE(restored.observe([](const WindowAggregate<int> &a)
+                             { return a.sum(); }) == 18);
+    REQUIRE(restored.pop() == 3);
+}
+
+TEST_CASE("Serialization: through a file descriptor")
+{
+    Queue<double> queue(1000);
+    for (int i = 0; i < 1500; i++)
+        queue.push(i * 0.5);
+
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    FdWriter writer(fileno(file));
+    queue.serialize(writer);
+    std::rewind(file);
+
+    Queue<double> restored(1000);
+    FdReader reader(fileno(file));
+    restored.deserialize(reader);
+    std::fclose(file);
+
+    REQUIRE(restored.count() == 1000);
+    for (int i = 500; i < 1500; i++)
+        REQUIRE(restored.pop() == i * 0.5);
+}
+
+TEST_CASE("Serialization: FdWriter writes every segment")
+{
+    int values[20];
+    IoSegment segments[20];
+    for (int i = 0; i < 20; i++)
+    {
+        values[i] = i;
+        segments[i] = {&values[i], sizeof(int)};
+    }
+
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file != nullptr);
+    FdWriter writer(fileno(file));
+    writer.write(segments, 20);
+    std::rewind(file);
+
+    int read[20] = {};
+    FdReader reader(fileno(file));
+    reader.read(read, sizeof(read));
+    std::fclose(file);
+
+    for (int i = 0; i < 20; i++)
+        REQUIRE(read[i] == i);
+}
+
+TEST_CASE("Serialization: incompatible snapshots are rejected")
+{
+    Queue<int> queue(4);
+    for (int element : {1, 2, 3})
+        queue.push(element);
+
+    std::vector<std::uint8_t> buffer;
+    BufferWriter writer(buffer);
+    queue.serialize(writer);
+
+    SECTION("element size")
+    {
+        Queue<long long> other(4);
+        BufferReader reader(buffer.data(), buffer.size());
+        REQUIRE_THROWS_AS(other.deserialize(reader), std::invalid_argument);
+    }
+
+    SECTION("capacity")
+    {
+        Queue<int> small(2);
+        BufferReader reader(buffer.data(), buffer.size());
+        REQUIRE_THROWS_AS(small.deserialize(reader), std::invalid_argument);
+    }
+
+    SECTION("truncated")
+    {
+        Queue<int> other(4);
+        other.push(7);
+        BufferReader reader(buffer.data(), buffer.size() - 1);
+        REQUIRE_THROWS_AS(other.deserialize(reader), std::system_error);
+        // the previous contents are dropped before the read
+        REQUIRE(other.count() == 0);
+    }
+}
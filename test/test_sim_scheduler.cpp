@@ -0,0 +1,65 @@
+#include "sim_scheduler.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace std::chrono;
+
+TEST_CASE("Simulated sleeps advance virtual time only")
+{
+    SimScheduler scheduler;
+    std::vector<int> order;
+
+    scheduler.spawn([&order]()
+                    {
+                    SimScheduler::sleepFor(seconds(3));
+                    order.push_back(3); });
+    scheduler.spawn([&order]()
+                    {
+                    SimScheduler::sleepFor(seconds(1));
+                    order.push_back(1); });
+
+    auto start = steady_clock::now();
+    scheduler.run();
+
+    REQUIRE(order == std::vector<int>{1, 3});
+    REQUIRE(SimClock::now() == SimClock::time_point(seconds(3)));
+    REQUIRE(steady_clock::now() - start < seconds(1));
+}
+
+TEST_CASE("Same seed gives the same interleaving")
+{
+    auto trace = [](std::uint64_t seed)
+    {
+        SimScheduler scheduler(seed);
+        std::vector<int> order;
+        for (int thread = 0; thread < 3; thread++)
+            scheduler.spawn([&order, thread]()
+                            {
+                            for (int i = 0; i < 5; i++)
+                            {
+                                order.push_back(thread);
+                                SimScheduler::yield();
+                            } });
+        scheduler.run();
+        return order;
+    };
+
+    REQUIRE(trace(42) == trace(42));
+
+    bool differs = false;
+    for (std::uint64_t seed = 0; seed < 10 && !differs; seed++)
+        differs = trace(seed) != trace(42);
+    REQUIRE(differs);
+}
+
+TEST_CASE("Deadlocks are reported instead of hanging")
+{
+    SimScheduler scheduler;
+    Queue<int, SimQueueTraits> queue(1);
+    scheduler.spawn([&queue]()
+                    { queue.pop(); });
+
+    REQUIRE_THROWS_AS(scheduler.run(), std::runtime_error);
+}
@@ -0,0 +1,107 @@
+#include "queue.h"
+#include "stress.h"
+#include "tsc_clock.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+
+namespace
+{
+    struct StressTracedTraits : DefaultQueueTraits
+    {
+        using tracer_type = LockTracer;
+    };
+
+    struct StressResidencyTraits : DefaultQueueTraits
+    {
+        static constexpr bool track_residency = true;
+        using clock_type = TscClock;
+    };
+
+    template <typename QueueT>
+    StressReport stress(QueueT &queue, long expected_lost)
+    {
+        StressConfig config;
+        StressHistory history = runStress(queue, config);
+        StressReport report = checkStressHistory(history, expected_lost);
+        INFO(report.error);
+        CHECK(report.pushed == static_cast<std::size_t>(config.producers) * config.per_producer);
+        return report;
+    }
+}
+
+TEST_CASE("Stress: queue that never overflows loses nothing")
+{
+    Queue<std::uint64_t> queue(4 * 5000);
+    StressReport report = stress(queue, 0);
+    INFO(report.error);
+    REQUIRE(report.ok);
+    REQUIRE(report.lost == 0);
+}
+
+TEST_CASE("Stress: overwriting queue keeps FIFO order")
+{
+    Queue<std::uint64_t> queue(16);
+    StressReport report = stress(queue, -1);
+    INFO(report.error);
+    REQUIRE(report.ok);
+}
+
+TEST_CASE("Stress: overwrites match the elements lost")
+{
+    Queue<std::uint64_t, StressResidencyTraits> queue(16);
+    StressConfig config;
+    StressHistory history = runStress(queue, config);
+    StressReport report = checkStressHistory(history, static_cast<long>(queue.overwrittenResidency().count()));
+    INFO(report.error);
+    REQUIRE(report.ok);
+    REQUIRE(queue.residency().count() == report.popped);
+}
+
+TEST_CASE("Stress: traced queue")
+{
+    LockTracer::clear();
+    Queue<std::uint64_t, StressTracedTraits> queue(64);
+    StressReport report = stress(queue, -1);
+    INFO(report.error);
+    REQUIRE(report.ok);
+    LockTracer::clear();
+}
+
+TEST_CASE("Stress checker detects broken histories")
+{
+    StressHistory history;
+    history.per_producer = 2;
+    history.pushes = {{{0, 0, 1}, {1, 2, 3}}};
+
+    SECTION("duplicate")
+    {
+        history.pops = {{{0, 4, 5}}, {{0, 6, 7}}};
+        REQUIRE(!checkStressHistory(history, -1).ok);
+    }
+
+    SECTION("reordered")
+    {
+        history.pops = {{{1, 4, 5}, {0, 6, 7}}};
+        REQUIRE(!checkStressHistory(history, -1).ok);
+    }
+
+    SECTION("overtaken across consumers")
+    {
+        history.pops = {{{1, 4, 5}}, {{0, 6, 7}}};
+        REQUIRE(!checkStressHistory(history, -1).ok);
+    }
+
+    SECTION("lost without overwrite")
+    {
+        history.pops = {{{0, 4, 5}}};
+        REQUIRE(!checkStressHistory(history, 0).ok);
+        REQUIRE(checkStressHistory(history, 1).ok);
+    }
+
+    SECTION("valid")
+    {
+        history.pops = {{{0, 4, 5}}, {{1, 4, 6}}};
+        REQUIRE(checkStressHistory(history, 0).ok);
+    }
+}
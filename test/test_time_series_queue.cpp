@@ -0,0 +1,97 @@
+#include "time_series_queue.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+    using Series = TimeSeriesQueue<int>;
+
+    Series::time_point at(int ms) { return Series::time_point(milliseconds(ms)); }
+
+    std::vector<int> values(const std::vector<Series::Sample> &samples)
+    {
+        std::vector<int> result;
+        for (const auto &sample : samples)
+            result.push_back(sample.value);
+        return result;
+    }
+}
+
+TEST_CASE("Time series: popUntil removes samples up to a timestamp")
+{
+    Series series(8);
+    for (int t : {10, 20, 20, 30, 40})
+        series.push(at(t), t);
+
+    std::vector<Series::Sample> popped;
+    series.popUntil(at(20), std::back_inserter(popped));
+    REQUIRE(values(popped) == std::vector<int>{10, 20, 20});
+    REQUIRE(popped.front().timestamp == at(10));
+    REQUIRE(series.count() == 2);
+
+    popped.clear();
+    series.popUntil(at(25), std::back_inserter(popped));
+    REQUIRE(popped.empty());
+
+    REQUIRE(series.pop().value == 30);
+}
+
+TEST_CASE("Time series: peekRange across the ring wrap")
+{
+    Series series(4);
+    for (int t = 1; t <= 7; t++)
+        series.push(at(t * 10), t * 10);
+
+    // the ring holds 40..70, stored wrapped around
+    std::vector<Series::Sample> range;
+    series.peekRange(at(45), at(60), std::back_inserter(range));
+    REQUIRE(values(range) == std::vector<int>{50, 60});
+
+    range.clear();
+    series.peekRange(at(0), at(1000), std::back_inserter(range));
+    REQUIRE(values(range) == std::vector<int>{40, 50, 60, 70});
+    REQUIRE(series.count() == 4);
+}
+
+TEST_CASE("Time series: eviction by cutoff and by window")
+{
+    Series series(16);
+    for (int t : {0, 50, 100, 150})
+        series.push(at(t), t);
+
+    REQUIRE(series.evictOlderThan(at(100)) == 2);
+    REQUIRE(series.count() == 2);
+
+    series.setWindow(milliseconds(100));
+    series.push(at(260), 260);
+
+    std::vector<Series::Sample> remaining;
+    series.peekRange(at(0), at(1000), std::back_inserter(remaining));
+    REQUIRE(values(remaining) == std::vector<int>{260});
+}
+
+TEST_CASE("Time series: decreasing timestamps are rejected")
+{
+    Series series(4);
+    series.push(at(10), 1);
+    REQUIRE_THROWS_AS(series.push(at(5), 2), std::invalid_argument);
+    REQUIRE(series.count() == 1);
+}
+
+TEST_CASE("Time series: pop waits for a sample")
+{
+    Series series(4);
+    std::thread writer([&series]()
+                       {
+                       std::this_thread::sleep_for(milliseconds(10));
+                       series.push(3); });
+
+    REQUIRE(series.pop().value == 3);
+    writer.join();
+}
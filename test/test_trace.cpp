@@ -0,0 +1,86 @@
+#include "queue.h"
+#include "sim_scheduler.h"
+#include "trace.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+struct TracedTraits : DefaultQueueTraits
+{
+    using tracer_type = LockTracer;
+};
+
+struct TracedSimTraits : SimQueueTraits
+{
+    using tracer_type = LockTracer;
+};
+
+TEST_CASE("Tracer records lock and wait events")
+{
+    LockTracer::clear();
+    SimScheduler scheduler;
+    Queue<int, TracedSimTraits> queue(4);
+
+    scheduler.spawn([&queue]()
+                    { queue.pop(); });
+    // virtual time only moves once the reader is blocked in pop()
+    scheduler.spawn([&queue]()
+                    {
+                    SimScheduler::sleepFor(std::chrono::seconds(1));
+                    queue.push(1); });
+    scheduler.run();
+
+    // push: acquire, acquired, release; pop: acquire, acquired, wait enter,
+    // wait exit, release
+    REQUIRE(LockTracer::eventCount() == 8);
+
+    std::ostringstream chrome;
+    LockTracer::writeChromeTrace(chrome);
+    std::string json = chrome.str();
+    CHECK(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+    CHECK(json.find("\"lock wait\"") != std::string::npos);
+    CHECK(json.find("\"lock held\"") != std::string::npos);
+    CHECK(json.find("\"cv wait\"") != std::string::npos);
+
+    std::ostringstream perfetto;
+    LockTracer::writePerfettoTrace(perfetto);
+    std::string proto = perfetto.str();
+    REQUIRE(!proto.empty());
+    CHECK(proto[0] == 0x0a); // Trace.packet, length delimited
+    CHECK(proto.find("cv wait") != std::string::npos);
+
+    LockTracer::clear();
+    CHECK(LockTracer::eventCount() == 0);
+}
+
+TEST_CASE("Tracer does not record waits that are not needed")
+{
+    LockTracer::clear();
+    Queue<int, TracedTraits> queue(4);
+    queue.push(1);
+    queue.pop();
+
+    std::ostringstream chrome;
+    LockTracer::writeChromeTrace(chrome);
+    CHECK(LockTracer::eventCount() == 6);
+    CHECK(chrome.str().find("\"cv wait\"") == std::string::npos);
+    LockTracer::clear();
+}
+
+TEST_CASE("Tracer ring clear hides older events without resetting the head")
+{
+    TraceRing ring(4, 0);
+    TraceEvent events[4];
+    for (int i = 0; i < 6; i++)
+        ring.record(nullptr, TraceEventType::LockAcquire);
+    REQUIRE(ring.copy(events) == 4);
+
+    ring.clear();
+    REQUIRE(ring.copy(events) == 0);
+
+    ring.record(nullptr, TraceEventType::WaitEnter);
+    REQUIRE(ring.copy(events) == 1);
+    REQUIRE(events[0].type == TraceEventType::WaitEnter);
+}
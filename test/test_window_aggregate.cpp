@@ -0,0 +1,125 @@
+#include "queue.h"
+#include "window_aggregate.h"
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <random>
+
+struct AggregateTraits : DefaultQueueTraits
+{
+    template <typename T>
+    using observer_type = WindowAggregate<T>;
+};
+
+TEST_CASE("Window aggregate follows push, pop and overwrite")
+{
+    Queue<int, AggregateTraits> queue(3);
+    auto stats = [&queue]()
+    { return queue.observe([](const WindowAggregate<int> &a)
+                           { return a.snapshot(); }); };
+
+    REQUIRE(stats().count == 0);
+    REQUIRE(stats().mean == 0.0);
+
+    for (int element : {5, 1, 9})
+        queue.push(element);
+    REQUIRE(stats().count == 3);
+    REQUIRE(stats().sum == 15);
+    REQUIRE(stats().min == 1);
+    REQUIRE(stats().max == 9);
+
+    queue.push(4); // overwrites 5
+    REQUIRE(stats().sum == 14);
+    REQUIRE(stats().min == 1);
+
+    queue.pop(); // removes 1
+    REQUIRE(stats().count == 2);
+    REQUIRE(stats().min == 4);
+    REQUIRE(stats().max == 9);
+    REQUIRE(stats().mean == 6.5);
+}
+
+TEST_CASE("Window aggregate matches a full scan under random operations")
+{
+    std::mt19937 random(7);
+    Queue<int, AggregateTraits> queue(16);
+    std::deque<int> model;
+
+    for (int step = 0; step < 20000; step++)
+    {
+        if (random() % 3 != 0 || model.empty())
+        {
+            int value = static_cast<int>(random() % 50) - 25;
+            queue.push(value);
+            model.push_back(value);
+            if (model.size() > 16)
+                model.pop_front();
+        }
+        else
+        {
+            REQUIRE(queue.pop() == model.front());
+            model.pop_front();
+        }
+
+        auto snapshot = queue.observe([](const WindowAggregate<int> &a)
+                                      { return a.snapshot(); });
+        REQUIRE(snapshot.count == static_cast<int>(model.size()));
+        REQUIRE(snapshot.sum == std::accumulate(model.begin(), model.end(), 0LL));
+        if (!model.empty())
+        {
+            REQUIRE(snapshot.min == *std::min_element(model.begin(), model.end()));
+            REQUIRE(snapshot.max == *std::max_element(model.begin(), model.end()));
+        }
+    }
+}
+
+TEST_CASE("Window aggregate sum does not keep the error of elements that left")
+{
+    Queue<double, AggregateTraits> queue(4);
+    auto sum = [&queue]()
+    { return queue.observe([](const WindowAggregate<double> &a)
+                           { return a.sum(); }); };
+
+    // 1e16 + 1 rounds away the 1, a running sum would be off by that forever
+    queue.push(1e16);
+    for (int i = 0; i < 1000; i++)
+        queue.push(1.0);
+
+    REQUIRE(sum() == 4.0);
+    for (int i = 0; i < 1000; i++)
+    {
+        queue.push(0.1);
+        queue.pop();
+    }
+    REQUIRE(sum() == 0.1 + 0.1 + 0.1);
+}
+
+TEST_CASE("Window aggregate ignores NaN for min and max")
+{
+    Queue<double, AggregateTraits> queue(3);
+    auto stats = [&queue]()
+    { return queue.observe([](const WindowAggregate<double> &a)
+                           { return a.snapshot(); }); };
+
+    for (double element : {2.0, std::nan(""), 5.0})
+        queue.push(element);
+    REQUIRE(stats().min == 2.0);
+    REQUIRE(stats().max == 5.0);
+    REQUIRE(std::isnan(stats().sum));
+
+    queue.pop(); // 2
+    REQUIRE(stats().min == 5.0);
+    queue.pop(); // NaN
+    REQUIRE(stats().min == 5.0);
+    REQUIRE(stats().max == 5.0);
+
+    // the NaN's epoch drains with the last element queued before it left
+    queue.push(1.0);
+    queue.pop(); // 5
+    REQUIRE(stats().sum == 1.0);
+    REQUIRE(stats().min == 1.0);
+    REQUIRE(stats().max == 1.0);
+}
@@ -0,0 +1,382 @@
+#include "compare_stats.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Compares two benchmark result files in the Google Benchmark JSON format,
+ * as written by the load generator and wakeup_bench with --json.
+ *
+ * Entries are grouped into cases by run_name; every iteration entry of a
+ * case is one sample (use --repetitions to get several). Aggregate entries
+ * (mean, median, stddev) are ignored. For each case present in both files
+ * the tool prints the medians, the relative change of the median with a
+ * bootstrap confidence interval and the Mann-Whitney p-value. A case is a
+ * regression when the change is significant (p below --alpha and the
+ * interval excludes zero) and worse than --threshold percent.
+ *
+ * Exit status: 0 no regression, 1 regression found, 2 usage or input error.
+ *
+ * usage: bench_compare BASELINE CANDIDATE [--metric NAME] [--threshold PCT]
+ *                      [--alpha P] [--higher-is-better]
+ */
+
+namespace
+{
+    struct Options
+    {
+        std::string baseline;
+        std::string candidate;
+        std::string metric = "real_time";
+        double threshold = 5.0;
+        double alpha = 0.05;
+        bool higher_is_better = false;
+    };
+
+    /**
+     * @brief A parsed JSON value. Numbers keep their text.
+     */
+    struct JsonValue
+    {
+        enum Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        Type type = Null;
+        std::string text;
+        std::vector<JsonValue> items;
+        std::vector<std::pair<std::string, JsonValue>> members;
+
+        const JsonValue *find(const std::string &key) const
+        {
+            for (const auto &member : members)
+                if (member.first == key)
+                    return &member.second;
+            return nullptr;
+        }
+    };
+
+    /**
+     * @brief Recursive-descent JSON parser, enough for benchmark output.
+     */
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string &text) : m_text(text), m_pos() {}
+
+        JsonValue parse()
+        {
+            JsonValue value = parseValue();
+            skipSpace();
+            if (m_pos != m_text.size())
+                fail("trailing characters");
+            return value;
+        }
+
+    private:
+        JsonValue parseValue()
+        {
+            skipSpace();
+            if (m_pos >= m_text.size())
+                fail("unexpected end");
+
+            JsonValue value;
+            char c = m_text[m_pos];
+            if (c == '{')
+            {
+                value.type = JsonValue::Object;
+                m_pos++;
+                if (consume('}'))
+                    return value;
+                do
+                {
+                    skipSpace();
+                    std::string key = parseString();
+                    skipSpace();
+                    expect(':');
+                    value.members.emplace_back(key, parseValue());
+                    skipSpace();
+                } while (consume(','));
+                expect('}');
+            }
+            else if (c == '[')
+            {
+                value.type = JsonValue::Array;
+                m_pos++;
+                if (consume(']'))
+                    return value;
+                do
+                {
+                    value.items.push_back(parseValue());
+                    skipSpace();
+                } while (consume(','));
+                expect(']');
+            }
+            else if (c == '"')
+            {
+                value.type = JsonValue::String;
+                value.text = parseString();
+            }
+            else if (literal("true") || literal("false"))
+                value.type = JsonValue::Bool;
+            else if (literal("null"))
+                value.type = JsonValue::Null;
+            else
+            {
+                std::size_t start = m_pos;
+                while (m_pos < m_text.size() && std::string("+-.eE0123456789").find(m_text[m_pos]) != std::string::npos)
+                    m_pos++;
+                if (m_pos == start)
+                    fail("unexpected character");
+                value.type = JsonValue::Number;
+                value.text = m_text.substr(start, m_pos - start);
+            }
+            return value;
+        }
+
+        std::string parseString()
+        {
+            expect('"');
+            std::string out;
+            while (m_pos < m_text.size() && m_text[m_pos] != '"')
+            {
+                char c = m_text[m_pos++];
+                if (c == '\\' && m_pos < m_text.size())
+                {
+                    char escaped = m_text[m_pos++];
+                    switch (escaped)
+                    {
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    case 'u':
+                        // names are ASCII, keep the escape as is
+                        out += "\\u";
+                        continue;
+                    default:
+                        c = escaped;
+                    }
+                }
+                out += c;
+            }
+            expect('"');
+            return out;
+        }
+
+        bool literal(const char *word)
+        {
+            std::string w(word);
+            if (m_text.compare(m_pos, w.size(), w) != 0)
+                return false;
+            m_pos += w.size();
+            return true;
+        }
+
+        void skipSpace()
+        {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+                m_pos++;
+        }
+
+        bool consume(char c)
+        {
+            skipSpace();
+            if (m_pos < m_text.size() && m_text[m_pos] == c)
+            {
+                m_pos++;
+                return true;
+            }
+            return false;
+        }
+
+        void expect(char c)
+        {
+            if (!consume(c))
+                fail(std::string("expected '") + c + "'");
+        }
+
+        [[noreturn]] void fail(const std::string &what)
+        {
+            throw std::invalid_argument("JSON: " + what + " at offset " + std::to_string(m_pos));
+        }
+
+        const std::string &m_text; /**< Document */
+        std::size_t m_pos;         /**< Parse position */
+    };
+
+    /**
+     * @brief Samples of the metric per case, in file order of first appearance.
+     */
+    struct Cases
+    {
+        std::vector<std::string> order;
+        std::map<std::string, std::vector<double>> samples;
+    };
+
+    Cases load(const std::string &path, const std::string &metric)
+    {
+        std::ifstream in(path);
+        if (!in)
+            throw std::invalid_argument(path + ": cannot open");
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        std::string text = buffer.str();
+
+        JsonValue root = JsonParser(text).parse();
+        const JsonValue *benchmarks = root.find("benchmarks");
+        if (benchmarks == nullptr || benchmarks->type != JsonValue::Array)
+            throw std::invalid_argument(path + ": no \"benchmarks\" array");
+
+        Cases cases;
+        for (const JsonValue &entry : benchmarks->items)
+        {
+            const JsonValue *run_type = entry.find("run_type");
+            if (run_type != nullptr && run_type->text == "aggregate")
+                continue;
+
+            const JsonValue *name = entry.find("run_name");
+            if (name == nullptr)
+                name = entry.find("name");
+            const JsonValue *value = entry.find(metric);
+            if (name == nullptr || value == nullptr || value->type != JsonValue::Number)
+                continue;
+
+            auto it = cases.samples.find(name->text);
+            if (it == cases.samples.end())
+            {
+                cases.order.push_back(name->text);
+                it = cases.samples.emplace(name->text, std::vector<double>()).first;
+            }
+            it->second.push_back(std::strtod(value->text.c_str(), nullptr));
+        }
+        return cases;
+    }
+
+    void usage()
+    {
+        std::fprintf(stderr, "usage: bench_compare BASELINE CANDIDATE [--metric NAME] [--threshold PCT]\n"
+                             "                     [--alpha P] [--higher-is-better]\n");
+        std::exit(2);
+    }
+
+    Options parse(int argc, char **argv)
+    {
+        Options options;
+        std::vector<std::string> files;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--metric" && i + 1 < argc)
+                options.metric = argv[++i];
+            else if (arg == "--threshold" && i + 1 < argc)
+                options.threshold = std::atof(argv[++i]);
+            else if (arg == "--alpha" && i + 1 < argc)
+                options.alpha = std::atof(argv[++i]);
+            else if (arg == "--higher-is-better")
+                options.higher_is_better = true;
+            else if (!arg.empty() && arg[0] != '-')
+                files.push_back(arg);
+            else
+                usage();
+        }
+        if (files.size() != 2 || options.threshold < 0 || options.alpha <= 0 || options.alpha >= 1)
+            usage();
+
+        options.baseline = files[0];
+        options.candidate = files[1];
+        // throughput metrics grow when things get better
+        if (options.metric.find("per_second") != std::string::npos)
+            options.higher_is_better = true;
+        return options;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options = parse(argc, argv);
+
+    Cases baseline;
+    Cases candidate;
+    try
+    {
+        baseline = load(options.baseline, options.metric);
+        candidate = load(options.candidate, options.metric);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "bench_compare: %s\n", e.what());
+        return 2;
+    }
+
+    std::printf("metric %s (%s is better), threshold %.1f%%, alpha %.3f\n", options.metric.c_str(),
+                options.higher_is_better ? "higher" : "lower", options.threshold, options.alpha);
+    std::printf("%-40s %5s %5s %12s %12s %8s %19s %8s  %s\n", "case", "n old", "n new", "median old", "median new",
+                "change", "95% interval", "p", "verdict");
+
+    int regressions = 0;
+    for (const std::string &name : baseline.order)
+    {
+        auto found = candidate.samples.find(name);
+        if (found == candidate.samples.end())
+        {
+            std::printf("%-40s only in baseline\n", name.c_str());
+            continue;
+        }
+
+        const std::vector<double> &old_samples = baseline.samples[name];
+        const std::vector<double> &new_samples = found->second;
+        double old_median = median(old_samples);
+        double new_median = median(new_samples);
+        if (old_median == 0)
+        {
+            std::printf("%-40s baseline median is 0, skipped\n", name.c_str());
+            continue;
+        }
+
+        double change = new_median / old_median - 1;
+        Interval interval = bootstrapChange(old_samples, new_samples);
+        MannWhitney test = mannWhitneyU(old_samples, new_samples);
+
+        // worse means slower for times, fewer for throughputs
+        bool worse = options.higher_is_better ? change < 0 : change > 0;
+        bool significant = test.p_value < options.alpha && (interval.low > 0 || interval.high < 0);
+        const char *verdict = "no change";
+        if (old_samples.size() < 3 || new_samples.size() < 3)
+            verdict = "too few samples";
+        else if (significant && std::fabs(change) * 100 > options.threshold)
+        {
+            verdict = worse ? "REGRESSION" : "improvement";
+            if (worse)
+                regressions++;
+        }
+        else if (significant)
+            verdict = "within threshold";
+
+        std::printf("%-40s %5zu %5zu %12.1f %12.1f %+7.1f%% [%+7.1f%%, %+7.1f%%] %8.4f  %s\n", name.c_str(),
+                    old_samples.size(), new_samples.size(), old_median, new_median, change * 100, interval.low * 100,
+                    interval.high * 100, test.p_value, verdict);
+    }
+
+    for (const std::string &name : candidate.order)
+        if (baseline.samples.find(name) == baseline.samples.end())
+            std::printf("%-40s only in candidate\n", name.c_str());
+
+    return regressions > 0 ? 1 : 0;
+}
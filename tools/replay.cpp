@@ -0,0 +1,245 @@
+#include "compressed_queue.h"
+#include "histogram.h"
+#include "queue.h"
+#include "record.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/*
+ * Replays a log written by OpRecorder against a queue implementation.
+ *
+ * Every recorded thread becomes a replay thread issuing the same pushes and
+ * pops at the same offsets from the start of the capture (scaled by
+ * --speed). Overwrites are replayed as pushes, the queue under test decides
+ * whether they evict. Pops wait at most --pop-timeout milliseconds so that a
+ * queue behaving differently from the recorded one cannot hang the replay,
+ * and do not wait at all once every pushing thread is done.
+ *
+ * usage: replay LOG [--queue N] [--variant queue|compressed] [--capacity N]
+ *               [--speed X] [--pop-timeout MS]
+ */
+
+namespace
+{
+    struct Options
+    {
+        std::string log;
+        long long queue = -1;
+        std::string variant = "queue";
+        int capacity = 0;
+        double speed = 1.0;
+        int pop_timeout = 100;
+    };
+
+    struct Result
+    {
+        LatencyHistogram push_latency;
+        LatencyHistogram pop_latency;
+        LatencyHistogram lag;
+        std::uint64_t timeouts = 0;
+        double elapsed = 0;
+    };
+
+    void usage()
+    {
+        std::fprintf(stderr, "usage: replay LOG [--queue N] [--variant queue|compressed] [--capacity N]\n"
+                             "              [--speed X] [--pop-timeout MS]\n");
+        std::exit(2);
+    }
+
+    Options parse(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto value = [&]() -> const char *
+            {
+                if (i + 1 >= argc)
+                    usage();
+                return argv[++i];
+            };
+
+            if (arg == "--queue")
+                options.queue = std::atoll(value());
+            else if (arg == "--variant")
+                options.variant = value();
+            else if (arg == "--capacity")
+                options.capacity = std::atoi(value());
+            else if (arg == "--speed")
+                options.speed = std::atof(value());
+            else if (arg == "--pop-timeout")
+                options.pop_timeout = std::atoi(value());
+            else if (arg.compare(0, 2, "--") == 0 || !options.log.empty())
+                usage();
+            else
+                options.log = arg;
+        }
+        if (options.log.empty() || options.speed < 0)
+            usage();
+        return options;
+    }
+
+    /**
+     * @brief Replays the records of one queue, grouped per recorded thread.
+     *
+     * Recorded payloads are pushed as their raw 64-bit value, elements
+     * recorded without payload as a per-thread sequence number.
+     */
+    template <typename QueueT>
+    void replay(QueueT &queue, const std::map<std::uint32_t, std::vector<OpRecord>> &threads,
+                std::uint64_t origin, const Options &options, Result &result)
+    {
+        using clock = std::chrono::steady_clock;
+        std::atomic<std::uint64_t> timeouts{0};
+        std::atomic<int> pushers{0};
+        std::vector<std::thread> workers;
+        clock::time_point start = clock::now() + std::chrono::milliseconds(10);
+
+        for (const auto &thread : threads)
+            if (std::any_of(thread.second.begin(), thread.second.end(), [](const OpRecord &op)
+                            { return op.op != RecordOp::Pop; }))
+                pushers++;
+
+        for (const auto &thread : threads)
+        {
+            const std::vector<OpRecord> &ops = thread.second;
+            workers.emplace_back([&, ops]()
+                                 {
+                std::uint64_t sequence = 0;
+                for (const OpRecord &op : ops)
+                {
+                    clock::time_point due = start;
+                    if (options.speed > 0)
+                        due += std::chrono::nanoseconds(static_cast<long long>((op.timestamp - origin) / options.speed));
+                    std::this_thread::sleep_until(due);
+
+                    clock::time_point begin = clock::now();
+                    result.lag.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(begin - due).count()));
+                    if (op.op == RecordOp::Pop)
+                    {
+                        try
+                        {
+                            // once nothing can be pushed any more, waiting is pointless
+                            queue.popWithTimeout(pushers.load() == 0 ? 0 : options.pop_timeout);
+                        }
+                        catch (const std::system_error &)
+                        {
+                            timeouts.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                    }
+                    else
+                        queue.push(op.payload_size != 0 ? op.payload : sequence++);
+
+                    auto took = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin).count());
+                    (op.op == RecordOp::Pop ? result.pop_latency : result.push_latency).record(took);
+                }
+                if (std::any_of(ops.begin(), ops.end(), [](const OpRecord &op)
+                                { return op.op != RecordOp::Pop; }))
+                    pushers--; });
+        }
+
+        for (auto &worker : workers)
+            worker.join();
+        result.elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        result.timeouts = timeouts.load();
+    }
+
+    void printHistogram(const char *name, const LatencyHistogram &histogram)
+    {
+        std::printf("%-12s %10llu ops  p50 %9llu ns  p99 %9llu ns  p99.9 %9llu ns  max %9llu ns\n", name,
+                    static_cast<unsigned long long>(histogram.count()),
+                    static_cast<unsigned long long>(histogram.percentile(0.5)),
+                    static_cast<unsigned long long>(histogram.percentile(0.99)),
+                    static_cast<unsigned long long>(histogram.percentile(0.999)),
+                    static_cast<unsigned long long>(histogram.max()));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options = parse(argc, argv);
+
+    std::vector<OpRecord> records;
+    try
+    {
+        records = OpRecorder::readLog(options.log);
+    }
+    catch (const std::exception &e)
+    {
+        std::fprintf(stderr, "replay: %s\n", e.what());
+        return 1;
+    }
+
+    // default to the busiest queue of the capture
+    std::map<std::uint64_t, std::size_t> per_queue;
+    for (const OpRecord &record : records)
+        per_queue[record.queue]++;
+    if (per_queue.empty())
+    {
+        std::fprintf(stderr, "replay: %s holds no operations\n", options.log.c_str());
+        return 1;
+    }
+    if (options.queue < 0)
+        options.queue = static_cast<long long>(std::max_element(per_queue.begin(), per_queue.end(), [](const auto &a, const auto &b)
+                                                                { return a.second < b.second; })
+                                                   ->first);
+
+    std::map<std::uint32_t, std::vector<OpRecord>> threads;
+    std::uint64_t origin = 0;
+    std::uint32_t max_depth = 1;
+    for (const OpRecord &record : records)
+    {
+        if (record.queue != static_cast<std::uint64_t>(options.queue))
+            continue;
+        if (threads.empty() || record.timestamp < origin)
+            origin = record.timestamp;
+        threads[record.thread].push_back(record);
+        max_depth = std::max(max_depth, record.depth);
+    }
+    if (threads.empty())
+    {
+        std::fprintf(stderr, "replay: queue %lld not found in %s\n", options.queue, options.log.c_str());
+        return 1;
+    }
+    if (options.capacity <= 0)
+        options.capacity = static_cast<int>(max_depth);
+
+    Result result;
+    if (options.variant == "queue")
+    {
+        Queue<std::uint64_t> queue(options.capacity);
+        replay(queue, threads, origin, options, result);
+    }
+    else if (options.variant == "compressed")
+    {
+        CompressedQueue<std::uint64_t> queue(options.capacity);
+        replay(queue, threads, origin, options, result);
+    }
+    else
+        usage();
+
+    std::size_t total = 0;
+    for (const auto &thread : threads)
+        total += thread.second.size();
+    std::printf("replayed %zu operations of queue %lld on %zu threads, variant %s, capacity %d\n", total,
+                options.queue, threads.size(), options.variant.c_str(), options.capacity);
+    std::printf("elapsed %.3f s, %.0f ops/s, %llu pop timeouts\n", result.elapsed, total / result.elapsed,
+                static_cast<unsigned long long>(result.timeouts));
+    printHistogram("push", result.push_latency);
+    printHistogram("pop", result.pop_latency);
+    printHistogram("start lag", result.lag);
+    return 0;
+}